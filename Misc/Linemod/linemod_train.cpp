@@ -39,7 +39,19 @@
 #include <vector>
 #include <set>
 #include <cmath>
+#include <cstdint>
+#include <sstream>
+#include <algorithm>
+#include <map>
+#include <memory>
+#include <thread>
 #include <unordered_set>
+#include <cerrno>
+#include <cstring>
+#include <sys/types.h>
+#include <signal.h>
+#include <sys/wait.h>
+#include <unistd.h>
 
 #include <boost/filesystem.hpp>
 
@@ -68,7 +80,155 @@ double renderer_radius_step_;
 double renderer_near_;
 double renderer_far_;
 
-void trainObject(const boost::filesystem::path& trainDir, const std::string& object_id_, const Camera::CameraModel& cam)
+/** Trainings are reused as long as everything they are made from is the same: the files of the object (mesh, textures,
+ * model.yml), the detector, the camera and the rendering parameters. They are then extended when new radii are asked for.
+ */
+namespace{
+  /** To be increased whenever templates are made differently, so that older trainings aren't reused */
+  const int TRAINING_FORMAT=1;
+
+  /** 64 bit FNV-1a: unlike std::hash it is the same on every run and platform, so it can be stored */
+  class ContentHash{
+    public:
+      ContentHash()
+        :
+          _h(14695981039346656037ULL)
+      {
+      }
+
+      void add(const void* data, size_t size){
+        const unsigned char* bytes=static_cast<const unsigned char*>(data);
+        for(size_t i=0; i<size; ++i){
+          _h=(_h^bytes[i])*1099511628211ULL;
+        }
+      }
+
+      /** Length first, so that consecutive strings can't be confused */
+      void add(const std::string& s){
+        uint64_t size=s.size();
+        add(&size, sizeof(size));
+        add(s.data(), s.size());
+      }
+
+      template<typename T>
+      void addValue(const T& x){
+        std::ostringstream s;
+        s.precision(17);
+        s << x;
+        add(s.str());
+      }
+
+      void addFile(const boost::filesystem::path& file){
+        std::ifstream in(file.string(), std::ios::binary);
+        char buffer[1<<16];
+        while(in.read(buffer, sizeof(buffer)) || in.gcount()>0){
+          add(buffer, in.gcount());
+        }
+      }
+
+      std::string hex() const {
+        char out[17];
+        snprintf(out, sizeof(out), "%016llx", static_cast<unsigned long long>(_h));
+        return out;
+      }
+
+    private:
+      uint64_t _h;
+  };
+
+  boost::filesystem::path linemodFile(const boost::filesystem::path& trainDir, const std::string& objectId){
+    return trainDir / objectId / (objectId+"_Linemod.yml");
+  }
+
+  /** What the training on disk has been made from: it is only written once the training is complete */
+  boost::filesystem::path stampFile(const boost::filesystem::path& trainDir, const std::string& objectId){
+    return trainDir / objectId / (objectId+"_TrainingStamp.yml");
+  }
+
+  /** Everything but the radius range, which is stored apart so that it can grow */
+  std::string trainingKey(const boost::filesystem::path& trainDir, const std::string& objectId, const std::string& detType, const Camera::CameraModel& cam){
+    namespace fs=boost::filesystem;
+    ContentHash h;
+    h.addValue(TRAINING_FORMAT);
+    h.add(detType);
+    h.addValue(renderer_n_points_);
+    h.addValue(renderer_n_turns);
+    h.addValue(renderer_radius_step_);
+
+    cv::FileStorage camera(".yml", cv::FileStorage::WRITE+cv::FileStorage::MEMORY);
+    camera << "camera_model" << cam;
+    h.add(camera.releaseAndGetString());
+
+    /** The output of the training is into the same directory */
+    const fs::path objectDir=trainDir / objectId;
+    std::vector<fs::path> files;
+    for(fs::recursive_directory_iterator it(objectDir), end; it!=end; ++it){
+      if(fs::is_regular_file(it->status()) && it->path()!=linemodFile(trainDir, objectId) && it->path()!=stampFile(trainDir, objectId)){
+        files.push_back(it->path());
+      }
+    }
+    std::sort(files.begin(), files.end());
+    for(const auto& f : files){
+      h.add(f.string().substr(objectDir.string().size()));
+      h.addFile(f);
+    }
+    return h.hex();
+  }
+
+  std::vector<double> trainingRadii(){
+    std::vector<double> radii;
+    for(int i=0; renderer_radius_min_+i*renderer_radius_step_<=renderer_radius_max_+1e-9; ++i){
+      radii.push_back(renderer_radius_min_+i*renderer_radius_step_);
+    }
+    return radii;
+  }
+
+  bool containsRadius(const std::vector<double>& radii, double r){
+    return std::any_of(radii.begin(), radii.end(), [r] (double x) { return std::fabs(x-r)<1e-6; });
+  }
+
+  bool readStamp(const boost::filesystem::path& file, std::string& key, std::vector<double>& radii){
+    if(!boost::filesystem::exists(file)){
+      return false;
+    }
+    cv::FileStorage in(file.string(), cv::FileStorage::READ);
+    if(!in.isOpened()){
+      return false;
+    }
+    in["key"] >> key;
+    radii.clear();
+    for(const auto& r : in["radii"]){
+      radii.push_back(double(r));
+    }
+    return !key.empty();
+  }
+
+  void writeStamp(const boost::filesystem::path& file, const std::string& key, const std::vector<double>& radii){
+    cv::FileStorage out(file.string(), cv::FileStorage::WRITE);
+    out << "key" << key;
+    out << "radii" << "[";
+    for(double r : radii){
+      out << r;
+    }
+    out << "]";
+  }
+}
+
+/** What is left to do to train an object */
+struct TrainingPlan{
+  std::string id;
+  std::string meshPath;
+  std::string detType;
+  std::string key;
+  /** All the radii of the training, and those which still have to be rendered */
+  std::vector<double> radii;
+  std::vector<double> toRender;
+  /** The training on disk is extended with the new radii */
+  bool extend;
+};
+
+/** Returns false if the training of the object is up to date */
+bool planTraining(const boost::filesystem::path& trainDir, const std::string& object_id_, const Camera::CameraModel& cam, TrainingPlan& plan)
 { 
   using boost::filesystem::path;
   path p=trainDir / path(object_id_);
@@ -96,31 +256,70 @@ void trainObject(const boost::filesystem::path& trainDir, const std::string& obj
   path mesh_path = p / path(meshName);
   std::cout<< "Mesh filename: " << mesh_path.string() << "\n";
 
-  Recognition::Model model(object_id_, mesh_path.string(), cam, detType);
+  plan.id=object_id_;
+  plan.meshPath=mesh_path.string();
+  plan.detType=detType;
+  plan.key=trainingKey(trainDir, object_id_, detType, cam);
+  plan.radii=trainingRadii();
+  plan.toRender=plan.radii;
+  plan.extend=false;
+  {
+    std::string trainedKey;
+    std::vector<double> trained;
+    if(readStamp(stampFile(trainDir, object_id_), trainedKey, trained) && trainedKey==plan.key && exists(linemodFile(trainDir, object_id_))){
+      /** Templates can be added to a training but not taken away: if the range shrank, everything is done again */
+      const auto& radii=plan.radii;
+      if(std::all_of(trained.begin(), trained.end(), [&radii] (double r) { return containsRadius(radii, r); })){
+        plan.toRender.erase(std::remove_if(plan.toRender.begin(), plan.toRender.end(), [&trained] (double r) { return containsRadius(trained, r); }), plan.toRender.end());
+        if(plan.toRender.empty()){
+          std::cout << object_id_ << " is up to date (" << plan.key << "), skipped\n";
+          return false;
+        }
+        plan.extend=true;
+        std::cout << "Extending the training with " << plan.toRender.size() << " new radii out of " << plan.radii.size() << "\n";
+      }
+    }
+  }
+  /** Until the new training is complete, the one on disk can't be trusted */
+  boost::filesystem::remove(stampFile(trainDir, object_id_));
+  return true;
+}
 
+/** The views to render, one after the other: radius, then point of view, then turn around it */
+long countViews(const TrainingPlan& plan){
+  return long(plan.toRender.size())*Recognition::SphereSplitter(renderer_n_points_).points().size()*renderer_n_turns;
+}
+
+/** Adds the templates of the views in [first, last) to the model, in order; interactive shows the progress (and the views, if asked) */
+void renderViews(Recognition::Model& model, const TrainingPlan& plan, const Camera::CameraModel& cam, long first, long last, bool interactive)
+{
   auto myPts=Recognition::SphereSplitter(renderer_n_points_).points();
   /** Takes snapshots of the (ideal) object */
-  long totalTemplates=(renderer_radius_max_-renderer_radius_min_)/renderer_radius_step_+1;
-  totalTemplates*=myPts.size();
-  totalTemplates*=renderer_n_turns;
-  long i=0; 
+  long totalTemplates=last-first;
+  long view=0;
   long done=0;
   //std::unordered_set<long> tuanonna;
   
-  std::cout << "Training model with detector: " << detType << "\n";
-  std::cout << "Requested UV sphere points: "<< renderer_n_points_ << ", total UV sphere points:" << myPts.size() << "\n";
-  std::cout << "Loading images ";
+  if(interactive){
+    std::cout << "Training model with detector: " << plan.detType << "\n";
+    std::cout << "Requested UV sphere points: "<< renderer_n_points_ << ", total UV sphere points:" << myPts.size() << "\n";
+    std::cout << "Loading images ";
+  }
   cv::Mat image2show(cam.getHeight(), cam.getWidth(), CV_8UC3);
   cv::Mat depth2show(cam.getHeight(), cam.getWidth(), CV_16U);
-  for (double radius=renderer_radius_min_; radius<=renderer_radius_max_; radius+=renderer_radius_step_)
+  for (double radius : plan.toRender)
   {
     for(const auto& p:myPts){
-      for(int k=0; k<renderer_n_turns; ++k){
-            i++;
+      for(int k=0; k<renderer_n_turns; ++k, ++view){
+            if(view<first || view>=last){
+              continue;
+            }
             done++;
             std::stringstream status;
-            status << (i) << "/" << totalTemplates;
-            std::cout << status.str();
+            if(interactive){
+              status << done << "/" << totalTemplates;
+              std::cout << status.str();
+            }
 
             /** 
              * Cross product == double perpendicularity == longitude == arrr me gusta 
@@ -142,6 +341,9 @@ void trainObject(const boost::filesystem::path& trainDir, const std::string& obj
            // }
             Eigen::Matrix3d transformation = Recognition::tUpToCameraWorldTransform(p, up).rotation().matrix();
             model.addTraining(transformation,radius, cam);
+            if(!interactive){
+              continue;
+            }
             if((!(done % nViz_ )) && visualize_){
               image2show.setTo(cv::Scalar(0,0,0));
               depth2show.setTo(cv::Scalar(0,0,0));
@@ -160,8 +362,6 @@ void trainObject(const boost::filesystem::path& trainDir, const std::string& obj
               }
             }
 
-
-
             // Delete the status
             for (size_t j = 0; j < status.str().size(); ++j) {
               std::cout << '\b';
@@ -169,6 +369,24 @@ void trainObject(const boost::filesystem::path& trainDir, const std::string& obj
       }
     }
   }
+}
+
+void trainObject(const boost::filesystem::path& trainDir, const std::string& object_id_, const Camera::CameraModel& cam)
+{
+  TrainingPlan plan;
+  if(!planTraining(trainDir, object_id_, cam, plan)){
+    return;
+  }
+
+  std::unique_ptr<Recognition::Model> trainedModel;
+  if(plan.extend){
+    trainedModel.reset(new Recognition::Model(object_id_, trainDir));
+  }
+  else{
+    trainedModel.reset(new Recognition::Model(object_id_, plan.meshPath, cam, plan.detType));
+  }
+  Recognition::Model& model=*trainedModel;
+  renderViews(model, plan, cam, 0, countViews(plan), true);
 
   //write the template + R + t + dist + K for each class
   model.saveToDirectory(trainDir);
@@ -192,9 +410,148 @@ void trainObject(const boost::filesystem::path& trainDir, const std::string& obj
       std::cout << "Done.\n";
     }
   }
+  writeStamp(stampFile(trainDir, object_id_), plan.key, plan.radii);
   std::cout << "Success!\n";
 }
 
+/** Training of the whole catalogue split into shards of consecutive views, each rendered by a worker process with its own
+ * GLUT context; the shards of an object are merged as soon as all of them are done, in order, so that template IDs and
+ * data are the same as if the object had been trained by a single process.
+ * This process never renders anything: it must not have a GLUT context of its own, which the workers would share.
+ */
+namespace{
+  struct Shard{
+    size_t plan;
+    int index;
+    long first;
+    long last;
+  };
+
+  boost::filesystem::path shardDir(const boost::filesystem::path& trainDir, const std::string& objectId, int index){
+    return trainDir / ("shards_"+objectId) / std::to_string(index);
+  }
+
+  /** Runs into the worker process */
+  int trainShard(const boost::filesystem::path& trainDir, const TrainingPlan& plan, const Shard& shard, const Camera::CameraModel& cam){
+    try{
+      const boost::filesystem::path dir=shardDir(trainDir, plan.id, shard.index);
+      boost::filesystem::create_directories(dir / plan.id);
+      Recognition::Model model(plan.id, plan.meshPath, cam, plan.detType);
+      renderViews(model, plan, cam, shard.first, shard.last, false);
+      /** A shard may have no visible view: it is then left out of the merge */
+      if(model.numTemplates()>0){
+        model.saveToDirectory(dir);
+      }
+      return 0;
+    }
+    catch(const std::exception& e){
+      std::cerr << "Shard " << shard.index << " of " << plan.id << " failed: " << e.what() << "\n";
+      return 1;
+    }
+  }
+
+  int mergeShards(const boost::filesystem::path& trainDir, const TrainingPlan& plan, int nShards){
+    std::vector<boost::filesystem::path> parts;
+    if(plan.extend){
+      parts.push_back(trainDir);
+    }
+    for(int i=0; i<nShards; ++i){
+      parts.push_back(shardDir(trainDir, plan.id, i));
+    }
+    try{
+      int n=Recognition::Model::mergeTrainings(plan.id, parts, trainDir);
+      boost::filesystem::remove_all(trainDir / ("shards_"+plan.id));
+      writeStamp(stampFile(trainDir, plan.id), plan.key, plan.radii);
+      std::cout << plan.id << ": " << n << " templates\n";
+      return 0;
+    }
+    catch(const std::exception& e){
+      std::cerr << "Could not merge the shards of " << plan.id << ": " << e.what() << "\n";
+      return 1;
+    }
+  }
+}
+
+int trainCatalogue(const boost::filesystem::path& trainDir, const std::vector<std::string>& objects, const Camera::CameraModel& cam, int nProcesses)
+{
+  std::vector<TrainingPlan> plans;
+  for(const auto& id : objects){
+    TrainingPlan plan;
+    if(planTraining(trainDir, id, cam, plan)){
+      plans.push_back(plan);
+    }
+  }
+
+  /** As many shards per object as processes, so that even a single object keeps all of them busy */
+  std::vector<Shard> shards;
+  std::vector<int> shardsLeft(plans.size());
+  for(size_t i=0; i<plans.size(); ++i){
+    boost::filesystem::remove_all(trainDir / ("shards_"+plans[i].id));
+    const long views=countViews(plans[i]);
+    const int n=int(std::max(1L, std::min<long>(nProcesses, views)));
+    for(int s=0; s<n; ++s){
+      shards.push_back(Shard{i, s, views*s/n, views*(s+1)/n});
+    }
+    shardsLeft[i]=n;
+  }
+
+  int failures=0;
+  std::vector<bool> failed(plans.size(), false);
+  std::map<pid_t, Shard> running;
+  size_t next=0;
+  while(next<shards.size() || !running.empty()){
+    while(next<shards.size() && int(running.size())<nProcesses){
+      const Shard& shard=shards[next++];
+      /** Anything still buffered would be written again by the worker, e.g. the merges printed while stdout is a file */
+      std::cout.flush();
+      std::cerr.flush();
+      pid_t pid=fork();
+      if(pid==0){
+        int result=trainShard(trainDir, plans[shard.plan], shard, cam);
+        std::cout.flush();
+        std::cerr.flush();
+        /** Nothing of the parent has to be cleaned up */
+        _exit(result);
+      }
+      if(pid<0){
+        std::cerr << "Could not start a worker: " << strerror(errno) << "\n";
+        /** Their shards would be left half written */
+        for(const auto& w : running){
+          kill(w.first, SIGKILL);
+        }
+        for(const auto& w : running){
+          waitpid(w.first, nullptr, 0);
+        }
+        return -1;
+      }
+      running.insert(std::make_pair(pid, shard));
+    }
+
+    int status;
+    pid_t pid=waitpid(-1, &status, 0);
+    auto it=running.find(pid);
+    if(it==running.end()){
+      continue;
+    }
+    const Shard shard=it->second;
+    running.erase(it);
+    if(!WIFEXITED(status) || WEXITSTATUS(status)!=0){
+      failed[shard.plan]=true;
+    }
+    if(--shardsLeft[shard.plan]==0){
+      const TrainingPlan& plan=plans[shard.plan];
+      if(failed[shard.plan]){
+        std::cerr << "Training of " << plan.id << " failed\n";
+        ++failures;
+      }
+      else{
+        failures+=mergeShards(trainDir, plan, std::count_if(shards.begin(), shards.end(), [&shard] (const Shard& s) { return s.plan==shard.plan; }));
+      }
+    }
+  }
+  return failures==0 ? 0 : -1;
+}
+
 int main(int argc, char* argv[])
 {
   namespace fs = boost::filesystem; 
@@ -211,6 +568,12 @@ int main(int argc, char* argv[])
   lmTConfig["visualizeTraining"] >> visualize_;
   lmTConfig["slowMotion"] >> slow_;
   lmTConfig["nVisualize"] >> nViz_;
+  /** Worker processes rendering in parallel (see trainCatalogue): one per core, unless the training has to be shown as it goes */
+  int nProcesses=visualize_ ? 1 : std::thread::hardware_concurrency();
+  if(!lmTConfig["nProcesses"].empty()){
+    lmTConfig["nProcesses"] >> nProcesses;
+  }
+  nProcesses=std::max(1, nProcesses);
   const cv::FileNode& rParams=lmConfig["rendering"];
 
   //Set the Values:
@@ -237,6 +600,7 @@ int main(int argc, char* argv[])
   }
 
   std::cout << "Reading model names from " << objNamesPath << "..\n";
+  std::vector<std::string> objects;
   {
     std::ifstream names(objNamesPath.string());
     while(names.good()){
@@ -248,8 +612,7 @@ int main(int argc, char* argv[])
       if(s[0]=='#'){
         continue;
       }
-      std::cout << "Elaborating directory: " << s << "\n";
-      trainObject(objsfolder_path, s, camModel);
+      objects.push_back(s);
     }
     if(!names.eof()){
       std::cout << "Could not read model names.";
@@ -257,6 +620,17 @@ int main(int argc, char* argv[])
     }
   }
 
+  if(nProcesses>1){
+    if(trainCatalogue(objsfolder_path, objects, camModel, nProcesses)!=0){
+      return -1;
+    }
+  }
+  else{
+    for(const auto& s : objects){
+      std::cout << "Elaborating directory: " << s << "\n";
+      trainObject(objsfolder_path, s, camModel);
+    }
+  }
 
 
   std::cout << "Ended :)\n";
@@ -1,30 +1,40 @@
 #include <opencv2/opencv.hpp>
 #include <opencv/highgui.h>
-#include <unistd.h>
+#include <Camera/SharedFrameRing.h>
+#include <Camera/OpenniStreamProvider.h>
+#include <cstdlib>
+
+/** Streams the frames of a Kinect to apc through a shared memory ring.
+ * With two Kinects, each one has its own streamer, e.g.
+ *   OpenNI_Streamer                               (first device, on the default ring: apc --stream)
+ *   OpenNI_Streamer /apc_openni_stream_right 1    (second device: apc --stream --right-stream /apc_openni_stream_right)
+ */
 int main(int argc, char** argv){
-  if(argc!=2){
-    std::cout << "Nope.\n";
+  if(argc>3){
+    std::cout << "Usage: " << argv[0] << " [shared memory name [OpenNI device index]]\n";
     return -1;
   }
-  cv::VideoCapture _capture(CV_CAP_OPENNI);
-  std::cout << "Started streaming data to main system..\n";
-  int c=0;
-  cv::namedWindow("DEPTH");
+  std::string name=(argc>=2 ? std::string(argv[1]) : Camera::OpenniStreamProvider::DEFAULT_STREAM);
+  int device=(argc==3 ? ::atoi(argv[2]) : 0);
+  cv::VideoCapture _capture(CV_CAP_OPENNI+device);
+  if(!_capture.isOpened()){
+    std::cerr << "Couldn't open OpenNI device " << device << "\n";
+    return -1;
+  }
+  Camera::SharedFrameRing ring(name, Camera::SharedFrameRing::PRODUCER);
+  std::cout << "Started streaming data of device " << device << " to main system on " << name << "..\n";
+  /** Both the streamers can show their frames */
+  const std::string title=" ("+name+")";
+  cv::namedWindow("DEPTH"+title);
   while(1){
     cv::Mat depthMap, rgb;
-    usleep(500000);
     _capture.grab();
     _capture.retrieve(depthMap, CV_CAP_OPENNI_DEPTH_MAP);
-    cv::imshow("DEPTH", depthMap);
-    cv::waitKey(1);
     _capture.retrieve(rgb, CV_CAP_OPENNI_BGR_IMAGE);
-    cv::imshow("RGB", rgb);
+    ring.publish(depthMap, rgb);
+    cv::imshow("DEPTH"+title, depthMap);
+    cv::imshow("RGB"+title, rgb);
     cv::waitKey(1);
-    std::string name=std::string(argv[1])+"/";
-    imwrite(name+"/rgb1.png", rgb);
-    imwrite(name+"/depth1.png", depthMap);
-    system(("mv "+name+"rgb1.png "+name+"rgb.png ; mv "+name+"depth1.png "+name+"depth.png").c_str());
-    std::cout << ++c << "\n";
   }
   return 0;
 }
@@ -0,0 +1,49 @@
+#include <iostream>
+#include <sstream>
+#include <cstdlib>
+#include <opencv2/opencv.hpp>
+#include <Camera/Recording.h>
+#include <Camera/CameraModel.h>
+
+/** Packs a sequence of loose rgbPrefixN.png / depthPrefixN.png pairs into a single recording */
+int main(int argc, char** argv){
+  if(argc<5 || argc>7){
+    std::cerr << "Usage: " << argv[0] << " camera_data.yml rgbPrefix depthPrefix output.rgbd [png|jpeg|raw] [framesPerChunk]\n";
+    return -1;
+  }
+
+  cv::FileStorage cameraFile(argv[1], cv::FileStorage::READ);
+  Camera::CameraModel camModel=Camera::CameraModel::readFrom(cameraFile["camera_model"]);
+
+  Camera::Recording::RgbCodec codec=Camera::Recording::RGB_PNG;
+  if(argc>5){
+    std::string c(argv[5]);
+    if(c=="jpeg"){
+      codec=Camera::Recording::RGB_JPEG;
+    }
+    else if(c=="raw"){
+      codec=Camera::Recording::RGB_RAW;
+    }
+    else if(c!="png"){
+      std::cerr << "Unknown RGB codec " << c << "\n";
+      return -1;
+    }
+  }
+  int framesPerChunk=(argc>6 ? ::atoi(argv[6]) : 32);
+
+  Camera::RecordingWriter writer(argv[4], codec, framesPerChunk);
+  for(size_t i=0; ; ++i){
+    std::ostringstream rgbCurrent, depthCurrent;
+    rgbCurrent << argv[2] << i << ".png";
+    depthCurrent << argv[3] << i << ".png";
+    cv::Mat rgb=cv::imread(rgbCurrent.str(), CV_LOAD_IMAGE_ANYDEPTH | CV_LOAD_IMAGE_COLOR);
+    cv::Mat depth=cv::imread(depthCurrent.str(), CV_LOAD_IMAGE_ANYDEPTH | CV_LOAD_IMAGE_GRAYSCALE);
+    if(rgb.empty() || depth.empty()){
+      break;
+    }
+    writer.addFrame(Img::Image(depth, rgb), camModel);
+  }
+  writer.close();
+  std::cout << "Written " << writer.framesWritten() << " frames to " << argv[4] << "\n";
+  return 0;
+}
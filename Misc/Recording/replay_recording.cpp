@@ -0,0 +1,27 @@
+#include <iostream>
+#include <chrono>
+#include <stdexcept>
+#include <Camera/RecordingProvider.h>
+
+/** Reads a whole recording as fast as possible and reports the replay throughput */
+int main(int argc, char** argv){
+  if(argc!=2){
+    std::cerr << "Usage: " << argv[0] << " recording.rgbd\n";
+    return -1;
+  }
+
+  Camera::RecordingProvider provider(argv[1]);
+  auto start=std::chrono::steady_clock::now();
+  size_t n=0;
+  try{
+    while(true){
+      provider.getFrame();
+      ++n;
+    }
+  }
+  catch(const std::runtime_error& e){
+  }
+  double secs=std::chrono::duration<double>(std::chrono::steady_clock::now()-start).count();
+  std::cout << "Replayed " << n << " frames in " << secs << "s (" << n/secs << " fps)\n";
+  return 0;
+}
@@ -0,0 +1,65 @@
+#include <chrono>
+#include <iostream>
+#include <vector>
+#include <C5G/C5G.h>
+#include <C5G/Pose.h>
+
+/** Goes through the waypoints of a scan of the shelf (safe pose, approach, bin, approach for each bin) first stopping at every
+ * waypoint and waiting for it, then streaming them and flying by all but the bins. Run it against robot_standin (or the robot).
+ */
+int main(int argc, char** argv){
+  if(argc<2){
+    std::cerr << "Usage: " << argv[0] << " server\n";
+    std::cerr << "Example: " << argv[0] << " 127.0.0.1\n";
+    return -1;
+  }
+
+  C5G::C5G robot(argv[1], "", false);
+  try{
+    robot.init();
+  }
+  catch(const std::exception& e){
+    std::cerr << e.what() << "\n";
+    return -2;
+  }
+
+  struct Waypoint{
+    C5G::Pose pose;
+    bool mustStop;
+  };
+  std::vector<Waypoint> waypoints;
+  const C5G::Pose safe=C5G::C5G::safePose();
+  for(int row=0; row<4; ++row){
+    for(int column=0; column<3; ++column){
+      C5G::Pose bin(1.0, -0.3+0.3*column, 1.5-0.25*row, 0, 1.57, 0);
+      C5G::Pose approach=safe;
+      approach.x=bin.x-0.3;
+      approach.y=bin.y;
+      waypoints.push_back({safe, false});
+      waypoints.push_back({approach, false});
+      waypoints.push_back({bin, true});
+      waypoints.push_back({approach, false});
+    }
+  }
+
+  typedef std::chrono::steady_clock Clock;
+  Clock::time_point start=Clock::now();
+  for(const auto& w : waypoints){
+    robot.moveCartesianGlobal(w.pose);
+  }
+  double stopAndGo=std::chrono::duration<double>(Clock::now()-start).count();
+
+  start=Clock::now();
+  for(const auto& w : waypoints){
+    auto done=robot.moveCartesianGlobalAsync(w.pose, w.mustStop ? C5G::C5G::STOP : C5G::C5G::FLY);
+    if(w.mustStop){
+      /** Here the photo would be taken */
+      done.get();
+    }
+  }
+  robot.waitMotion();
+  double streamed=std::chrono::duration<double>(Clock::now()-start).count();
+
+  std::cout << waypoints.size() << " waypoints: " << stopAndGo << " s stopping at each one, " << streamed << " s streaming them\n";
+  return 0;
+}
@@ -0,0 +1,210 @@
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <boost/program_options.hpp>
+#include <Sim/Motion.h>
+
+/** Stand-in for the controller side of the socket protocol (see src/C5G/C5G_socket.cpp), to test and benchmark it without the robot.
+ * Movements are acknowledged as soon as they are received and executed one after the other, in scaled real time.
+ * Only the translation is simulated, with the trapezoidal speed profile of the simulated robot (see Sim::trapezoidTime): the robot stops on each pose, unless the movement
+ * asks to fly by it and the next one has already been received when it starts.
+ */
+
+namespace{
+  struct Move{
+    unsigned long seq;
+    double x, y, z;
+    bool fly;
+  };
+
+  struct Params{
+    double maxSpeed;
+    double maxAcc;
+    double timeScale;
+  };
+
+  class Connection{
+    public:
+      Connection(int fd, const Params& params)
+        :
+          _fd(fd),
+          _params(params),
+          _closed(false)
+      {
+      }
+
+      void run(){
+        std::thread motion(&Connection::execute, this);
+        std::string pending;
+        char buffer[4096];
+        ssize_t n;
+        while((n=recv(_fd, buffer, sizeof(buffer), 0))>0){
+          pending.append(buffer, n);
+          size_t end;
+          while((end=pending.find('\n'))!=std::string::npos){
+            handle(pending.substr(0, end));
+            pending.erase(0, end+1);
+          }
+        }
+        {
+          std::lock_guard<std::mutex> lock(_mutex);
+          _closed=true;
+        }
+        _changed.notify_all();
+        motion.join();
+      }
+
+    private:
+      int _fd;
+      Params _params;
+      std::deque<Move> _queue;
+      bool _closed;
+      std::mutex _mutex;
+      std::mutex _sendMutex;
+      std::condition_variable _changed;
+
+      void send(const std::string& what, unsigned long seq){
+        std::ostringstream s;
+        s << what << " " << seq << "\n";
+        std::lock_guard<std::mutex> lock(_sendMutex);
+        std::string line=s.str();
+        ::send(_fd, line.data(), line.size(), MSG_NOSIGNAL);
+      }
+
+      /** L <seq> <x,y,z,alpha,beta,gamma,blending> */
+      void handle(const std::string& line){
+        std::istringstream in(line);
+        std::string command, pose;
+        Move m;
+        m.seq=0;
+        bool hasSeq=static_cast<bool>(in >> command >> m.seq);
+        if(!hasSeq || !(in >> pose) || command!="L" || pose.size()<2 || pose.front()!='<' || pose.back()!='>'){
+          std::cerr << "Malformed command: " << line << "\n";
+          /** Without a sequence number there is nobody to answer to */
+          if(command=="L" && hasSeq){
+            send("ERR", m.seq);
+          }
+          return;
+        }
+        std::replace(pose.begin(), pose.end(), ',', ' ');
+        std::istringstream values(pose.substr(1, pose.size()-2));
+        double alpha, beta, gamma;
+        std::string blending;
+        if(!(values >> m.x >> m.y >> m.z >> alpha >> beta >> gamma)){
+          send("ERR", m.seq);
+          return;
+        }
+        values >> blending;
+        m.fly=(blending=="FLY");
+
+        send("ACK", m.seq);
+        {
+          std::lock_guard<std::mutex> lock(_mutex);
+          _queue.push_back(m);
+        }
+        _changed.notify_all();
+      }
+
+      void execute(){
+        typedef std::chrono::steady_clock Clock;
+        const Clock::time_point start=Clock::now();
+        double x=0.3, y=0, z=0.9, speed=0;
+        double busy=0, idle=0;
+        size_t moves=0, stops=0;
+
+        while(true){
+          Move m;
+          bool blend;
+          {
+            std::unique_lock<std::mutex> lock(_mutex);
+            Clock::time_point waitStart=Clock::now();
+            _changed.wait(lock, [this] () { return _closed || !_queue.empty(); });
+            idle+=std::chrono::duration<double>(Clock::now()-waitStart).count()*_params.timeScale;
+            if(_queue.empty()){
+              break;
+            }
+            m=_queue.front();
+            _queue.pop_front();
+            blend=m.fly && !_queue.empty();
+          }
+          double d=std::sqrt((m.x-x)*(m.x-x)+(m.y-y)*(m.y-y)+(m.z-z)*(m.z-z));
+          double exitSpeed=blend ? _params.maxSpeed : 0;
+          double t=Sim::trapezoidTime(d, _params.maxSpeed, _params.maxAcc, speed, exitSpeed);
+          std::this_thread::sleep_for(std::chrono::duration<double>(t/_params.timeScale));
+
+          busy+=t;
+          ++moves;
+          stops+=(exitSpeed==0);
+          x=m.x;
+          y=m.y;
+          z=m.z;
+          speed=exitSpeed;
+          send("DONE", m.seq);
+        }
+
+        double wall=std::chrono::duration<double>(Clock::now()-start).count()*_params.timeScale;
+        std::cout << moves << " movements (" << stops << " stops) in " << wall << " s: " << busy << " s moving, " << idle << " s waiting for commands\n";
+      }
+  };
+}
+
+int main(int argc, char** argv){
+  int port;
+  Params params;
+
+  namespace po=boost::program_options;
+  po::options_description desc("Allowed options");
+  desc.add_options()
+    ("help", "print help message")
+    ("port,p", po::value<int>(&port)->default_value(1101), "port to listen to")
+    ("speed,v", po::value<double>(&params.maxSpeed)->default_value(0.5), "maximum cartesian speed [m/s]")
+    ("acceleration,a", po::value<double>(&params.maxAcc)->default_value(1.0), "maximum cartesian acceleration [m/s^2]")
+    ("time-scale,t", po::value<double>(&params.timeScale)->default_value(1.0), "how many times faster than real time movements are executed");
+
+  po::variables_map vm;
+  po::store(po::parse_command_line(argc, argv, desc), vm);
+  if(vm.count("help")){
+    std::cout << desc << "\n";
+    return 0;
+  }
+  po::notify(vm);
+
+  int server=socket(AF_INET, SOCK_STREAM, 0);
+  int yes=1;
+  setsockopt(server, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes));
+  sockaddr_in address;
+  memset(&address, 0, sizeof(address));
+  address.sin_family=AF_INET;
+  address.sin_addr.s_addr=htonl(INADDR_ANY);
+  address.sin_port=htons(port);
+  if(server<0 || bind(server, reinterpret_cast<sockaddr*>(&address), sizeof(address))!=0 || listen(server, 1)!=0){
+    std::cerr << "Couldn't listen on port " << port << ": " << strerror(errno) << "\n";
+    return -1;
+  }
+
+  std::cout << "Robot stand-in listening on port " << port << "\n";
+  while(true){
+    int client=accept(server, nullptr, nullptr);
+    if(client<0){
+      continue;
+    }
+    std::cout << "Client connected\n";
+    Connection(client, params).run();
+    close(client);
+    std::cout << "Client disconnected\n";
+  }
+  return 0;
+}
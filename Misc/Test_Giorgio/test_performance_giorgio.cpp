@@ -2,6 +2,7 @@
 #include <cassert>
 #include <cstdlib>
 #include <Img/Image.h>
+#include <Img/FrameArena.h>
 #include <Recognition/RecognitionData.h>
 #include <Recognition/Utils.h>
 #include <Camera/FileProviderAuto.h>
@@ -86,6 +87,8 @@ int main(int argc, char** argv){
     catch (std::runtime_error e){
       std::cout << "Didn't get it: " << e.what() << "\n";
     }
+    /** Stops growing once the frame arenas are warmed up: only the matrices come from them */
+    std::cout << " arenaChunkAllocations: " << Img::FrameArena::chunkAllocations() << ",\n";
     std::cout << "}";
 
   }
@@ -0,0 +1,92 @@
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <stdexcept>
+#include <Img/Image.h>
+#include <Img/ImageWMask.h>
+#include <Recognition/RecognitionData.h>
+#include <Camera/CameraModel.h>
+#include <Camera/FileProviderAuto.h>
+#include <Eigen/Geometry>
+
+/** Recognizes a set of objects into two recorded views of the same scene, e.g. from the left and the right camera,
+ * fusing what is found into the frame both the camera models are placed into by their extrinsics.
+ * Objects found by both views must be found at the same pose by each one on its own, and fused into a single item:
+ * the exit status is 1 otherwise.
+ */
+int main(int argc, char** argv){
+  constexpr int CORRECT_N=8;
+  if(argc<=CORRECT_N){
+    std::cerr << "Usage: " << argv[0] << " /path/to/models leftCamera.yml leftRGBImage leftDepthImage rightCamera.yml rightRGBImage rightDepthImage objectName .. objectName\n";
+    return -1;
+  }
+
+  std::vector<std::string> whatToTake;
+  for(int i=CORRECT_N; i<argc; ++i){
+    whatToTake.emplace_back(argv[i]);
+  }
+
+  std::vector<Recognition::RecognitionData::View> views;
+  for(int first : {2, 5}){
+    cv::FileStorage cameraFile(argv[first], cv::FileStorage::READ);
+    if(!cameraFile.isOpened()){
+      std::cerr << "Couldn't open " << argv[first] << "\n";
+      return -1;
+    }
+    Camera::CameraModel camModel=Camera::CameraModel::readFrom(cameraFile["camera_model"]);
+
+    std::unique_ptr<Camera::FileProviderAuto> cam;
+    try{
+      cam.reset(new Camera::FileProviderAuto(argv[first+1], argv[first+2]));
+    }
+    catch(std::string e){
+      std::cerr << "Couldn't read the view: " << e << "\n";
+      return -1;
+    }
+    Img::Image x=cam->getFrame();
+    /** Match on the whole image: the depth is registered onto the RGB */
+    Img::Image::Matrix mask(x.rgb.size(), CV_8UC1, cv::Scalar{255});
+    Img::ImageWMask frame(x, mask);
+    views.push_back({frame, frame, camModel, camModel});
+  }
+
+  Recognition::RecognitionData mySister(std::string(argv[1]), views[0].camera);
+  /** Maximum distance between the poses of an object found by both the views, as RecognitionData's fusion */
+  constexpr double MAX_DISAGREEMENT=0.04;
+  bool agree=true;
+  try{
+    auto result=mySister.recognize(views, whatToTake);
+    /** Each view on its own, to check that they place the objects at the same pose */
+    auto left=mySister.recognize({views[0]}, whatToTake);
+    auto right=mySister.recognize({views[1]}, whatToTake);
+    for(auto& x : whatToTake){
+      if(result[x].empty()){
+        std::cout << x << ": " << "NOTFOUND" << "\n";
+        continue;
+      }
+      std::cout << x << ": " << result[x].size() << " found\n";
+      for(const auto& m : result[x]){
+        std::cout << " score " << m.matchScore << "\n" << m.pose.matrix() << "\n";
+      }
+      if(left[x].empty() || right[x].empty()){
+        std::cout << " found by one view only\n";
+        continue;
+      }
+      const Eigen::Affine3d& l=left[x][0].pose;
+      const Eigen::Affine3d& r=right[x][0].pose;
+      const double distance=(l.translation()-r.translation()).norm();
+      const double angle=Eigen::AngleAxisd(l.linear().transpose()*r.linear()).angle();
+      std::cout << " views " << distance << " m, " << angle*180/M_PI << " deg apart\n";
+      /** Both views see the same item: fused, it must be one */
+      if(distance>MAX_DISAGREEMENT || result[x].size()>std::max(left[x].size(), right[x].size())){
+        std::cout << " DISAGREE\n";
+        agree=false;
+      }
+    }
+  }
+  catch(std::runtime_error e){
+    std::cout << "Didn't get it: " << e.what() << "\n";
+    return -2;
+  }
+  return agree ? 0 : 1;
+}
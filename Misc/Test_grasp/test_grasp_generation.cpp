@@ -1,6 +1,7 @@
 #include <algorithm>
 #include <Gripper/Types.h>
 #include <Gripper/GraspPose.h>
+#include <Gripper/PoseFactory.h>
 #include <Utils/CvStorage.h>
 
 int main(int argc, char** argv){
@@ -19,7 +20,7 @@ int main(int argc, char** argv){
   pcl::visualization::PCLVisualizer viewer("Grasps");
 
   viewer.addPointCloud(objects[toVisualize].myShape->getPCSurface(50));
-  for(const auto& x :objects[toVisualize].myGrasps){
+  for(const auto& x : Gripper::PoseFactory::drain(*objects[toVisualize].myGraspSource->restart())){
     x.drawToViewer(viewer, 0.05);
   }
 
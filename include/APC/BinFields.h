@@ -0,0 +1,49 @@
+#pragma once
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <Gripper/DistanceField.h>
+#include <Gripper/Grasper.h>
+#include <Gripper/Types.h>
+#include "Shelf.h"
+
+namespace APC{
+  /** Signed distance fields of the bins, made of the recognized objects and of the walls of the shelf.
+   * A field is rebuilt from scratch when the content of the bin is recognized again,
+   * and updated incrementally when a single object is taken away.
+   */
+  class BinFields{
+    public:
+      static BinFields& getInstance();
+
+      /** Rebuilds the field of a bin; items are in global coordinates */
+      void rebuild(int row, int column, const Gripper::ObjectsScene& items, const Gripper::ObjectDB& objDB);
+
+      /** Removes the item-th object (as in the scene given to rebuild) from the field */
+      void removeItem(int row, int column, size_t item);
+
+      /** The field of a bin, or nullptr if it was never built */
+      std::shared_ptr<const Gripper::DistanceField> get(int row, int column) const;
+
+      static const double VOXEL_SIZE;
+      /** Space around the bin which is covered by the field */
+      static const double MARGIN;
+      /** Weight of the penetrations into the walls, which will never move away */
+      static const double WALL_WEIGHT;
+
+    private:
+      struct Bin{
+        std::shared_ptr<Gripper::DistanceField> field;
+        std::vector<Gripper::DistanceField::Id> items;
+      };
+
+      BinFields();
+      BinFields(const BinFields&)=delete;
+      void operator=(const BinFields&)=delete;
+
+      static Gripper::DistanceField makeEmptyBin(int row, int column);
+
+      mutable std::mutex _mutex;
+      Bin _bins[Shelf::HEIGHT][Shelf::WIDTH];
+  };
+}
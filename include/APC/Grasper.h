@@ -1,6 +1,21 @@
 #pragma once
+#include <string>
 #include <C5G/Grasp.h>
 
 namespace APC{
+  /** Loads the gripper model and the database of the objects (shapes and grasps) used for planning.
+   * They stay loaded for the whole run; this must be called before getBestGrasp.
+   */
+  void loadGraspModels(const std::string& objectsFile, const std::string& gripperFile);
+
+  /** Rebuilds the collision model of a bin from its content into RobotData (to be called after recognition) */
+  void updateBinModel(int row, int column);
+
+  /** Forgets an object which has been taken away from a bin */
+  void removeFromBin(int row, int column, const std::string& what);
+
+  /** Results are cached until the content of the bin changes (see RobotData::getBinVersion), so asking again for an object into a clean bin is cheap.
+   * Different objects can be planned concurrently, as long as nobody changes RobotData meanwhile.
+   */
   C5G::Grasp getBestGrasp(std::string what, int row, int column);
 }
@@ -0,0 +1,68 @@
+#pragma once
+#include <memory>
+#include <vector>
+#include "Order.h"
+#include "Robot.h"
+#include "Shelf.h"
+#include "TaskGraph.h"
+
+namespace APC{
+  /** Orders still to be taken, with recognition and planning running in background while the robot moves.
+   * Tasks are chained per bin: the recognition of a bin waits for everything queued on it before, while the planning of
+   * its orders only waits for the recognition (orders of the same bin are planned in parallel, as different bins are).
+   * The content of a bin into RobotData is only touched by its own tasks, or by the main thread after waitBin.
+   * Tasks never fail: an error would be rethrown by every later wait on the bin, so a failed recognition marks its bin
+   * instead, and a failed planning leaves its order with the lowest score.
+   */
+  class Pipeline{
+    public:
+      Pipeline(Robot& robot);
+
+      /** Dirty bins of the orders are photographed right away, moving from one bin to the next without waiting for the
+       * recognition of the previous one; the orders are planned as soon as their bin has been recognized.
+       */
+      void add(const std::vector<Order>& orders);
+
+      bool empty() const;
+
+      /** Waits for the planning of all the orders, and takes away the one with the best grasp */
+      Order takeBest();
+
+      /** Blocks until no task works on the bin anymore: this must be called before the main thread changes it */
+      void waitBin(int row, int column);
+
+      /** The content of the bin has been changed (e.g. an object has been taken away): its orders are planned again, in background */
+      void binChanged(int row, int column);
+
+      /** Orders still to be taken, with their grasps: only to be called while nothing is being planned, e.g. right after takeBest */
+      OrderStatus pending() const;
+
+    private:
+      struct Entry{
+        Order order;
+        TaskGraph::Task planned;
+      };
+
+      /** Last recognition of a bin, and the plans queued after it */
+      struct BinTasks{
+        bool hasWriter;
+        /** Written by the recognition, read by the tasks after it and by the main thread after waitBin */
+        bool failed;
+        TaskGraph::Task writer;
+        std::vector<TaskGraph::Task> readers;
+      };
+
+      Pipeline(const Pipeline&)=delete;
+      void operator=(const Pipeline&)=delete;
+
+      void photograph(int row, int column);
+      void plan(const std::shared_ptr<Entry>& entry);
+
+      Robot& _robot;
+      std::vector<std::shared_ptr<Entry>> _orders;
+      BinTasks _bins[Shelf::HEIGHT][Shelf::WIDTH];
+
+      /** Last member: it is destroyed first, waiting for the tasks which still refer to the entries */
+      TaskGraph _tasks;
+  };
+}
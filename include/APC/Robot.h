@@ -1,4 +1,5 @@
 #pragma once
+#include <array>
 #include <iostream>
 #include <boost/asio/ip/tcp.hpp>
 #include <Img/Image.h>
@@ -11,6 +12,8 @@ namespace APC{
   {
     private:
       Camera::ImageProvider::Ptr _provider;
+      /** May be null: the robot has only the left camera */
+      Camera::ImageProvider::Ptr _rightProvider;
     public:
       enum class CameraIndex
       {
@@ -18,8 +21,11 @@ namespace APC{
         RIGHT
       };
       void moveToBin(int row, int column);
-      Robot(const std::string& ip, const std::string& sys_id, bool mustInit, const Camera::ImageProvider::Ptr& provider);
+      Robot(const std::string& ip, const std::string& sys_id, bool mustInit, const Camera::ImageProvider::Ptr& provider, const Camera::ImageProvider::Ptr& rightProvider=nullptr);
       Img::Image takePhoto(CameraIndex direction=CameraIndex::LEFT);
+      bool hasCamera(CameraIndex direction) const;
+      /** Photos of the left and of the right camera, taken at the same time; throws if there is no right camera */
+      std::array<Img::Image, 2> takePhotos();
       void executeGrasp(const ::C5G::Grasp&);
   };
 }
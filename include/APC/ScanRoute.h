@@ -0,0 +1,54 @@
+#pragma once
+#include <utility>
+#include <vector>
+#include <C5G/Pose.h>
+
+namespace APC{
+  /** Order in which the bins are visited to be scanned, so that the robot travels as little as possible.
+   * In front of the shelf the robot slides from a bin to one sharing a wall with it; to reach any other bin it backs out to
+   * the retreat plane (the X of C5G::safePose), moves there and comes in again, flying by the intermediate poses.
+   * The cost of a leg is the time of a stop-and-go movement of each of its poses, with nominal limits of the robot.
+   */
+  class ScanRoute{
+    public:
+      /** Indexes of a bin as for Shelf::getBinSafePose */
+      typedef std::pair<int, int> Bin;
+
+      /** Up to this many bins the order is the optimal one; beyond, it is a local optimum (nearest neighbour and 2-opt) */
+      static constexpr size_t MAX_EXACT=12;
+
+      /** Route through all the bins, starting from start */
+      ScanRoute(const C5G::Pose& start, const std::vector<Bin>& bins);
+
+      const std::vector<Bin>& getOrder() const;
+
+      /** Poses the robot goes through to reach the k-th bin from the previous one (or from start), the last one being the
+       * pose from which the bin is scanned.
+       */
+      std::vector<C5G::Pose> getWaypoints(size_t k) const;
+
+      /** Estimated travel time [s] */
+      double getCost() const;
+
+      /** Pose from which the bin is scanned, relative to the robot */
+      static C5G::Pose getScanPose(const Bin& bin);
+
+      /** The scan pose of the bin, backed out to the retreat plane */
+      static C5G::Pose getRetreatPose(const Bin& bin);
+
+      /** Whether the robot can go straight from a bin to the other, without backing out */
+      static bool isDirect(const Bin& from, const Bin& to);
+
+    private:
+      /** Poses from one bin to another, or from start if from is nullptr */
+      std::vector<C5G::Pose> path(const Bin* from, const Bin& to) const;
+      double legCost(const Bin* from, const Bin& to) const;
+
+      void planExact(const std::vector<Bin>& bins);
+      void planHeuristic(const std::vector<Bin>& bins);
+
+      C5G::Pose _start;
+      std::vector<Bin> _order;
+      double _cost;
+  };
+}
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <C5G/Pose.h>
+#include <Eigen/Geometry>
 
 namespace APC{
 
@@ -18,6 +19,7 @@ namespace APC{
       static constexpr unsigned int WIDTH=3;
       static const double BIN_DEPTH;
       static const double SECURITY_DISTANCE;
+      static const double WALL_THICKNESS;
       static const Pose CAMERA_POSE;
       static const Pose POSE_FOR_THE_PHOTOS;
       static const Pose BIN0;
@@ -26,6 +28,9 @@ namespace APC{
 
       static Pose getBinSafePose(int i, int j);
 
+      /** Inside of the bin, relative to the robot */
+      static Eigen::AlignedBox3d getBinBounds(int i, int j);
+
       static constexpr const auto& getBinCornerPose=getBinPose;
       static constexpr const auto& getBinCenterPose=getBinSafePose;
   };
@@ -0,0 +1,63 @@
+#pragma once
+#include <algorithm>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace APC{
+  /** Runs functions on a pool of threads, each one as soon as all the tasks it depends on are finished.
+   * A task whose dependency failed is not run at all, and fails with the same error.
+   * With the virtual clock (see Sim::Clock) a task starts at the time it has been added, or when its dependencies end, and
+   * waiting for it takes the waiting thread to its end; what it did is recorded into Sim::Timeline under its name.
+   */
+  class TaskGraph{
+    public:
+      typedef size_t Task;
+
+      TaskGraph(size_t nThreads=std::max(1u, std::thread::hardware_concurrency()));
+      /** Waits for all the tasks which have been added */
+      ~TaskGraph();
+
+      Task add(const std::function<void()>& f, const std::vector<Task>& dependencies=std::vector<Task>{}, const std::string& name="task");
+
+      /** Blocks until the task is finished, and rethrows its error if it failed */
+      void wait(Task task);
+
+      /** Blocks until all the tasks added so far are finished (their errors are not reported) */
+      void waitAll();
+
+    private:
+      struct Node{
+        std::function<void()> f;
+        size_t pending;
+        std::vector<Task> successors;
+        bool done;
+        std::exception_ptr error;
+        std::string name;
+        /** Virtual time it can start at, and when it ended */
+        double start;
+        double end;
+      };
+
+      TaskGraph(const TaskGraph&)=delete;
+      void operator=(const TaskGraph&)=delete;
+
+      void worker();
+      /** Called with the lock held */
+      void finish(Task task, const std::exception_ptr& error, double end);
+
+      std::mutex _mutex;
+      std::condition_variable _ready;
+      std::condition_variable _finished;
+      std::vector<Node> _nodes;
+      std::queue<Task> _queue;
+      size_t _unfinished;
+      bool _stop;
+      std::vector<std::thread> _threads;
+  };
+}
@@ -1,8 +0,0 @@
-#pragma once
-
-#include "Robot.h"
-#include "Order.h"
-namespace APC{
-  void updateBins(OrderStatus& order, Robot& robot);
-}
- 
@@ -1,10 +1,19 @@
 #pragma once
 #include <boost/thread.hpp>
+#include <future>
+#include <memory>
 #include "Pose.h"
 #include "Grasp.h"
 namespace C5G{
   class C5G{
 
+    public:
+      /** Whether the robot stops on the pose of a movement, or flies by it toward the next one (only if the backend can blend movements) */
+      enum Blending{
+        STOP,
+        FLY
+      };
+
     private:
       std::string _ip;
       std::string _sys_id;
@@ -17,6 +26,15 @@ namespace C5G{
       MovementStatus _currentMovementMode;
       Pose _lastGlobalPose;
 
+      /** The last movement started by moveCartesianGlobalAsync */
+      std::shared_future<void> _lastMove;
+
+      /** State of the backend the library has been built with (ROBOT_TYPE): each one defines it as it needs, so that
+       * every backend shares this same declaration
+       */
+      struct Impl;
+      std::unique_ptr<Impl> _impl;
+
     public:
       C5G(const std::string& ip, const std::string& sys_id, bool mustInit=true);
       ~C5G();
@@ -29,7 +47,16 @@ namespace C5G{
       void setPosition(const Pose& p);
       void setGripping(double strength);
       void moveCartesianGlobal(const Pose& p);
+      /** Starts a global movement and returns as soon as the robot has accepted it: the future becomes ready when the movement
+       * is over, so that the caller can work meanwhile. Movements are queued, each one starting after the previous is over.
+       */
+      std::shared_future<void> moveCartesianGlobalAsync(const Pose& p, Blending blending=STOP);
+      /** Blocks until the last movement is over */
+      void waitMotion();
       void moveAdditive();
 
+      /** Maximum number of movements sent and not completed yet, for the backends streaming them (socket) */
+      static constexpr size_t WINDOW=4;
+
   };
 }
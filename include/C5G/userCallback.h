@@ -50,6 +50,8 @@ EXTRN volatile char flag_RunningMove[MAX_NUM_ARMS];
 EXTRN char flag_ExitFromOpen[MAX_NUM_ARMS];
 EXTRN char flag_MoveKeyboard[MAX_NUM_ARMS];
 EXTRN volatile char flag_hasCompletedTheMovement[MAX_NUM_ARMS];
+/** Number of movements completed by each arm; each counter is also the futex word the completion is waited on */
+EXTRN int completed_moves[MAX_NUM_ARMS];
 EXTRN unsigned int modality_active[MAX_NUM_ARMS];
 EXTRN unsigned int modality_old[MAX_NUM_ARMS];
 EXTRN char* STRING_IP_CNTRL;
@@ -74,6 +76,12 @@ int move_cal_Sys(int idx_cntrl, int idx_arm);
 int move_Arm(ORL_joint_value* px_target_jnt,int type_move,int idx_cntrl, int idx_arm);
 void decode_modality( int si_modality, char* string);
 
+/** Called by user_callback when a movement is over: it never blocks */
+void notify_move_completed(int idx_arm);
+int get_completed_moves(int idx_arm);
+/** Sleeps (without spinning) until the arm completes a movement after the completed-th one */
+void wait_move_completed(int idx_arm, int completed);
+
 #ifdef __cplusplus
 }
 #endif
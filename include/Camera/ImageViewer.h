@@ -1,8 +1,15 @@
 #pragma once
+#include <memory>
 #include <string>
 #include <Img/Image.h>
 
 namespace Camera{
+  /** Shows an image into a pair of windows; it can be used from more threads at once.
+   * Windows belong to a single UI thread, shared by all the viewers, which runs the HighGUI event loop: showing an image
+   * only hands it over, without ever waiting for the GUI. Each viewer keeps just the last image it has been given, so
+   * that images coming faster than they are drawn are dropped.
+   * Headless (built with HEADLESS, run without DISPLAY, or after setHeadless(true)) viewers do nothing at all.
+   */
   class ImageViewer{
     private:
       typedef Img::Image Image;
@@ -13,11 +20,18 @@ namespace Camera{
       ~ImageViewer();
       void setTitle(const std::string& title);
 
+      /** To be called before showing anything */
+      static void setHeadless(bool headless);
+      static bool isHeadless();
+
     private:
-      void updateMyself();
-      std::string _title;
-      Image _what;
-      Image _toRender;
+      class UiThread;
+
+      ImageViewer(const ImageViewer&)=delete;
+      void operator=(const ImageViewer&)=delete;
+
       std::string _ID;
+      /** Kept by the viewers, so that the thread outlives all of them (some are static) */
+      std::shared_ptr<UiThread> _ui;
   };
 }
@@ -1,17 +1,36 @@
 #pragma once
 
+#include <memory>
 #include <opencv2/opencv.hpp>
 #include "ImageProvider.h"
+#include "SharedFrameRing.h"
 
 namespace Camera{
+  /** Reads the frames published by the OpenNI streamer process through a shared memory ring (see SharedFrameRing) */
   class OpenniStreamProvider : public ImageProvider {
     public:
-      OpenniStreamProvider(const std::string& path="./", const std::string& ID="OpenNIProvider");
+      static const std::string DEFAULT_STREAM;
+      /** Seconds waited for the streamer */
+      static const double ATTACH_TIMEOUT;
+      /** Seconds waited for a new frame, before checking whether the streamer has been restarted */
+      static const double FRAME_TIMEOUT;
+
+      /** Waits for the streamer to create the segment called name; throws std::runtime_error if it doesn't within ATTACH_TIMEOUT */
+      OpenniStreamProvider(const std::string& name=DEFAULT_STREAM, const std::string& ID="OpenNIProvider");
+
+      /** Blocks until a frame newer than the last returned one is published. If none comes within FRAME_TIMEOUT and the
+       * streamer has been restarted, it attaches to the new one; throws std::runtime_error if no streamer is publishing
+       */
       virtual Image getFrame() const;
       ~OpenniStreamProvider();
 
     private:
-      std::string _path;
+      std::string _name;
+      /** Waits (up to ATTACH_TIMEOUT) for the streamer to publish on _name, and maps its segment */
+      void attach() const;
+
+      mutable std::unique_ptr<SharedFrameRing> _ring;
+      mutable uint64_t _lastSeq;
 
 
   };
@@ -0,0 +1,26 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace Camera{
+  /** Lossless codec for 16 bit depth maps (A. Wilson, "Fast Lossless Depth Image Compression", 2017).
+   * Runs of zeros (invalid pixels) are run-length encoded, valid pixels are stored as zigzagged deltas
+   * from the previous valid one, and all the numbers are written with a 3+1 bit nibble variable-length code.
+   * Both directions run at several hundreds of MB/s, and depth maps usually shrink 3-4 times.
+   */
+  namespace RVL{
+    /** Upper bound for the compressed size of nPixels depth values, in bytes */
+    size_t maxCompressedSize(size_t nPixels);
+
+    /** Appends the compressed form of input[0..nPixels) to output
+     * @return the number of bytes appended
+     */
+    size_t compress(const uint16_t* input, size_t nPixels, std::vector<char>& output);
+
+    /** Decodes exactly nPixels values into output.
+     * @return the number of bytes read from input
+     */
+    size_t decompress(const char* input, uint16_t* output, size_t nPixels);
+  }
+}
@@ -0,0 +1,113 @@
+#pragma once
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <Img/Image.h>
+#include <Camera/CameraModel.h>
+
+namespace Camera{
+
+  /** On-disk layout of an RGB-D recording (all the values are in host byte order).
+   *
+   *   FileHeader
+   *   ChunkHeader, { FrameHeader, rgb bytes, depth bytes } x nFrames    (repeated for each chunk)
+   *   uint64_t chunk offsets[nChunks]
+   *   Trailer
+   *
+   * Each frame record is padded to a multiple of 8 bytes.
+   * Depth is always stored losslessly with RVL (16 bit, mm). Frames are grouped into chunks so that the
+   * replayer can map/prefetch a whole chunk at a time, and the trailing index allows random access to them.
+   */
+  namespace Recording{
+    enum RgbCodec : uint8_t { RGB_RAW=0, RGB_PNG=1, RGB_JPEG=2 };
+
+    struct FileHeader{
+      char magic[8];
+      uint32_t version;
+      uint32_t reserved;
+    };
+
+    struct ChunkHeader{
+      uint32_t magic;
+      uint32_t nFrames;
+      /** Bytes following this header */
+      uint64_t payloadBytes;
+    };
+
+    struct FrameHeader{
+      /** Capture time, in ns */
+      uint64_t timestamp;
+      uint32_t width;
+      uint32_t height;
+      uint32_t rgbBytes;
+      uint32_t depthBytes;
+      uint8_t rgbCodec;
+      uint8_t reserved[3];
+      /** Intrinsic and extrinsic camera parameters, row-major */
+      float K[9];
+      float extr[16];
+    };
+
+    struct Trailer{
+      uint64_t indexOffset;
+      uint64_t nChunks;
+      uint64_t nFrames;
+      char magic[8];
+    };
+
+    /** Size of a frame record (header and payload), which is padded so that every header stays 8-byte aligned */
+    inline size_t frameRecordSize(const FrameHeader& h){
+      return (sizeof(FrameHeader)+h.rgbBytes+h.depthBytes+7) & ~size_t(7);
+    }
+
+    extern const char FILE_MAGIC[8];
+    extern const char TRAILER_MAGIC[8];
+    extern const uint32_t CHUNK_MAGIC;
+    extern const uint32_t VERSION;
+  }
+
+  /** Writes frames to a recording file. The file is finalized (index and trailer) on close() or destruction. */
+  class RecordingWriter{
+    public:
+      /**
+       * @param filename output file, truncated if existing
+       * @param codec how to store the RGB image (depth is always RVL)
+       * @param framesPerChunk frames grouped into a single chunk
+       * @param jpegQuality only used with RGB_JPEG
+       */
+      RecordingWriter(const std::string& filename, Recording::RgbCodec codec=Recording::RGB_PNG, int framesPerChunk=32, int jpegQuality=95);
+      ~RecordingWriter();
+
+      RecordingWriter(const RecordingWriter&)=delete;
+      RecordingWriter& operator=(const RecordingWriter&)=delete;
+
+      /** Appends a frame. Depth can be either CV_16U (mm) or CV_32F (m), as in Img::Image.
+       * @param timestamp capture time in ns; 0 means "now"
+       */
+      void addFrame(const Img::Image& frame, const CameraModel& model, uint64_t timestamp=0);
+
+      /** Flushes the pending chunk and writes the index. Further calls to addFrame are not allowed. */
+      void close();
+
+      uint64_t framesWritten() const;
+
+    private:
+      void flushChunk();
+
+      std::ofstream _out;
+      Recording::RgbCodec _codec;
+      int _framesPerChunk;
+      int _jpegQuality;
+
+      std::vector<char> _chunk;
+      uint32_t _framesInChunk;
+      std::vector<uint64_t> _chunkOffsets;
+      uint64_t _nFrames;
+      bool _closed;
+
+      /** Scratch buffers, kept to avoid reallocating them at every frame */
+      cv::Mat _depthMm;
+      std::vector<uchar> _encoded;
+  };
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "ImageProvider.h"
+#include "CameraModel.h"
+#include "Recording.h"
+
+namespace Camera{
+  /** Replays a recording written by RecordingWriter.
+   * The file is memory-mapped, and a background thread decodes the frames ahead of the consumer,
+   * so that getFrame() usually just pops an already decoded frame.
+   */
+  class RecordingProvider : public ImageProvider {
+    public:
+      /**
+       * @param loop restart from the first frame at the end of the recording, instead of throwing
+       * @param readAhead maximum number of decoded frames waiting to be consumed
+       */
+      RecordingProvider(const std::string& filename, bool loop=false, int readAhead=8, const std::string& ID="RecordingProvider");
+      ~RecordingProvider();
+
+      /** Returns the next frame of the recording. Throws std::runtime_error at the end of a non-looping recording. */
+      virtual Image getFrame() const;
+
+      /** Number of frames in the recording */
+      size_t size() const;
+
+      /** Timestamp (ns) of the last frame returned by getFrame() */
+      uint64_t lastTimestamp() const;
+
+      /** Camera model of the last frame returned by getFrame() */
+      CameraModel lastCameraModel() const;
+
+    private:
+      struct Decoded{
+        Image frame;
+        uint64_t timestamp;
+        CameraModel model;
+        bool end;
+      };
+
+      void decodeLoop();
+      Decoded decode(size_t index) const;
+
+      const char* _data;
+      size_t _size;
+
+      /** Position of each FrameHeader inside the mapping, and first frame of each chunk */
+      std::vector<const Recording::FrameHeader*> _frames;
+      std::vector<size_t> _chunkFirstFrame;
+      std::vector<std::pair<const char*, size_t> > _chunks;
+
+      bool _loop;
+      size_t _readAhead;
+
+      mutable std::mutex _mutex;
+      mutable std::condition_variable _notEmpty;
+      mutable std::condition_variable _notFull;
+      mutable std::deque<Decoded> _queue;
+      bool _stop;
+
+      mutable uint64_t _lastTimestamp;
+      mutable CameraModel _lastModel;
+
+      std::thread _decoder;
+  };
+}
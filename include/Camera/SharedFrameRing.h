@@ -0,0 +1,87 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <opencv2/core/core.hpp>
+
+namespace Camera{
+
+  /** Single-producer, many-consumers ring of raw RGB-D frames living in a POSIX shared memory segment.
+   * Every slot is protected by a seqlock, and consumers sleep on a futex which is woken by the producer
+   * every time a new frame is published, so no polling (and no disk I/O) is involved in the handoff.
+   */
+  class SharedFrameRing{
+    public:
+      enum Mode { PRODUCER, CONSUMER };
+
+      /** Number of frames kept in the ring. A view on a frame stays valid for SLOTS-1 more publications. */
+      static const int SLOTS=4;
+
+      /** Zero-copy view on a published frame. The matrices point directly into the shared segment. */
+      struct FrameView{
+        /** Monotonically increasing frame number (first frame is 1) */
+        uint64_t seq;
+        /** CLOCK_MONOTONIC time of the publication, in ns */
+        uint64_t timestamp;
+        /** CV_16UC1, in mm */
+        cv::Mat depth;
+        /** CV_8UC3, BGR */
+        cv::Mat rgb;
+
+        /** Tells whether the producer has overwritten the frame since the view was taken.
+         * Call it after having used (or copied) the data to be sure that it was not torn.
+         */
+        bool stillValid() const;
+
+        FrameView();
+
+        private:
+          friend class SharedFrameRing;
+          const std::atomic<uint32_t>* _version;
+          uint32_t _seenVersion;
+      };
+
+      /** Opens (CONSUMER) or creates (PRODUCER) the segment called name. Throws std::runtime_error on failure. */
+      SharedFrameRing(const std::string& name, Mode mode);
+      ~SharedFrameRing();
+
+      SharedFrameRing(const SharedFrameRing&)=delete;
+      SharedFrameRing& operator=(const SharedFrameRing&)=delete;
+
+      /** Copies a frame into the next slot and wakes up all the waiting consumers.
+       * @param depth CV_16UC1 depth map (mm)
+       * @param rgb CV_8UC3 image
+       * @return the sequence number assigned to the frame
+       */
+      uint64_t publish(const cv::Mat& depth, const cv::Mat& rgb);
+
+      /** Blocks until a frame with sequence number > after is available, and returns a view on the newest one.
+       * @param timeoutMs maximum time to wait (<0 waits forever)
+       * @return false on timeout
+       */
+      bool waitNewer(uint64_t after, FrameView& view, int timeoutMs=-1) const;
+
+      /** Sequence number of the newest published frame (0 if none) */
+      uint64_t lastSeq() const;
+
+      /** Tells whether the segment called name is not this one anymore (e.g. the streamer has been restarted, or has
+       * gone away), so that the frames of the current producer can only be read by opening it again
+       */
+      bool replaced() const;
+
+    private:
+      struct Slot;
+      struct Header;
+
+      bool view(uint64_t seq, FrameView& v) const;
+      Slot& slot(uint64_t seq) const;
+
+      std::string _name;
+      Mode _mode;
+      size_t _size;
+      Header* _header;
+      /** Identity of the segment which has been opened */
+      uint64_t _device;
+      uint64_t _inode;
+  };
+}
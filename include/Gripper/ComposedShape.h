@@ -10,6 +10,10 @@ namespace Gripper{
       virtual PointsMatrix getCubettiVolume(size_t level) const override;
       virtual PointsMatrix getCubettiSurface(size_t level) const override;
       virtual double getIntersectionVolume(const Shape& s) const override;
+      virtual bool intersects(const Shape& s) const override;
+      virtual Eigen::AlignedBox3d getLocalBounds() const override;
+      virtual double getSignedDistance(const Eigen::Vector3d& p) const override;
+      virtual PointsMatrix getWeightedCubettiVolume(size_t level, std::vector<double>& weights) const override;
 
       virtual void writeTo(cv::FileStorage& fs) const;
      
@@ -21,7 +25,7 @@ namespace Gripper{
       
     protected:
       virtual std::string getID() const;
-      virtual KnownIntersections getKnownIntersections() const;
+      virtual Type getType() const override;
       
       Components _components;
   };
@@ -7,13 +7,17 @@ namespace Gripper{
       Cuboid(Eigen::Affine3d pose, double W, double H, double D);
       virtual ~Cuboid();
       virtual Shape* clone() const override;
+      virtual Type getType() const override;
+      virtual Eigen::AlignedBox3d getLocalBounds() const override;
+      virtual double getSignedDistance(const Eigen::Vector3d& p) const override;
       
     protected:
       virtual std::string getID() const override;
-      virtual PointsMatrix getCubettiSurface(size_t level) const override;
-      virtual PointsMatrix getCubettiVolume(size_t level) const override;
       virtual double getVolume() const override;
-      virtual size_t countContainedPoints(const Cuboid::PointsMatrix& pt) const override;
+      virtual Samples::Ptr getUnitSurface(size_t level) const override;
+      virtual Samples::Ptr getUnitVolume(size_t level) const override;
+      virtual Eigen::Affine3d getUnitToWorld() const override;
+      virtual Samples::Containment getContainment() const override;
 
     private:
       double W() const ;
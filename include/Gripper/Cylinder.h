@@ -9,14 +9,18 @@ namespace Gripper{
       Cylinder(Eigen::Affine3d pose, double R, double H);
       virtual ~Cylinder();
 
-      virtual PointsMatrix getCubettiSurface(size_t level) const override;
-      virtual PointsMatrix getCubettiVolume(size_t level) const override;
       virtual std::string getID() const override;
+      virtual Type getType() const override;
+      virtual Eigen::AlignedBox3d getLocalBounds() const override;
+      virtual double getSignedDistance(const Eigen::Vector3d& p) const override;
       virtual double getVolume() const override;
 
       virtual Shape* clone() const override;
 
     protected:
-      virtual size_t countContainedPoints(const PointsMatrix& pt) const override;
+      virtual Samples::Ptr getUnitSurface(size_t level) const override;
+      virtual Samples::Ptr getUnitVolume(size_t level) const override;
+      virtual Eigen::Affine3d getUnitToWorld() const override;
+      virtual Samples::Containment getContainment() const override;
   };
 }
@@ -0,0 +1,59 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <Eigen/Geometry>
+#include "Shape.h"
+
+namespace Gripper{
+  /** Voxelized signed distance field of a set of shapes (the union of them), sampled on a regular grid over a region.
+   * Each voxel also remembers the shape it is nearest to, so that shapes can be removed touching only the voxels they owned,
+   * and so that a penetration can be charged to the right shape.
+   * Points outside the region take the value of the nearest voxel.
+   */
+  class DistanceField{
+    public:
+      typedef int Id;
+      static constexpr Id NONE=-1;
+
+      DistanceField(const Eigen::AlignedBox3d& region, double voxelSize);
+
+      /** Adds a shape (already posed in the frame of the region) with the weight given to its penetrations */
+      Id add(const Shape::Ptr& shape, double weight);
+
+      /** Removes a shape, recomputing only the voxels it was the nearest one for */
+      void remove(Id id);
+
+      /** Trilinearly interpolated signed distance */
+      double distance(const Eigen::Vector3d& p) const;
+
+      /** Shape which is the nearest to p, or NONE if the field is empty */
+      Id owner(const Eigen::Vector3d& p) const;
+
+      double weight(Id id) const;
+
+      /** Upper bound for the ids which have been given out */
+      size_t ids() const;
+
+      const Eigen::AlignedBox3d& region() const;
+
+    private:
+      Eigen::AlignedBox3d _region;
+      double _voxelSize;
+      Eigen::Vector3i _size;
+
+      /** Value of the voxels which are not near to anything */
+      float _far;
+
+      std::vector<float> _distance;
+      std::vector<Id> _owner;
+
+      /** Indexed by Id; removed shapes are null */
+      std::vector<Shape::Ptr> _shapes;
+      std::vector<double> _weights;
+
+      size_t index(int x, int y, int z) const;
+      Eigen::Vector3d center(int x, int y, int z) const;
+      /** Position of p in voxel coordinates, clamped to the grid */
+      Eigen::Vector3d toGrid(const Eigen::Vector3d& p) const;
+  };
+}
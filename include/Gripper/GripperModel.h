@@ -1,10 +1,14 @@
 #pragma once
 
+#include <functional>
+#include <ostream>
 #include <utility>
 #include "Types.h"
 #include "GraspPose.h"
 #include "Grasper.h"
 #include "Shape.h"
+#include "SceneIndex.h"
+#include "DistanceField.h"
 
 namespace Gripper{
   class GripperModel{
@@ -12,6 +16,8 @@ namespace Gripper{
       GripperModel(const std::vector<Eigen::Affine3d> poses, Eigen::Affine3d base, const Shape::Ptr& shape);
       GripperModel();
       std::pair<double, Eigen::Affine3d> getBestGrasp(const std::string& name, const ObjectsScene& scene, const ObjectDB& objects);
+      /** Same as above, but collisions are looked up into a precomputed distance field (which must contain the scene) instead of intersecting the shapes */
+      std::pair<double, Eigen::Affine3d> getBestGrasp(const std::string& name, const ObjectsScene& scene, const ObjectDB& objects, const DistanceField& field);
       Shape::Ptr shape();
 
     private:
@@ -28,7 +34,35 @@ namespace Gripper{
       Eigen::Affine3d _basePose;
 
       Shape::Ptr _myShape;
+
+      /** Bounds of _myShape in the gripper's frame, for the broad phase */
+      Eigen::AlignedBox3d _myBounds;
+      Eigen::Vector3d _myBoundingCenter;
+      double _myBoundingRadius;
+
       static double scoreFunction(double intVol);
+
+      /** Volume samples of _myShape in the gripper's frame (and the volume each of them stands for), looked up into distance fields */
+      static constexpr size_t FIELD_SAMPLES_LEVEL=10;
+      Shape::PointsMatrix _fieldSamples;
+      std::vector<double> _fieldSampleWeights;
+
+      /** Scores the arm pose (in the object's frame) for the object at objectPose; returns false if cancelled() became true before the scoring was complete */
+      typedef std::function<bool(const Eigen::Affine3d& objectPose, const Eigen::Affine3d& armPose, const std::function<bool()>& cancelled, double& score)> Scorer;
+
+      /** Pose of the arm, in the object's frame, which applies the grasp pose to the object at objectPose; the steps are written to log, unless it is null */
+      Eigen::Affine3d fitArmPose(const GraspPose& pose, const Eigen::Affine3d& objectPose, std::ostream* log) const;
+
+      /** Only the objects of the scene which the index can't rule out are intersected with the gripper */
+      bool scoreAgainstScene(const Eigen::Affine3d& objectPose, const Eigen::Affine3d& armPose, const ObjectsScene& scene, const SceneIndex& index, const ObjectDB& objDB, const std::function<bool()>& cancelled, double& score) const;
+
+      /** Looks up the gripper's samples, with the gripper at grasp (in global coordinates), into the field */
+      bool scoreAgainstField(const Eigen::Affine3d& grasp, const DistanceField& field, double& score) const;
+
+      /** Number of (pose, object) candidates evaluated in parallel before the generator is asked for more poses (and refined) */
+      static constexpr size_t BATCH_CANDIDATES=64;
+
+      std::pair<double, Eigen::Affine3d> searchBestGrasp(const std::string& name, const ObjectsScene& scene, const ObjectDB& objDB, const Scorer& scorer) const;
   };
 }
 
@@ -0,0 +1,37 @@
+#pragma once
+#include "Shape.h"
+
+namespace Gripper{
+  /** Specialized intersection routines for pairs of primitive shapes.
+   * Overlap tests are closed-form (or separating-axis based), and volumes are either closed-form,
+   * numerically integrated over slices, or sampled only inside a tight bound of the overlapping region.
+   * Routines are looked up in a table indexed by Shape::Type which is filled at compile time; pairs without
+   * an entry fall back to plain point sampling (see Shape::getIntersectionVolume).
+   */
+  class Intersections{
+    public:
+      typedef bool (*OverlapFunction)(const Shape& a, const Shape& b);
+      typedef double (*VolumeFunction)(const Shape& a, const Shape& b);
+
+      struct Kernel{
+        OverlapFunction overlap;
+        VolumeFunction volume;
+      };
+
+      /** Returns the routines for the pair (a, b), or nullptr if there are none */
+      static const Kernel* find(Shape::Type a, Shape::Type b);
+
+      /** Estimates the intersection volume by sampling level^3 points, but only inside the intersection between
+       * the bounds of a shape and the bounds of the other one, expressed in the first shape's frame.
+       */
+      static double sampledVolume(const Shape& a, const Shape& b, size_t level=BOUNDED_APPROX_LEVEL);
+
+      static constexpr size_t BOUNDED_APPROX_LEVEL=24;
+
+      /** Number of slices used when integrating the volumes of round shapes */
+      static constexpr size_t INTEGRATION_SLICES=64;
+
+    private:
+      static const Kernel TABLE[Shape::N_TYPES][Shape::N_TYPES];
+  };
+}
@@ -1,6 +1,7 @@
 #pragma once
 #include "Shape.h"
 #include "GraspPose.h"
+#include "PoseFactory.h"
 
 namespace Gripper{
   struct Object{
@@ -9,12 +10,24 @@ namespace Gripper{
 
       Object();
       Object(const std::shared_ptr<const Shape>&, const GraspSet&, double);
+      Object(const std::shared_ptr<const Shape>&, const PoseFactory::Generator::Ptr&, double);
 
       Shape::Ptr myShape;
-      GraspSet myGrasps;
+      /** Never consumed directly: every search works on its own myGraspSource->restart() */
+      PoseFactory::Generator::Ptr myGraspSource;
       double myMobility;
+
+      /** Bounds of myShape in the object's frame, cached for the broad phase of the grasp scoring (see SceneIndex).
+       * With the object's pose applied the box is an oriented bounding box, while the sphere is invariant to rotations.
+       */
+      Eigen::AlignedBox3d myBounds;
+      Eigen::Vector3d myBoundingCenter;
+      double myBoundingRadius;
       static Object readFrom(const cv::FileNode& fs);
 
+    private:
+      void initBounds();
+
   };
 }
 
@@ -1,12 +1,52 @@
 #pragma once
+#include <memory>
+#include <vector>
 #include <Eigen/Core>
 #include <Gripper/GraspPose.h>
 
 namespace Gripper{
   namespace PoseFactory{
-    std::vector<GraspPose> generatePosesOnLine(size_t level, const Eigen::Vector3d& p1, const Eigen::Vector3d& p2, const Eigen::Vector3d& planeVector, int toolNumber);
-    std::vector<GraspPose> generatePosesOnPlane(size_t level, const Eigen::Vector3d& origin, const Eigen::Vector3d& width, const Eigen::Vector3d& height, int toolNumber);
-    std::vector<GraspPose> generatePosesOnCuboid(size_t level, const Eigen::Affine3d& pose, double width, double height, double depth, int toolNumber);
+    /** A source of grasp poses which yields them on demand, in increasing preferenceScore order (the preferred ones first).
+     * Only the poses which are actually asked for are built, so a search which stops early doesn't pay for the others.
+     */
+    class Generator{
+      public:
+        typedef std::shared_ptr<Generator> Ptr;
+
+        virtual ~Generator(){}
+
+        /** Score of the pose next() would yield, +infinity when there are no more poses */
+        virtual double peekScore() const=0;
+
+        /** Returns false when there are no more poses */
+        virtual bool next(GraspPose& pose)=0;
+
+        /** Adds a few samples around a pose yielded by this generator (it is ignored otherwise), halfway between it and
+         * its neighbours; they are yielded in order together with the other poses. Refining a refined sample halves the
+         * spacing again, up to MAX_REFINEMENT times.
+         */
+        virtual void refine(const GraspPose& pose){}
+
+        /** A new generator over the same poses, which starts again from the preferred one */
+        virtual Ptr restart() const=0;
+
+        static constexpr int MAX_REFINEMENT=2;
+    };
+
+    /** level poses, equally spaced from p1 toward p2 */
+    Generator::Ptr posesOnLine(size_t level, const Eigen::Vector3d& p1, const Eigen::Vector3d& p2, const Eigen::Vector3d& planeVector, int toolNumber);
+    /** level x level poses, equally spaced over the parallelogram at origin with sides width and height */
+    Generator::Ptr posesOnPlane(size_t level, const Eigen::Vector3d& origin, const Eigen::Vector3d& width, const Eigen::Vector3d& height, int toolNumber);
+    /** The poses on the 6 faces of the cuboid, leaving a margin on the border of each face */
+    Generator::Ptr posesOnCuboid(size_t level, const Eigen::Affine3d& pose, double width, double height, double depth, int toolNumber);
+    /** A fixed set of poses, e.g. custom ones */
+    Generator::Ptr posesFromList(const std::vector<GraspPose>& poses);
+
+    /** Yields the poses of all the sources in a single increasing order */
+    Generator::Ptr merge(const std::vector<Generator::Ptr>& sources);
+
+    /** All the (remaining) poses of the generator, in order */
+    std::vector<GraspPose> drain(Generator& generator);
   }
 
 }
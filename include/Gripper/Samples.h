@@ -0,0 +1,38 @@
+#pragma once
+#include <memory>
+#include <Eigen/Core>
+#include <Eigen/Geometry>
+
+namespace Gripper{
+  /** Sample sets used to approximate shapes, and single precision containment tests over them.
+   * Samples are generated once per (kind, level) in the unit frame of the primitive (unit cube, unit sphere,
+   * unit cylinder) and shared by every shape: a shape only needs the transformation from the unit frame to the world.
+   */
+  namespace Samples{
+    /** Structure of arrays: each row (x, y, z) is contiguous */
+    typedef Eigen::Array<float, 3, Eigen::Dynamic, Eigen::RowMajor> Set;
+    typedef std::shared_ptr<const Set> Ptr;
+
+    enum Kind { CUBE_SURFACE, CUBE_VOLUME, SPHERE_SURFACE, SPHERE_VOLUME, CYLINDER_SURFACE, CYLINDER_VOLUME, N_KINDS };
+
+    /** Unit cube is [0,1]^3, unit sphere is centered in the origin with radius 1,
+     * unit cylinder has radius 1 and goes from z=0 to z=1.
+     * The set is built at the first request and cached; this is thread safe.
+     */
+    Ptr get(Kind kind, size_t level);
+
+    /** A primitive as seen from its unit frame: a world point p is inside iff toUnit*p is inside the unit primitive */
+    struct Containment{
+      enum Primitive { UNIT_CUBE, UNIT_SPHERE, UNIT_CYLINDER } primitive;
+      Eigen::Affine3d toUnit;
+    };
+
+    /** Number of points of pts (transformed to the world by ptsToWorld) inside the primitive.
+     * Transformation and test are fused in a single pass, without temporaries.
+     */
+    size_t countContained(const Set& pts, const Eigen::Affine3d& ptsToWorld, const Containment& c);
+
+    /** Number of points inside both the primitives */
+    size_t countContained(const Set& pts, const Eigen::Affine3d& ptsToWorld, const Containment& c1, const Containment& c2);
+  }
+}
@@ -0,0 +1,43 @@
+#pragma once
+#include <vector>
+#include <Eigen/Geometry>
+#include "Grasper.h"
+#include "Types.h"
+
+namespace Gripper{
+  /** Broad phase for the intersections against a scene: a small AABB tree over the (world) bounds of the objects.
+   * The bounds come from the ones cached into the object database, so building the index never touches the shapes.
+   */
+  class SceneIndex{
+    public:
+      SceneIndex(const ObjectsScene& scene, const ObjectDB& objDB);
+
+      /** Indices (into the scene, in increasing order) of the objects whose bounds may overlap the given box and sphere */
+      void query(const Eigen::AlignedBox3d& box, const Eigen::Vector3d& center, double radius, std::vector<size_t>& result) const;
+
+      size_t size() const;
+
+    private:
+      struct Node{
+        Eigen::AlignedBox3d box;
+        /** Children for inner nodes, -1 for leaves */
+        int left, right;
+        /** Range of _order covered by the node */
+        size_t begin, end;
+      };
+
+      struct Item{
+        Eigen::AlignedBox3d box;
+        Eigen::Vector3d center;
+        double radius;
+      };
+
+      static constexpr size_t LEAF_SIZE=2;
+
+      int build(size_t begin, size_t end);
+
+      std::vector<Item> _items;
+      std::vector<size_t> _order;
+      std::vector<Node> _nodes;
+  };
+}
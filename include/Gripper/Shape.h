@@ -5,11 +5,17 @@
 #include <Eigen/Geometry>
 #include <opencv2/core/core.hpp>
 #include <opencv2/core/operations.hpp>
+#include "Samples.h"
 
 namespace Gripper{
+  class Intersections;
+
   /** Empty shape */
   class Shape {
     public:
+      /** Tag used to dispatch pairwise routines (see Intersections) without going through getID() strings */
+      enum Type { GENERIC, CUBOID, SPHERE, CYLINDER, COMPOSED, N_TYPES };
+
       typedef Eigen::Affine3d RelPose;
       typedef pcl::PointXYZ PointType;
       typedef pcl::PointCloud<PointType> Points;
@@ -19,42 +25,55 @@ namespace Gripper{
 
       Shape(const RelPose& pose, const std::vector<double>& dims);
 
-      virtual PointsMatrix getCubettiSurface(size_t level) const = 0;
-      virtual PointsMatrix getCubettiVolume(size_t level) const = 0;
+      virtual PointsMatrix getCubettiSurface(size_t level) const;
+      virtual PointsMatrix getCubettiVolume(size_t level) const;
+      /** Same as getCubettiVolume, also telling the volume represented by each point (it is not uniform for composed shapes) */
+      virtual PointsMatrix getWeightedCubettiVolume(size_t level, std::vector<double>& weights) const;
       virtual double getIntersectionVolume(const Shape& s) const;
+      /** Tells whether the two shapes share some volume, which is usually much cheaper than computing it */
+      virtual bool intersects(const Shape& s) const;
       virtual RelPose getPose() const final;
       virtual const std::vector<double>& getDimensions() const final;
       virtual PointsPtr getPCSurface(size_t level) const final;
       virtual PointsPtr getPCVolume(size_t level) const final;
       virtual std::string getID() const;
+      virtual Type getType() const;
+      /** Axis-aligned bounding box of the shape in its own frame (i.e. not considering the pose) */
+      virtual Eigen::AlignedBox3d getLocalBounds() const;
+      /** Axis-aligned bounding box of the posed shape, i.e. in the frame the pose is relative to */
+      Eigen::AlignedBox3d getBounds() const;
       virtual double getVolume() const = 0;
+      /** Signed distance of p (expressed in the frame the pose is relative to) from the surface, negative inside */
+      virtual double getSignedDistance(const Eigen::Vector3d& p) const;
       virtual void writeTo(cv::FileStorage& fs) const;
       virtual Shape* clone() const = 0;
 
       virtual ~Shape();
 
     protected:
-      typedef std::vector<std::string> KnownIntersections;
-      typedef std::vector<std::string> ShapeList;
       std::vector<double> _dimensions;
       Eigen::Affine3d _pose;
       friend Shape::Ptr operator*(const Eigen::Affine3d& lhs, const Shape::Ptr& rhs);
-      virtual size_t countContainedPoints(const PointsMatrix& pt) const ;
+      friend class Intersections;
 
-      virtual ShapeList intersectionHeuristic() const ;
-      virtual ShapeList noIntersectionHeuristic() const ;
+      /** Approximations of the shape in its unit frame (see Samples), shared by all the shapes of the same kind */
+      virtual Samples::Ptr getUnitSurface(size_t level) const;
+      virtual Samples::Ptr getUnitVolume(size_t level) const;
+      /** Transformation from the unit frame of the samples to the world */
+      virtual Eigen::Affine3d getUnitToWorld() const;
+      virtual Samples::Containment getContainment() const;
 
-      virtual bool haveIntersectionHeuristic(const Shape& s) const final;
-      virtual bool haveNoIntersectionHeuristic(const Shape& s) const final;
-
-      virtual double intersectionVolumeHeuristic(const Shape& s) const;
-      virtual double haveNoIntersection(const Shape& s) const;
+      /** Number of points (transformed to the world by ptsToWorld) contained into the shape */
+      size_t countContainedPoints(const Samples::Set& pts, const Eigen::Affine3d& ptsToWorld) const;
 
       static constexpr size_t BASE_APPROX_LEVEL=100;
   };
 
   Shape::Ptr operator*(const Eigen::Affine3d& lhs, const Shape::Ptr& rhs);
 
+  /** Axis-aligned box containing the given box once transformed by pose */
+  Eigen::AlignedBox3d transformBounds(const Eigen::Affine3d& pose, const Eigen::AlignedBox3d& b);
+
 }
 
 namespace cv{
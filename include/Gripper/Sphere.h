@@ -6,17 +6,16 @@ namespace Gripper{
     public:
       Sphere(const RelPose& pose, double R);
       virtual std::string getID() const override;
+      virtual Type getType() const override;
+      virtual Eigen::AlignedBox3d getLocalBounds() const override;
+      virtual double getSignedDistance(const Eigen::Vector3d& p) const override;
     protected:
-      virtual double haveNoIntersection(const Shape& s) const override;
-      virtual double intersectionVolumeHeuristic(const Shape& s) const override;
-      virtual PointsMatrix getCubettiSurface(size_t level) const override;
-      virtual Eigen::Matrix<double, 4, Eigen::Dynamic>  getCubettiVolume(size_t level) const override;
       virtual double getVolume() const override;
+      virtual Samples::Ptr getUnitSurface(size_t level) const override;
+      virtual Samples::Ptr getUnitVolume(size_t level) const override;
+      virtual Eigen::Affine3d getUnitToWorld() const override;
+      virtual Samples::Containment getContainment() const override;
 
-      virtual ShapeList intersectionHeuristic() const override;
-      virtual ShapeList noIntersectionHeuristic() const override;
-
-      virtual size_t countContainedPoints(const Shape::PointsMatrix& pt) const override;
       virtual Shape* clone() const override;
   };
 };
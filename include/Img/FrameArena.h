@@ -0,0 +1,69 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+namespace Img{
+  /** Memory for the temporaries of a frame.
+   * While a Scope is alive on a thread, the cv::Mat allocated by that thread (by the code of the program or by OpenCV)
+   * take their memory from an arena instead of the heap: allocating is just moving a pointer forward, and the arena is
+   * reset when the outermost Scope ends, so that the next frame reuses the same memory. Arenas only grow, up to what
+   * the biggest frame needs, and are never given back to the system: once warmed up, a frame makes no heap allocation
+   * for its matrices. Everything else (e.g. point clouds and std::vector) still comes from the heap.
+   * Matrices can outlive the frame (e.g. kept by a viewer): the part of the arena they are in is just not reused until
+   * all of them are released, from whatever thread.
+   */
+  class FrameArena{
+    public:
+      /** Binds an arena, taken from a pool shared by all the threads, to the calling thread for its lifetime. Scopes
+       * nest: inner ones use the arena of the outermost, which is reset and given back to the pool when it ends.
+       */
+      class Scope{
+        public:
+          Scope();
+          ~Scope();
+
+        private:
+          Scope(const Scope&)=delete;
+          void operator=(const Scope&)=delete;
+
+          FrameArena* _arena;
+      };
+
+      /** Part of an arena, holding a count of the blocks still in use */
+      struct Chunk;
+
+      /** Alignment of every block */
+      static const size_t ALIGNMENT=64;
+
+      /** The arena bound to the calling thread, or nullptr outside of a Scope */
+      static FrameArena* current();
+
+      /** A block of size bytes, valid until it is given back to release: chunk is set to what release needs */
+      void* allocate(size_t size, Chunk*& chunk);
+
+      /** Gives a block back, from any thread */
+      static void release(Chunk* chunk);
+
+      /** Makes the memory of the chunks with no block in use available again */
+      void reset();
+
+      /** Bytes reserved from the system by this arena */
+      size_t capacity() const;
+
+      /** Number of chunks taken from the heap by all the arenas so far: it stops growing once they are warmed up */
+      static size_t chunkAllocations();
+
+      ~FrameArena();
+
+    private:
+      FrameArena();
+      FrameArena(const FrameArena&)=delete;
+      void operator=(const FrameArena&)=delete;
+
+      std::vector<std::unique_ptr<Chunk>> _chunks;
+      /** The first chunk which may still have room */
+      size_t _current;
+  };
+}
@@ -1,8 +1,106 @@
-#include <iostream>
-#error "DO NOT INCLUDE THIS FILE (IT IS BULLSHIT FOR NOW)."
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <ostream>
+#include <string>
 
+/** Leveled logging, written asynchronously.
+ * Messages are streamed as usual:
+ *
+ *   Log::Module& icpLog=Log::module("icp");
+ *   LOG(icpLog, DEBUG) << "iteration " << i << ": " << error;
+ *
+ * Messages below LOG_LEVEL (a compile-time constant, e.g. -DLOG_LEVEL=INFO, the default with NDEBUG) are
+ * removed by the compiler, arguments included; the others are formatted only if their module is enabled for them (see
+ * configure), and are then handed to a background thread which stamps, writes and flushes them (to stderr): the calling
+ * thread never waits for the output. If the writer can't keep up, messages are dropped (and counted) rather than blocking.
+ */
 namespace Log{
-  typedef out std::ostream;
+  enum Level{
+    TRACE,
+    DEBUG,
+    INFO,
+    WARNING,
+    ERROR
+  };
 
+#ifndef LOG_LEVEL
+#ifdef NDEBUG
+#define LOG_LEVEL INFO
+#else
+#define LOG_LEVEL TRACE
+#endif
+#endif
 
+  constexpr bool compiled(Level level){
+    return level>=LOG_LEVEL;
+  }
+
+  const char* levelName(Level level);
+
+  /** Messages of a part of the program, with their own level: modules live as long as the program, so they can be kept by reference */
+  class Module{
+    public:
+      const char* name() const {
+        return _name.c_str();
+      }
+
+      bool enabled(Level level) const {
+        return level>=_level.load(std::memory_order_relaxed);
+      }
+
+      void setLevel(Level level){
+        _level=level;
+      }
+
+    private:
+      Module(const std::string& name, Level level);
+      Module(const Module&)=delete;
+      void operator=(const Module&)=delete;
+
+      const std::string _name;
+      std::atomic<int> _level;
+
+      friend Module& module(const std::string& name);
+  };
+
+  /** The module with that name, created on first use with the level given by configure (INFO by default) */
+  Module& module(const std::string& name);
+
+  /** Sets the levels from a comma-separated list of level names, each one either alone (for all the modules) or after
+   * the name of a module and '=', e.g. "info,icp=debug": later items win. The APC_LOG environment variable is applied
+   * at start. Throws std::invalid_argument if a level is unknown.
+   */
+  void configure(const std::string& levels);
+
+  /** Blocks until everything logged so far has been written */
+  void flush();
+
+  /** Number of messages dropped so far because the writer was late */
+  size_t dropped();
+
+  /** A message being built: it is sent when destroyed, i.e. at the end of the LOG statement */
+  class Line{
+    public:
+      Line(const Module& module, Level level);
+      ~Line();
+
+      std::ostream& stream();
+
+    private:
+      Line(const Line&)=delete;
+      void operator=(const Line&)=delete;
+
+      class Buffer;
+      const Module& _module;
+      const Level _level;
+      Buffer* _buffer;
+      /** Only for messages logged while building another one on the same thread */
+      std::unique_ptr<Buffer> _nested;
+  };
 }
+
+#define LOG(module, level) \
+  if(!Log::compiled(Log::level) || !(module).enabled(Log::level)) {} \
+  else Log::Line(module, Log::level).stream()
@@ -1,51 +1,77 @@
 #pragma once
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
 #include <Img/Image.h>
 #include <Camera/ImageViewer.h>
 #include <APC/Order.h>
 #include <C5G/Pose.h>
 
 namespace InterProcessCommunication{
+  /** State of the shelf shared by perception, planning and UI threads.
+   * Each bin is published as an immutable snapshot: readers take a reference to the current one and never wait for a
+   * writer, while writers copy it, change the copy and publish it in place of the old one (one writer per bin at a time).
+   * Readers needing more than one field of a bin shall use getBin, so that all of them come from the same version.
+   */
   class RobotData {
     public:
       typedef Img::Image Image;
+      /** Photos are never changed once taken: all the readers share the same one */
+      typedef std::shared_ptr<const Image> PhotoPtr;
       static const int ROW_N=4;
       static const int COL_N=3;
+      static const int MAX_ITEM_N=6;
+
+      struct Bin {
+        std::string object[MAX_ITEM_N];
+        C5G::Pose objPose[MAX_ITEM_N];
+        bool dirty;
+        /** Incremented at every change of the items of the bin or of their poses; results computed from them stay valid as long as it doesn't change */
+        unsigned long version;
+        PhotoPtr photo;
+        /** Taken by the right camera together with photo, if the robot has one: null otherwise */
+        PhotoPtr rightPhoto;
+      };
+      typedef std::shared_ptr<const Bin> BinSnapshot;
+
       static Camera::ImageViewer demoViewer;
       static RobotData& getInstance();
-      std::string getBinItem(int row, int column, int item);
+
+      /** Current state of the bin, which won't change anymore */
+      BinSnapshot getBin(int row, int column) const;
+      /** Applies f to a copy of the bin and publishes it: readers see either all of the changes or none */
+      void updateBin(int row, int column, const std::function<void(Bin&)>& f);
+
+      std::string getBinItem(int row, int column, int item) const;
       void setBinItem(int row,int column,int item,const std::string& val);
-      bool isDirty(int row, int column);
+      bool isDirty(int row, int column) const;
+      unsigned long getBinVersion(int row, int column) const;
       void setDirty(int row, int column, bool value=true);
-      APC::OrderStatus getWorkOrder();
+      APC::OrderStatus getWorkOrder() const;
       void setWorkOrder(int row,int column,const std::string& itemName);
       C5G::Pose getObjPose(int row, int column, int item) const;
       void setObjPose(int row,int column,int item,const C5G::Pose& val);
+      /** The frame is shared, not copied: it must not be changed afterwards */
       void setPhoto(int row, int column, const Image& frame);
-      Image getFrame(int row, int column);
-      Image getPhoto(int row, int column);
+      /** Photos of the left and of the right camera, taken at the same time: the same as setPhoto for both */
+      void setPhotos(int row, int column, const Image& left, const Image& right);
+      PhotoPtr getFrame(int row, int column) const;
+      PhotoPtr getPhoto(int row, int column) const;
       static std::string xyToName(int row, int column);
-      int getCurrentRow();
-      int getCurrentColumn();
+      int getCurrentRow() const;
+      int getCurrentColumn() const;
       void setCurrentRow(int row);
       void setCurrentColumn(int column);
       friend std::ostream& operator<< (std::ostream& os, const RobotData& r);
-      static const int MAX_ITEM_N=6;
       static Image getImageFrame();
 
     private:
-      struct Bin {
-        std::string object[MAX_ITEM_N];
-        bool dirty;
-        Image photo;
-        C5G::Pose objPose[MAX_ITEM_N];
-        friend std::ostream& operator<< (std::ostream& os, const InterProcessCommunication::RobotData r);
-      };
-      struct Shelf {
-        Bin bins[12];
-      };
+      BinSnapshot _bins[ROW_N*COL_N];
+      std::mutex _binWriters[ROW_N*COL_N];
 
-      Shelf shelf;
-      APC::OrderStatus workOrder;
+      std::shared_ptr<const APC::OrderStatus> _workOrder;
+      std::mutex _workOrderWriter;
 
       /** Returns the index of the bin (into the internal array) corresponding to the (row, column) coordinate */
       static int xyToBin(int row, int column);
@@ -56,8 +82,6 @@ namespace InterProcessCommunication{
       void operator=(RobotData const&); // Don't implement
       RobotData(RobotData const&);              // Don't Implement
 
-      int _row, _column;
-    public:
-      Bin getBinItems(int row, int column);
+      std::atomic<int> _row, _column;
   };
 }
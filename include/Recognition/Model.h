@@ -6,6 +6,7 @@
 #include <Recognition/db_linemod.h>
 #include <Recognition/linemod_icp.h>
 #include <Recognition/Renderer3d.h>
+#include <Recognition/PackedTemplates.h>
 #include <Camera/CameraModel.h>
 #include <pcl/point_cloud.h>
 #include <pcl/point_types.h>
@@ -38,7 +39,8 @@ namespace Recognition{
 
       template<typename T>
         inline std::vector<T> readSequence(const cv::FileNode& n);
-      cv::Ptr<Detector> _detector;
+      /** The only copy of the templates: detectors are only built to extract new ones, to match or to save */
+      PackedTemplates _templates;
       std::string _detectorType;
       Renderer3d& _renderer;
       std::unordered_map<int, TrainingData> _myData;
@@ -60,7 +62,7 @@ namespace Recognition{
       /** Gets all the templates matching a certain template ID */
       const std::vector<cv::linemod::Template> getTemplates(int templateID) const;
 
-      /** Gets all the templates of this model, for each template ID */
+      /** Adds all the templates of this model to det, in template ID order */
       void addAllTemplates(Detector& det) const;
 
       /** Loads this model from YML data taken from a folder */
@@ -68,6 +70,12 @@ namespace Recognition{
 
       void saveToDirectory(const boost::filesystem::path& saveDir) const;
 
+      /** Saves into saveDir the templates of the trainings of id saved into trainDirs (those which have one), one training
+       * after the other: template IDs are the same as if all of them had been added to the same model in that order.
+       * Nothing is rendered. Returns the number of templates.
+       */
+      static int mergeTrainings(const std::string& id, const std::vector<boost::filesystem::path>& trainDirs, const boost::filesystem::path& saveDir);
+
       void render(const Eigen::Affine3f& pose, cv::Mat& rgb_out, cv::Mat& depth_out, cv::Mat& mask_out, cv::Rect& rect_out) const;
       void render(const Eigen::Affine3d& pose, cv::Mat& rgb_out, cv::Mat& depth_out, cv::Mat& mask_out, cv::Rect& rect_out) const;
       void render(const C5G::Pose& pose, cv::Mat& rgb_out, cv::Mat& depth_out, cv::Mat& mask_out, cv::Rect& rect_out) const;
@@ -99,6 +107,8 @@ namespace Recognition{
       double getZc(int templateID) const;
       void initializeMyPCL();
       int numTemplates() const;
+      /** Bytes the templates of the model take into a detector (see PackedTemplates::unpackedMemoryUsage) */
+      size_t detectorMemoryUsage() const;
       pcl::PointCloud<pcl::PointXYZRGB>::ConstPtr getPointCloud() const;
       pcl::PointCloud<pcl::PointXYZRGB>::ConstPtr getPointCloud(const Eigen::Affine3d& pose) const;
       pcl::PointCloud<pcl::PointXYZRGB>::ConstPtr getWholePointCloud(const C5G::Pose& pose) const;
@@ -0,0 +1,64 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <opencv2/rgbd.hpp>
+
+namespace Recognition{
+  /** The LINE-MOD templates of a model, stored compactly.
+   * cv::linemod keeps each template as its own vector of int (x, y, label) features, i.e. 12 bytes per feature plus an
+   * allocation per template; here the features of all the templates of the same pyramid level are kept together, one
+   * array per field (x and y as 16 bits offsets into the template, labels as bytes: they are 3 bits), and each template
+   * is just a header pointing into them. Templates are added by pyramid, as made by the detector, and keep their order.
+   */
+  class PackedTemplates{
+    public:
+      PackedTemplates();
+
+      /** Adds the templates of a pyramid (all the modalities and levels, as returned by Detector::getTemplates) and
+       * returns its template ID. Throws std::invalid_argument if it doesn't have as many templates as the previous ones,
+       * std::out_of_range if a feature doesn't fit.
+       */
+      int add(const std::vector<cv::linemod::Template>& pyramid);
+
+      /** Number of pyramids, i.e. of template IDs */
+      int size() const;
+
+      /** The templates of the pyramid templateID, in the detector's format: throws std::out_of_range if there is none */
+      std::vector<cv::linemod::Template> get(int templateID) const;
+
+      /** Adds all the pyramids to the detector, in order, as templates of classID */
+      void addTo(cv::linemod::Detector& detector, const std::string& classID) const;
+
+      /** Frees the memory reserved for pyramids not added yet */
+      void shrinkToFit();
+
+      /** Bytes used, headers included */
+      size_t memoryUsage() const;
+
+      /** Bytes the templates take once added to a detector, which keeps every feature on its own */
+      size_t unpackedMemoryUsage() const;
+
+    private:
+      struct Header{
+        uint16_t width;
+        uint16_t height;
+        uint8_t level;
+        /** Index of the first feature into the arrays of the level */
+        uint32_t first;
+        uint32_t size;
+      };
+
+      /** Features of all the templates of a pyramid level */
+      struct Level{
+        std::vector<uint16_t> x;
+        std::vector<uint16_t> y;
+        std::vector<uint8_t> label;
+      };
+
+      int _perPyramid;
+      std::vector<Header> _headers;
+      std::vector<Level> _levels;
+  };
+}
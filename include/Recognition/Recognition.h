@@ -1,5 +1,13 @@
+#include <string>
 #include <C5G/Pose.h>
 namespace Recognition{
   C5G::Pose recognizeBalls(int row, int column);
   void updateGiorgio(int row, int column);
+
+  /** From now on, updateGiorgio recognizes the objects of the bins photographed by both cameras from the two photos
+   * at once (see RecognitionData::recognize), with the models trained into trainPath and the "left" and "right"
+   * camera models of camerasFile, whose extrinsics place both cameras into the same frame.
+   * Throws std::runtime_error if they can't be loaded; to be called before any recognition has started.
+   */
+  void setStereoRecognition(const std::string& trainPath, const std::string& camerasFile);
 }
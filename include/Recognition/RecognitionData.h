@@ -1,4 +1,8 @@
 #pragma once
+#include <list>
+#include <memory>
+#include <mutex>
+#include <set>
 #include <unordered_map>
 #include <opencv2/opencv.hpp>
 #include <pcl/point_types.h>
@@ -21,6 +25,17 @@ namespace Recognition{
       };
 
       typedef std::map<std::string, std::vector<Match> > ObjectMatches;
+
+      /** A view of the scene, from one of the cameras */
+      struct View{
+        /** Matched with LINE-MOD */
+        Img::ImageWMask frame;
+        /** Aligned with ICP */
+        Img::ImageWMask depthFrame;
+        /** Camera of frame: its extrinsics place the view into the world */
+        Camera::CameraModel camera;
+        Camera::CameraModel depthCamera;
+      };
     private:
       struct FirstPassFoundItems{
         cv::linemod::Match match;
@@ -35,6 +50,21 @@ namespace Recognition{
       typedef Camera::CameraModel CameraModel;
       typedef pcl::PointCloud<pcl::PointXYZRGB> PCloud;
 
+      /** What LINE-MOD is run on: RGB, depth (in meters) and mask of a view */
+      struct FirstPassInput{
+        cv::Mat rgb;
+        cv::Mat depth;
+        cv::Mat mask;
+      };
+
+      /** A view being recognized: camera is null for views taken by the camera each object was trained with */
+      struct ViewInput{
+        const Img::ImageWMask* frame;
+        const Img::ImageWMask* depthFrame;
+        const CameraModel* camera;
+        const CameraModel* depthCamera;
+      };
+
       GLUTInit _glutIniter;
 
       //Depth Camera Matrix
@@ -46,6 +76,24 @@ namespace Recognition{
 
       std::unordered_map<std::string, Model> _objectModels;
 
+      typedef std::shared_ptr<const Model::Detector> DetectorPtr;
+      /** A detector built from the packed templates of a set of objects (e.g. the content of a bin) */
+      struct CachedDetector{
+        std::set<std::string> objects;
+        DetectorPtr detector;
+        /** Its templates, see Model::detectorMemoryUsage */
+        size_t bytes;
+      };
+      /** The most recently used first */
+      mutable std::list<CachedDetector> _detectors;
+      mutable size_t _detectorsBytes;
+      mutable std::mutex _detectorsMutex;
+      /** Bytes of unpacked templates kept by the cache, on top of the packed ones of the models: each detector takes
+       * more than twice the packed size of its templates, so keeping all of them would take more memory than
+       * unpacking them at every frame. Detectors bigger than this are built at every frame.
+       */
+      static const size_t MAX_DETECTORS_BYTES;
+
       std::string objsfolder_path;
 
       /** Pose estimation using PCL ICP 
@@ -59,9 +107,32 @@ namespace Recognition{
 
       bool updateGiorgio(const Img::ImageWMask& sceneImg, const Img::ImageWMask& precisionImg, const Camera::CameraModel& depthCam,                                ObjectMatches& result, const std::vector<std::string>& vect_objs_to_pick) const;
 
+      /** Matches and aligns the objects into each view on its own, the views in parallel but for the rendering, which
+       * needs the thread owning the GL context: poses are in the world frame
+       */
+      std::vector<ObjectMatches> recognizeViews(const std::vector<ViewInput>& views, const std::vector<std::string>& vect_objs_to_pick) const;
+
+      /** A detector with the templates of the objects of whatToSee, shared by all the threads: it is only built again
+       * if it has been dropped from the cache since the last time they were searched together
+       */
+      DetectorPtr detectorFor(const std::vector<std::string>& whatToSee) const;
+
+      /** The first pass of several views at once, one list of found items per view */
+      std::vector<std::vector<FirstPassFoundItems>> makeAFirstPassRecognition(const std::vector<FirstPassInput>& views, const std::vector<std::string>& whatToSee) const;
+
+      /** Matches of the same object closer than th_obj_dist_ are the same item: it is kept once, with its best fit.
+       * Items found in more views come first.
+       */
+      ObjectMatches fuse(const std::vector<ObjectMatches>& views) const;
+
     public:
       RecognitionData::ObjectMatches recognize(const Img::ImageWMask& frame, const Img::ImageWMask& depthFrame, const Camera::CameraModel& depthCam, const std::vector<std::string>& what);
 
+      /** Recognizes the objects into several views of the same scene at once (e.g. from the left and the right camera)
+       * and fuses what is found into the world frame: an object hidden in a view can be found from another one.
+       */
+      RecognitionData::ObjectMatches recognize(const std::vector<View>& views, const std::vector<std::string>& what);
+
       /**
        * @param trainPath path to the trained models data
        * @param M camera model to use
@@ -73,6 +144,9 @@ namespace Recognition{
 
       const Model& getModel(const std::string& name) const;
 
+      /** Whether the object has been trained */
+      bool hasModel(const std::string& name) const;
+
       std::vector<FirstPassFoundItems> makeAFirstPassRecognition(const cv::Mat& const_rgb, const cv::Mat& depth_m, const cv::Mat& filter_mask,  
                                                                  const std::vector<std::string>& whatToSee) const ;
 
@@ -0,0 +1,47 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <Eigen/Core>
+#include <opencv2/core/core.hpp>
+#include <Img/Image.h>
+#include <Camera/CameraModel.h>
+
+namespace Recognition{
+  /** Finds spherical, uniformly coloured objects: each colour is thresholded in HSV, every connected blob which looks
+   * like a disc is kept, and its depth points are fitted with a sphere.
+   */
+  namespace Balls{
+    struct Color{
+      std::string name;
+      /** OpenCV ranges: hue is 0-180 */
+      cv::Scalar hsvMin;
+      cv::Scalar hsvMax;
+    };
+
+    struct Params{
+      /** Blobs smaller than this (in pixels) are noise */
+      double minArea;
+      /** Mean squared distance of the contour from the enclosing circle, relative to its squared radius */
+      double maxCircleError;
+      /** Radius of the balls in meters, or 0 if unknown (the sphere fit will then estimate it) */
+      double radius;
+      /** Valid depth points needed to fit a sphere */
+      size_t minPoints;
+      Params();
+    };
+
+    struct Ball{
+      std::string color;
+      /** In the world frame of the camera model */
+      Eigen::Vector3d center;
+      double radius;
+      cv::Point2f pixel;
+      float pixelRadius;
+    };
+
+    /** The colours of the balls of the kygen_squeakin_eggs_plush_puppies */
+    const std::vector<Color>& defaultColors();
+
+    std::vector<Ball> find(const Img::Image& frame, const Camera::CameraModel& cam, const std::vector<Color>& colors=defaultColors(), const Params& params=Params());
+  }
+}
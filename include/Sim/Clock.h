@@ -0,0 +1,40 @@
+#pragma once
+
+namespace Sim{
+  /** Time as seen by the calling thread, in seconds from the start of the process.
+   * Normally this is just the real time. Once the clock is virtual (see setVirtual) each thread keeps its own time, which
+   * flows as the real one while the thread computes and jumps forward when the thread waits for a simulated device (see
+   * waitUntil): simulated movements and photos take no real time, so that whole runs go faster than real time.
+   * Work handed from a thread to another carries its time along (see startAt).
+   */
+  class Clock{
+    public:
+      /** To be called before any other thread uses the clock */
+      static void setVirtual(bool isVirtual);
+      static bool isVirtual();
+
+      static double now();
+
+      /** The calling thread waits for something which is over at t; what is charged for the time lost (see Timeline) */
+      static void waitUntil(double t, const char* what);
+
+      /** The calling thread starts working on something which can't begin before t, e.g. a task whose dependencies end at t */
+      static void startAt(double t);
+
+      /** The real time spent into its scope doesn't count, e.g. for the computations which only exist in the simulation,
+       * or for blocking on another thread whose virtual time is then joined with waitUntil.
+       */
+      class Excluded{
+        public:
+          Excluded();
+          ~Excluded();
+        private:
+          Excluded(const Excluded&)=delete;
+          void operator=(const Excluded&)=delete;
+          double _start;
+      };
+
+    private:
+      Clock()=delete;
+  };
+}
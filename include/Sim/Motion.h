@@ -0,0 +1,8 @@
+#pragma once
+
+namespace Sim{
+  /** Time to go through a segment of length distance with a trapezoidal speed profile, entering at entrySpeed and leaving
+   * at (most) exitSpeed, which is updated to the actual exit speed. Works as well for rotations, given angular limits.
+   */
+  double trapezoidTime(double distance, double maxSpeed, double maxAcceleration, double entrySpeed, double& exitSpeed);
+}
@@ -0,0 +1,46 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <Eigen/Geometry>
+
+namespace Sim{
+  /** Object placed into the simulated cell, relative to the robot */
+  struct Item{
+    std::string name;
+    Eigen::Affine3d pose;
+  };
+
+  /** Parameters of the simulated devices, read from FILE in the working directory (each value is optional):
+   *
+   * simulation:
+   *   robot: { maxSpeed: 0.5, maxAcceleration: 1.0, maxAngularSpeed: 1.0, maxAngularAcceleration: 2.0, gripperTime: 0.5 }
+   *   camera: { photoTime: 0.1, fx: 525, fy: 525, cx: 319.5, cy: 239.5, subsampling: 4 }
+   *   scene: [ { name: "oreo_mega_stuf", pose: [ x, y, z, alpha, beta, gamma ] }, ... ]
+   */
+  struct Params{
+    static const std::string FILE;
+
+    /** [m/s], [m/s^2], [rad/s], [rad/s^2] */
+    double maxSpeed;
+    double maxAcceleration;
+    double maxAngularSpeed;
+    double maxAngularAcceleration;
+    /** To close or open the gripper [s] */
+    double gripperTime;
+
+    /** Exposure and transfer of a frame [s] */
+    double photoTime;
+    /** Pinhole model of the camera [px] */
+    double fx, fy, cx, cy;
+    /** A ray is cast for each subsampling x subsampling block of pixels */
+    int subsampling;
+
+    /** Initial content of the shelf */
+    std::vector<Item> scene;
+
+    static const Params& get();
+
+    private:
+      Params();
+  };
+}
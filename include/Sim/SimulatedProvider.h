@@ -0,0 +1,36 @@
+#pragma once
+#include <vector>
+#include <Eigen/Geometry>
+#include <opencv2/core/core.hpp>
+#include <Camera/ImageProvider.h>
+#include <Gripper/Shape.h>
+#include <Gripper/Types.h>
+
+namespace Sim{
+  /** Camera mounted on the simulated arm (see ROBOT_TYPE=SIMULATED), rendering the shelf and the objects of the World from
+   * the current pose of the arm. Each photo keeps the camera busy for Params::photoTime of virtual time, while the
+   * rendering itself takes no virtual time at all.
+   */
+  class SimulatedProvider : public Camera::ImageProvider {
+    public:
+      /** The shapes of the objects are read from the same database used for planning (see APC::loadGraspModels) */
+      SimulatedProvider(const std::string& objectsFile, const std::string& ID="SimulatedProvider");
+      virtual Image getFrame() const;
+
+      /** Camera frame relative to the tool: the camera looks forward (along X of the tool), with the image upright */
+      static const Eigen::Affine3d MOUNT;
+
+    private:
+      struct Solid{
+        Gripper::Shape::Ptr shape;
+        Eigen::AlignedBox3d bounds;
+        cv::Vec3b color;
+      };
+
+      /** Depth (along the optical axis) and color of what the pixel sees, with depth 0 if nothing */
+      void castRay(const Eigen::Vector3d& origin, const Eigen::Vector3d& direction, double zScale, const std::vector<Solid>& solids, float& depth, cv::Vec3b& color) const;
+
+      std::vector<Solid> _shelf;
+      Gripper::ObjectDB _objects;
+  };
+}
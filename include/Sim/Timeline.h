@@ -0,0 +1,50 @@
+#pragma once
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace Sim{
+  /** What the resources of the cell (robot, camera, background tasks) did during a run with the virtual clock (see Clock),
+   * to tell where the time went. Nothing is kept while the clock is real.
+   */
+  class Timeline{
+    public:
+      static Timeline& getInstance();
+
+      /** The resource is used for duration, starting at earliest or as soon as it is free; returns when it will be free again */
+      double reserve(const std::string& resource, double earliest, double duration);
+
+      /** When the resource will be free (0 if it has never been used) */
+      double busyUntil(const std::string& resource) const;
+
+      /** The resource has been busy from start to end; unlike reserve, uses may overlap (e.g. tasks on many threads) */
+      void record(const std::string& resource, double start, double end);
+
+      /** The calling thread has been waiting for what (see Clock::waitUntil) */
+      void charge(const std::string& what, double time);
+
+      /** Picks per hour, and busy and idle time of each resource, from the start to now. The critical path is the one of the
+       * calling thread: the time it has been waiting for each resource, and the remaining one it has been computing.
+       */
+      void report(std::ostream& os, int picks) const;
+
+    private:
+      typedef std::vector<std::pair<double, double>> Intervals;
+
+      Timeline();
+      Timeline(const Timeline&)=delete;
+      void operator=(const Timeline&)=delete;
+
+      /** Total length of the union of the intervals, cut at end */
+      static double busyTime(Intervals intervals, double end);
+
+      mutable std::mutex _mutex;
+      std::map<std::string, Intervals> _busy;
+      std::map<std::string, double> _free;
+      std::map<std::thread::id, std::map<std::string, double>> _waits;
+  };
+}
@@ -0,0 +1,33 @@
+#pragma once
+#include <mutex>
+#include <string>
+#include <vector>
+#include <Eigen/Geometry>
+#include "Params.h"
+
+namespace Sim{
+  /** State of the simulated cell, shared by the simulated robot and camera: where the arm is, and the objects still into the
+   * shelf (initially the scene of Params).
+   */
+  class World{
+    public:
+      static World& getInstance();
+
+      void setArmPose(const Eigen::Affine3d& pose);
+      Eigen::Affine3d getArmPose() const;
+
+      std::vector<Item> getItems() const;
+
+      /** The object nearest to the tool, within reach [m], is taken away from the shelf; returns its name ("" if none) */
+      std::string grab(double reach);
+
+    private:
+      World();
+      World(const World&)=delete;
+      void operator=(const World&)=delete;
+
+      mutable std::mutex _mutex;
+      Eigen::Affine3d _arm;
+      std::vector<Item> _items;
+  };
+}
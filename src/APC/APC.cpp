@@ -1,5 +1,6 @@
 #include <boost/program_options.hpp>
 #include <stdexcept>
+#include <vector>
 
 #include <APC/APC.h>
 #include <APC/Robot.h>
@@ -8,16 +9,23 @@
 #include <C5G/Grasp.h>
 #include <Camera/DummyConsumer.h>
 #include <Camera/DummyProvider.h>
+#include <Camera/ImageViewer.h>
 #include <Camera/OpenniProvider.h>
 #include <Camera/OpenniStreamProvider.h>
 #include <Camera/OpenniWaitProvider.h>
 #include <APC/Order.h>
 #include <APC/ReadWorkOrder.h>
 #include <APC/ScanBins.h>
-#include <APC/UpdateBins.h>
+#include <APC/Grasper.h>
+#include <APC/Pipeline.h>
 #include <APC/Shelf.h>
 #include <APC/OrderBin.h>
+#include <Log/Log.h>
 #include <Parser/RobotData.h>
+#include <Recognition/Recognition.h>
+#include <Sim/Clock.h>
+#include <Sim/SimulatedProvider.h>
+#include <Sim/Timeline.h>
 //#include <XnOpenNI.h>
 //#include <openni2/OpenNI.h>
 
@@ -26,7 +34,8 @@ namespace APC{
   /** Base idea:
    * Start with scanning all bins. In this way each bin has a recorded image, and each order is marked as "dirty".
    * while(!finished):
-   *    Sort the objects which still have to be taken by score of their best grasp, after updating all the orders for which the best grasp score could have changed. 
+   *    Sort the objects which still have to be taken by score of their best grasp, after updating all the orders for which the best grasp score could have changed
+   *    (they are recognized and planned in background, see Pipeline).
    *    Take the best one,
    *    go in front of the bin (basic point from which the best grasp has been computed)
    *    start executing the grasp
@@ -42,6 +51,9 @@ namespace APC{
 
     std::string ip;
     std::string profile;
+    std::string objectsFile;
+    std::string gripperFile;
+    std::string camerasFile;
 
     namespace po=boost::program_options;
     po::options_description desc("Allowed options");
@@ -49,16 +61,58 @@ namespace APC{
       ("help", "print help message")
       ("ip,i", po::value<std::string>(&ip)->required(), "IP address to connect to")
       ("profile,p", po::value<std::string>(&profile)->required(), "profile name")
-      ("stream,s", po::value<std::string>(), "stream to a directory")
-      ("wait,w" , "wait before taking shoots");
+      ("stream,s", po::value<std::string>()->implicit_value(Camera::OpenniStreamProvider::DEFAULT_STREAM), "read frames from the shared memory ring of the OpenNI streamer")
+      ("right-stream", po::value<std::string>(), "read the frames of the right camera from this shared memory ring of the OpenNI streamer, recognizing the objects from both cameras (needs --models)")
+      ("models,m", po::value<std::string>(), "trained models of the objects, to recognize them from both cameras")
+      ("cameras,c", po::value<std::string>(&camerasFile)->default_value("cameras.yml"), "left and right camera models, to recognize the objects from both cameras")
+      ("wait,w" , "wait before taking shoots")
+      ("simulate", "take photos with the simulated camera, which needs the simulated robot (ROBOT_TYPE=SIMULATED)")
+      ("headless", "don't show anything (see Camera::ImageViewer)")
+      ("log,l", po::value<std::string>(), "log levels, e.g. info,icp=debug (see Log::configure)")
+      ("objects,o", po::value<std::string>(&objectsFile)->default_value("objects.yml"), "database of the shapes and grasps of the objects")
+      ("gripper,g", po::value<std::string>(&gripperFile)->default_value("gripper.yml"), "model of the gripper");
 
     po::variables_map vm;
     po::store(po::parse_command_line(argc, argv, desc), vm);
     po::notify(vm);
+    if(vm.count("headless")){
+      Camera::ImageViewer::setHeadless(true);
+    }
+    if(vm.count("log")){
+      try{
+        Log::configure(vm["log"].as<std::string>());
+      }
+      catch(const std::invalid_argument& e){
+        std::cerr << "Error: " << e.what() << "\n";
+        return -1;
+      }
+    }
+
+    try{
+      loadGraspModels(objectsFile, gripperFile);
+    }
+    catch(const std::exception& e){
+      std::cerr << "Error: " << e.what() << "\n";
+      return -5;
+    }
 
-    Camera::ImageProvider::Ptr x;
+    Camera::ImageProvider::Ptr x, right;
+    /** Asks whether to go on without a camera: false to quit */
+    auto useDummyProvider=[&x] (const std::string& what) {
+      std::cerr << "Error: " << what << ".\n Type OK to continue working with a dummy (NULL) provider.\n";
+      std::string aaa;
+      std::cin >> aaa;
+      if(aaa!="OK"){
+        return false;
+      }
+      x=Camera::ImageProvider::Ptr(new Camera::DummyProvider());
+      return true;
+    };
     try{
-      if(vm.count("stream")){
+      if(vm.count("simulate")){
+        x=Camera::ImageProvider::Ptr(new Sim::SimulatedProvider(objectsFile));
+      }
+      else if(vm.count("stream")){
         x=Camera::ImageProvider::Ptr(new Camera::OpenniStreamProvider(vm["stream"].as<std::string>()));
       }
       else if(vm.count("wait")){
@@ -67,22 +121,47 @@ namespace APC{
       else{
         x=Camera::ImageProvider::Ptr(new Camera::OpenNIProvider());
       }
-
     }
     catch(std::string what){
-      std::cerr << "Error: " << what << ".\n Type OK to continue working with a dummy (NULL) provider.\n";
-      std::string aaa;
-      std::cin >> aaa;
-      if(aaa=="OK"){
-        x=Camera::ImageProvider::Ptr(new Camera::DummyProvider());
+      if(!useDummyProvider(what)){
+        return -1;
       }
-      else{
+    }
+    catch(const std::runtime_error& e){
+      /** E.g. no streamer is running */
+      if(!useDummyProvider(e.what())){
         return -1;
       }
     }
 
+    if(vm.count("right-stream")){
+      if(!vm.count("models")){
+        std::cerr << "Error: recognizing the objects from the right camera needs --models\n";
+        return -1;
+      }
+      try{
+        right=Camera::ImageProvider::Ptr(new Camera::OpenniStreamProvider(vm["right-stream"].as<std::string>()));
+      }
+      catch(const std::runtime_error& e){
+        std::cerr << "Warning: " << e.what() << ", going on with the left camera only\n";
+      }
+    }
+    if(right){
+      try{
+        Recognition::setStereoRecognition(vm["models"].as<std::string>(), camerasFile);
+      }
+      catch(const std::exception& e){
+        std::cerr << "Error: " << e.what() << "\n";
+        return -5;
+      }
+    }
+
     //Camera::DummyConsumer img(x); 
-    Robot robot(ip, profile, false, x);
+    Robot robot(ip, profile, false, x, right);
+    if(vm.count("simulate") && !Sim::Clock::isVirtual()){
+      std::cerr << "The simulated camera needs the simulated robot: build with ROBOT_TYPE=SIMULATED\n";
+      return -1;
+    }
     try{
       robot.init();
     }
@@ -100,7 +179,6 @@ namespace APC{
       return -4;
     }
 
-    OrderStatus orderBin;
     InterProcessCommunication::RobotData& rData=InterProcessCommunication::RobotData::getInstance();
 
     std::cout << "Contents of the bins:\n" << rData << "\n";
@@ -109,17 +187,24 @@ namespace APC{
     std::cout << "After loading:\n" << rData << "\n";
     auto workOrder=rData.getWorkOrder();
 
-    orderBin=workOrder;
-    std::cout << "Items to take: " << orderBin << "\n";
+    std::cout << "Items to take: " << workOrder << "\n";
 
     try{
-      while(!orderBin.empty()){
+      Pipeline pipeline(robot);
+      std::vector<Order> orders;
+      for(; !workOrder.empty(); workOrder.pop()){
+        orders.push_back(workOrder.top());
+      }
+      pipeline.add(orders);
+
+      /** Virtual with the simulated robot (see Sim::Clock) */
+      const double start=Sim::Clock::now();
+      int picks=0;
+      while(!pipeline.empty()){
         std::cout << "Updating bins..\n";
-        updateBins(orderBin, robot);
+        Order x=pipeline.takeBest();
         std::cout << "Finished updating.\n";
-        std::cout << "Remaining order bin: ----------\n" << orderBin << "\n---------\n";
-        Order x=orderBin.top();
-        orderBin.pop();
+        std::cout << "Remaining order bin: ----------\n" << pipeline.pending() << "\n---------\n";
         std::cout << "Best order: " << x << "----------\n";
         if(x.grasp.score < Order::MIN_SCORE_WE_CAN_MANAGE){
           throw std::runtime_error("Remaining items are too much difficult to take!");
@@ -129,10 +214,22 @@ namespace APC{
         robot.moveCartesianGlobal(Shelf::getBinSafePose(x.bin[0], x.bin[1]));
         robot.setZero();
         robot.executeGrasp(todoGrasp);
+        pipeline.waitBin(x.bin[0], x.bin[1]);
+        removeFromBin(x.bin[0], x.bin[1], x.object);
+        /** The other orders of the bin are planned again while the object is brought to the order bin */
+        pipeline.binChanged(x.bin[0], x.bin[1]);
         Pose origin(0, 0, 0, 0, 0, 0);
         robot.moveCartesian(origin);
         robot.moveCartesianGlobal(OrderBin::POSE+Pose(0, 0, OrderBin::HEIGHT+0.1, 0, 0, 0));
         robot.setGripping(0);
+
+        ++picks;
+        double hours=(Sim::Clock::now()-start)/3600;
+        std::cout << picks << " picks, " << picks/hours << " picks/hour\n";
+      }
+      robot.waitMotion();
+      if(Sim::Clock::isVirtual()){
+        Sim::Timeline::getInstance().report(std::cout, picks);
       }
     }
     catch(std::string s){
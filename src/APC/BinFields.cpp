@@ -0,0 +1,74 @@
+#include <stdexcept>
+#include <APC/BinFields.h>
+#include <Gripper/Cuboid.h>
+
+namespace APC{
+  const double BinFields::VOXEL_SIZE=0.005;
+  const double BinFields::MARGIN=0.05;
+  const double BinFields::WALL_WEIGHT=100.0;
+
+  namespace{
+    Gripper::Shape::Ptr box(const Eigen::Vector3d& min, const Eigen::Vector3d& max){
+      Eigen::Vector3d size=max-min;
+      return Gripper::Shape::Ptr(new Gripper::Cuboid(Eigen::Affine3d(Eigen::Translation3d(min)), size[0], size[1], size[2]));
+    }
+  }
+
+  BinFields::BinFields()
+  {
+  }
+
+  BinFields& BinFields::getInstance(){
+    static BinFields instance;
+    return instance;
+  }
+
+  Gripper::DistanceField BinFields::makeEmptyBin(int row, int column){
+    const Eigen::AlignedBox3d bin=Shelf::getBinBounds(row, column);
+    const double t=Shelf::WALL_THICKNESS;
+    const Eigen::Vector3d& lo=bin.min();
+    const Eigen::Vector3d& hi=bin.max();
+
+    /** The field also covers the front of the bin, where the gripper comes from */
+    Eigen::AlignedBox3d region(lo-Eigen::Vector3d::Constant(MARGIN)-Eigen::Vector3d{Shelf::SECURITY_DISTANCE, 0, 0}, hi+Eigen::Vector3d::Constant(MARGIN));
+    Gripper::DistanceField field(region, VOXEL_SIZE);
+
+    /** Bottom, top, sides and back; the front is open */
+    field.add(box({lo[0], lo[1]-t, lo[2]-t}, {hi[0]+t, hi[1]+t, lo[2]}), WALL_WEIGHT);
+    field.add(box({lo[0], lo[1]-t, hi[2]}, {hi[0]+t, hi[1]+t, hi[2]+t}), WALL_WEIGHT);
+    field.add(box({lo[0], lo[1]-t, lo[2]}, {hi[0]+t, lo[1], hi[2]}), WALL_WEIGHT);
+    field.add(box({lo[0], hi[1], lo[2]}, {hi[0]+t, hi[1]+t, hi[2]}), WALL_WEIGHT);
+    field.add(box({hi[0], lo[1], lo[2]}, {hi[0]+t, hi[1], hi[2]}), WALL_WEIGHT);
+    return field;
+  }
+
+  void BinFields::rebuild(int row, int column, const Gripper::ObjectsScene& items, const Gripper::ObjectDB& objDB){
+    Bin result;
+    result.field=std::make_shared<Gripper::DistanceField>(makeEmptyBin(row, column));
+    for(const auto& x : items){
+      const Gripper::Object& o=objDB.at(x.first);
+      result.items.push_back(result.field->add(x.second*o.myShape, o.myMobility));
+    }
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    _bins[row][column]=result;
+  }
+
+  void BinFields::removeItem(int row, int column, size_t item){
+    std::lock_guard<std::mutex> lock(_mutex);
+    Bin& b=_bins[row][column];
+    if(!b.field || item>=b.items.size() || b.items[item]==Gripper::DistanceField::NONE){
+      throw std::runtime_error("Removing an item which is not into the field of the bin");
+    }
+    /** Readers may still hold the old field */
+    auto updated=std::make_shared<Gripper::DistanceField>(*b.field);
+    updated->remove(b.items[item]);
+    b.items[item]=Gripper::DistanceField::NONE;
+    b.field=updated;
+  }
+
+  std::shared_ptr<const Gripper::DistanceField> BinFields::get(int row, int column) const {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _bins[row][column].field;
+  }
+}
@@ -1,49 +1,167 @@
-#include <fstream>
 #include <iostream>
+#include <map>
+#include <memory>
+#include <tuple>
+#include <mutex>
+#include <stdexcept>
 #include <C5G/Pose.h>
 #include <C5G/Grasp.h>
 #include <APC/Grasper.h>
+#include <APC/BinFields.h>
+#include <APC/Shelf.h>
 #include <Parser/RobotData.h>
+#include <Gripper/GripperModel.h>
+#include <Gripper/Types.h>
+#include <Utils/CvStorage.h>
+
 namespace APC{
-  C5G::Grasp getBestGrasp(std::string what, int row, int column){
-    using InterProcessCommunication::RobotData;
-    std::cout << "Computing the best grasp for " << what << "\n";
-    RobotData& r=RobotData::getInstance();
-    {
-      std::ofstream f("/tmp/robot.data");
+  namespace{
+    /** Score given to objects which haven't been found into the bin */
+    const double NOT_FOUND_SCORE=-313373;
+
+    /** Maximum force applied by the gripper */
+    const double DEFAULT_FORCE=10;
+
+    /** Objects whose pose is below this (on X) have not been recognized */
+    const double NOT_FOUND_X=-1000;
+
+    struct Planner{
+      Gripper::ObjectDB objects;
+      Gripper::GripperModel gripper;
+      /** For each bin, the RobotData item each object of the collision model comes from */
+      std::vector<int> slots[Shelf::HEIGHT][Shelf::WIDTH];
+      /** Best grasps already computed, keyed by (object, row, column), with the version of the bin they were computed from */
+      std::map<std::tuple<std::string, int, int>, std::pair<unsigned long, C5G::Grasp>> grasps;
+      std::mutex mutex;
+    };
+
+    std::unique_ptr<Planner> thePlanner;
+
+    Planner& planner(){
+      if(!thePlanner){
+        throw std::runtime_error("Grasp models have not been loaded");
+      }
+      return *thePlanner;
+    }
+
+    /** Object poses into RobotData are relative to the camera; planning is done relative to the robot, as the shelf */
+    Eigen::Affine3d cameraToRobot(){
+      return Shelf::CAMERA_POSE.toTransform();
+    }
+
+    /** Recognized objects of a bin, relative to the robot, and the RobotData item each of them comes from */
+    Gripper::ObjectsScene binScene(const InterProcessCommunication::RobotData::Bin& bin, const Gripper::ObjectDB& objects, std::vector<int>& slots){
+      using InterProcessCommunication::RobotData;
+      Gripper::ObjectsScene scene;
+      slots.clear();
       for(int i=0; i<RobotData::MAX_ITEM_N; ++i){
-        std::string item=r.getBinItem(row, column, i);
-        C5G::Pose thePose= r.getObjPose(row, column, i);
-        if(item!=""){
-          f << item << " " << thePose.x << " " << thePose.y << " " << thePose.z << " " << thePose.alpha << " " << thePose.beta << " " << thePose.gamma << "\n";
+        const std::string& item=bin.object[i];
+        const C5G::Pose& thePose=bin.objPose[i];
+        if(item=="" || thePose.x<NOT_FOUND_X){
+          continue;
         }
+        if(!objects.count(item)){
+          std::cerr << "No model for " << item << ", it won't be considered while planning\n";
+          continue;
+        }
+        scene.push_back(std::make_pair(item, cameraToRobot()*thePose.toTransform()));
+        slots.push_back(i);
+      }
+      return scene;
+    }
+
+    C5G::Grasp computeBestGrasp(Planner& p, const std::string& what, int row, int column, const InterProcessCommunication::RobotData::Bin& bin){
+      std::cout << "Computing the best grasp for " << what << "\n";
+
+      std::vector<int> slots;
+      Gripper::ObjectsScene scene=binScene(bin, p.objects, slots);
+      bool found=false;
+      for(const auto& x : scene){
+        found|=(x.first==what);
+      }
+      if(!found){
+        std::cout << what << " has not been found into bin (" << row << "," << column << ")\n";
+        return C5G::Grasp({what, row, column, C5G::Pose(), C5G::Pose(), 0, NOT_FOUND_SCORE});
+      }
+
+      auto field=BinFields::getInstance().get(row, column);
+      auto result=(field ? p.gripper.getBestGrasp(what, scene, p.objects, *field) : p.gripper.getBestGrasp(what, scene, p.objects));
+
+      /** Approach from the front of the bin, at the height of the grasp */
+      Eigen::Affine3d approach=result.second;
+      approach.translation()[0]=std::min(approach.translation()[0], Shelf::getBinBounds(row, column).min()[0]-Shelf::SECURITY_DISTANCE);
+
+      /** Back into the camera's frame, as the poses of the objects */
+      const Eigen::Affine3d robotToCamera=cameraToRobot().inverse();
+      C5G::Pose gPose=C5G::Pose::transform2Pose(robotToCamera*result.second);
+      C5G::Pose approachPose=C5G::Pose::transform2Pose(robotToCamera*approach);
+
+      /** Orders prefer higher scores, while the model gives 0 to grasps which don't touch anything */
+      double score=1.0/(1.0+result.first);
+      return C5G::Grasp({what, row, column, approachPose, gPose, DEFAULT_FORCE, score});
+    }
+  }
+
+  void loadGraspModels(const std::string& objectsFile, const std::string& gripperFile){
+    std::unique_ptr<Planner> p(new Planner);
+    cv::FileStorage objectsStorage(objectsFile, cv::FileStorage::READ);
+    if(!objectsStorage.isOpened()){
+      throw std::runtime_error("Couldn't open the objects' database "+objectsFile);
+    }
+    objectsStorage["objects"] >> p->objects;
+
+    cv::FileStorage gripperStorage(gripperFile, cv::FileStorage::READ);
+    if(!gripperStorage.isOpened()){
+      throw std::runtime_error("Couldn't open the gripper model "+gripperFile);
+    }
+    gripperStorage["gripper"] >> p->gripper;
+    thePlanner=std::move(p);
+  }
+
+  void updateBinModel(int row, int column){
+    Planner& p=planner();
+    std::vector<int> slots;
+    Gripper::ObjectsScene scene=binScene(*InterProcessCommunication::RobotData::getInstance().getBin(row, column), p.objects, slots);
+    BinFields::getInstance().rebuild(row, column, scene, p.objects);
+    std::lock_guard<std::mutex> lock(p.mutex);
+    p.slots[row][column]=slots;
+  }
+
+  void removeFromBin(int row, int column, const std::string& what){
+    using InterProcessCommunication::RobotData;
+    Planner& p=planner();
+    RobotData& r=RobotData::getInstance();
+    std::lock_guard<std::mutex> lock(p.mutex);
+    const std::vector<int>& slots=p.slots[row][column];
+    for(size_t i=0; i<slots.size(); ++i){
+      if(r.getBinItem(row, column, slots[i])==what){
+        r.setBinItem(row, column, slots[i], "");
+        BinFields::getInstance().removeItem(row, column, i);
+        return;
       }
     }
-    C5G::Pose approach, gPose;
-    double theForceMayBeWithYou;
-    double score;
-    system(("python ./gripper.py "+what).c_str());
+  }
+
+  C5G::Grasp getBestGrasp(std::string what, int row, int column){
+    using InterProcessCommunication::RobotData;
+    Planner& p=planner();
+
+    /** Planning works on a snapshot of the bin: a change of the bin while planning makes the result stale */
+    const RobotData::BinSnapshot bin=RobotData::getInstance().getBin(row, column);
+    const unsigned long version=bin->version;
+    const auto key=std::make_tuple(what, row, column);
     {
-      std::ifstream resultFile("/tmp/grasp.result");
-      resultFile >> approach.x >> approach.y >> approach.z >> approach.alpha >> approach.beta >> approach.gamma ;
-      resultFile >> gPose.x >> gPose.y >> gPose.z >> gPose.alpha >> gPose.beta >> gPose.gamma ;
-      resultFile >> theForceMayBeWithYou >> score;
-    }
-#if 0
-    approach.x=1.50;
-    approach.y=0.30;
-    approach.z=0.5;
-
-#endif
-    C5G::Grasp x({what, row, column, approach, gPose, theForceMayBeWithYou, score});
-    //std::cout << "\nFinished computing grasp. New grasp: " << approach //<< "," << gPose << "," << theForceMayBeWithYou << ","<< score << "\n";
-    return x;
-
-#if 0
-    std::cout << "Implement me!\n";
-    C5G::Pose none(0.1, 0, 0, 0 , 0, 0);
-    C5G::Grasp theGraspThatIWantToReturn={what, none, none, 1.0, 0.0};
-    return theGraspThatIWantToReturn;
-#endif
+      std::lock_guard<std::mutex> lock(p.mutex);
+      auto it=p.grasps.find(key);
+      if(it!=p.grasps.end() && it->second.first==version){
+        std::cout << "Bin (" << row << "," << column << ") didn't change, reusing the best grasp for " << what << "\n";
+        return it->second.second;
+      }
+    }
+
+    C5G::Grasp result=computeBestGrasp(p, what, row, column, *bin);
+    std::lock_guard<std::mutex> lock(p.mutex);
+    p.grasps[key]=std::make_pair(version, result);
+    return result;
   }
 }
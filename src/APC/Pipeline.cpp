@@ -0,0 +1,183 @@
+#include <algorithm>
+#include <iostream>
+#include <limits>
+#include <set>
+#include <stdexcept>
+#include <APC/Pipeline.h>
+#include <APC/Grasper.h>
+#include <Parser/RobotData.h>
+#include <Recognition/Recognition.h>
+
+namespace APC{
+  namespace{
+    /** What the exception being handled says: std::string is thrown as well as std::exception */
+    std::string currentError(){
+      try{
+        throw;
+      }
+      catch(const std::exception& e){
+        return e.what();
+      }
+      catch(const std::string& s){
+        return s;
+      }
+      catch(...){
+        return "unknown error";
+      }
+    }
+  }
+
+  Pipeline::Pipeline(Robot& robot)
+    :
+      _robot(robot)
+  {
+    for(auto& row : _bins){
+      for(auto& bin : row){
+        bin.hasWriter=false;
+        bin.failed=false;
+      }
+    }
+  }
+
+  void Pipeline::photograph(int row, int column){
+    using InterProcessCommunication::RobotData;
+    RobotData& r=RobotData::getInstance();
+
+    std::cout << "Going to bin " << row << "," << column << " to take a photo\n";
+    _robot.moveToBin(row, column);
+    Img::Image photo;
+    bool stereo=false;
+    if(_robot.hasCamera(Robot::CameraIndex::RIGHT)){
+      try{
+        /** Recognized together, see Recognition::setStereoRecognition */
+        auto photos=_robot.takePhotos();
+        r.setPhotos(row, column, photos[0], photos[1]);
+        photo=photos[0];
+        stereo=true;
+      }
+      catch(const std::runtime_error& e){
+        std::cerr << "Right camera: " << e.what() << ", the bin is photographed by the left one only\n";
+      }
+    }
+    if(!stereo){
+      photo=_robot.takePhoto();
+      r.setPhoto(row, column, photo);
+    }
+    r.demoViewer.showImage(photo);
+    r.demoViewer.setTitle("new Data");
+
+    BinTasks& bin=_bins[row][column];
+    std::vector<TaskGraph::Task> before=bin.readers;
+    if(bin.hasWriter){
+      before.push_back(bin.writer);
+    }
+    BinTasks* tasks=&bin;
+    bin.writer=_tasks.add([row, column, tasks] () {
+        try{
+          Recognition::updateGiorgio(row, column);
+          updateBinModel(row, column);
+          tasks->failed=false;
+        }
+        catch(...){
+          /** Photographed again by the next add */
+          std::cerr << "Recognition of bin " << row << "," << column << " failed: " << currentError() << "\n";
+          InterProcessCommunication::RobotData::getInstance().setDirty(row, column);
+          tasks->failed=true;
+        }
+        }, before, "recognition");
+    bin.hasWriter=true;
+    bin.readers.clear();
+  }
+
+  void Pipeline::plan(const std::shared_ptr<Entry>& entry){
+    BinTasks& bin=_bins[entry->order.bin[0]][entry->order.bin[1]];
+    std::vector<TaskGraph::Task> before;
+    if(bin.hasWriter){
+      before.push_back(bin.writer);
+    }
+    const BinTasks* tasks=&bin;
+    entry->planned=_tasks.add([entry, tasks] () {
+        Order& x=entry->order;
+        try{
+          if(tasks->failed){
+            throw std::runtime_error("the bin has not been recognized");
+          }
+          x.grasp=getBestGrasp(x.object, x.bin[0], x.bin[1]);
+        }
+        catch(...){
+          /** Taken last, and only if nothing else is left it stops the picking as any order too difficult to take */
+          std::cerr << "Planning of " << x.object << " failed: " << currentError() << "\n";
+          x.grasp.score=std::numeric_limits<double>::lowest();
+        }
+        }, before, "planning");
+    bin.readers.push_back(entry->planned);
+  }
+
+  void Pipeline::add(const std::vector<Order>& orders){
+    using InterProcessCommunication::RobotData;
+    RobotData& r=RobotData::getInstance();
+
+    /** Each bin is checked once: only the first time it has nothing queued on it yet */
+    std::set<std::pair<int, int>> visited;
+    for(const auto& x : orders){
+      auto bin=std::make_pair(x.bin[0], x.bin[1]);
+      if(visited.insert(bin).second){
+        /** Recognition clears the flag from its own task */
+        waitBin(bin.first, bin.second);
+        if(r.isDirty(bin.first, bin.second)){
+          photograph(bin.first, bin.second);
+        }
+      }
+
+      auto entry=std::make_shared<Entry>();
+      entry->order=x;
+      _orders.push_back(entry);
+      plan(entry);
+    }
+  }
+
+  bool Pipeline::empty() const {
+    return _orders.empty();
+  }
+
+  Order Pipeline::takeBest(){
+    if(_orders.empty()){
+      throw std::logic_error("No orders left");
+    }
+    for(const auto& e : _orders){
+      _tasks.wait(e->planned);
+    }
+    auto best=std::max_element(_orders.begin(), _orders.end(), [] (const std::shared_ptr<Entry>& a, const std::shared_ptr<Entry>& b) {
+        return a->order < b->order;
+        });
+    Order result=(*best)->order;
+    _orders.erase(best);
+    return result;
+  }
+
+  void Pipeline::waitBin(int row, int column){
+    BinTasks& bin=_bins[row][column];
+    if(bin.hasWriter){
+      _tasks.wait(bin.writer);
+    }
+    for(auto t : bin.readers){
+      _tasks.wait(t);
+    }
+  }
+
+  void Pipeline::binChanged(int row, int column){
+    for(const auto& e : _orders){
+      if(e->order.bin[0]==row && e->order.bin[1]==column){
+        plan(e);
+      }
+    }
+  }
+
+  OrderStatus Pipeline::pending() const {
+    OrderStatus result;
+    for(const auto& e : _orders){
+      result.push(e->order);
+    }
+    return result;
+  }
+}
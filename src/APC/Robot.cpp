@@ -1,4 +1,5 @@
 #include <APC/Robot.h>
+#include <future>
 #include <stdexcept>
 #include <APC/Shelf.h>
 #include <Camera/ImageProvider.h>
@@ -6,20 +7,38 @@ namespace APC{
     void Robot::moveToBin(int row, int column){
       moveCartesianGlobal(Shelf::getBinSafePose(row, column).whichIsRelativeTo(Shelf::POSE));
     }
-    Robot::Robot(const std::string& ip, const std::string& sys_id, bool mustInit, const Camera::ImageProvider::Ptr& camera)
+    Robot::Robot(const std::string& ip, const std::string& sys_id, bool mustInit, const Camera::ImageProvider::Ptr& camera, const Camera::ImageProvider::Ptr& rightCamera)
     :
       C5G::C5G(ip, sys_id, mustInit),
-      _provider(camera)
+      _provider(camera),
+      _rightProvider(rightCamera)
      {
       }
 
+    bool Robot::hasCamera(CameraIndex direction) const {
+      return direction==CameraIndex::LEFT || _rightProvider;
+    }
+
     Img::Image Robot::takePhoto(CameraIndex direction){
       if(direction==CameraIndex::LEFT){
         return this->_provider->getFrame();
       }
+      else if(_rightProvider){
+        return _rightProvider->getFrame();
+      }
       else{
-        throw std::runtime_error("Taking a photo from the right camera is not supported, sorry!\n");
+        throw std::runtime_error("Taking a photo from the right camera is not supported without a right camera, sorry!\n");
+      }
+    }
+
+    std::array<Img::Image, 2> Robot::takePhotos(){
+      if(!_rightProvider){
+        throw std::runtime_error("Taking a photo from the right camera is not supported without a right camera, sorry!\n");
       }
+      /** Each provider waits for its own frame: the right one is taken meanwhile */
+      auto right=std::async(std::launch::async, [this] () { return _rightProvider->getFrame(); });
+      Img::Image left=_provider->getFrame();
+      return {{left, right.get()}};
     }
 
     void Robot::executeGrasp(const ::C5G::Grasp& g){
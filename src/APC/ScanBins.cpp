@@ -1,41 +1,44 @@
+#include <iostream>
+#include <vector>
 #include <C5G/C5G.h>
 #include <C5G/Pose.h>
+#include <APC/ScanRoute.h>
 #include <APC/Shelf.h>
 #include <Parser/RobotData.h>
 #include <Camera/ImageConsumer.h>
-#include <Parser/RobotData.h>
 
 namespace APC{
   void ScanBins(C5G::C5G& robot){
     using APC::Shelf;
     using C5G::Pose;
-    Pose p=Shelf::POSE;
 
     InterProcessCommunication::RobotData& rData=InterProcessCommunication::RobotData::getInstance();
+    std::vector<ScanRoute::Bin> bins;
     for(unsigned int j=0; j<Shelf::HEIGHT; ++j){
       for(unsigned int i=0; i<Shelf::WIDTH; ++i){
-        /** First, move globally into the safe pose of each bin */
-        Pose whereToGo=Shelf::getBinSafePose(i, j)+Shelf::POSE;
-        whereToGo.alpha=0;
-        whereToGo.beta=1.57;
-        whereToGo.gamma=0;
-
-        /** Go to the safe pose */
-        Pose p=C5G::C5G::safePose();
-        robot.moveCartesianGlobal(p);
-
-        /** Approach the shelf */
-        p.x=whereToGo.x;
-        p.y=whereToGo.y;
-        robot.moveCartesianGlobal(p);
+        bins.push_back(ScanRoute::Bin(i, j));
+      }
+    }
 
-        /** Move to the bin */
-        robot.moveCartesianGlobal(whereToGo);
-        rData.setDirty(i, j);
+    /** The route starts from the safe pose, wherever the robot is now */
+    robot.moveCartesianGlobal(C5G::C5G::safePose());
+    ScanRoute route(C5G::C5G::safePose(), bins);
+    std::cout << "Scanning the bins in " << route.getCost() << " s of travel\n";
 
-        /** Return to the approach position */
-        robot.moveCartesianGlobal(p);
+    for(size_t k=0; k<route.getOrder().size(); ++k){
+      const ScanRoute::Bin& bin=route.getOrder()[k];
+      std::vector<Pose> waypoints=route.getWaypoints(k);
+      for(size_t w=0; w+1<waypoints.size(); ++w){
+        robot.moveCartesianGlobalAsync(waypoints[w], C5G::C5G::FLY);
       }
+      /** Stop into the bin */
+      robot.moveCartesianGlobal(waypoints.back());
+      rData.setDirty(bin.first, bin.second);
+    }
+
+    /** Back out of the last bin */
+    if(!bins.empty()){
+      robot.moveCartesianGlobal(ScanRoute::getRetreatPose(route.getOrder().back()));
     }
   }
 }
@@ -0,0 +1,181 @@
+#include <algorithm>
+#include <cstdlib>
+#include <limits>
+#include <Eigen/Core>
+#include <APC/ScanRoute.h>
+#include <APC/Shelf.h>
+#include <C5G/C5G.h>
+#include <Sim/Motion.h>
+
+namespace APC{
+  constexpr size_t ScanRoute::MAX_EXACT;
+
+  namespace{
+    /** Nominal limits of the robot, only used to compare routes */
+    const double SPEED=0.5;
+    const double ACCELERATION=1.0;
+
+    double moveTime(const C5G::Pose& a, const C5G::Pose& b){
+      double stopped=0;
+      return Sim::trapezoidTime(Eigen::Vector3d(b.x-a.x, b.y-a.y, b.z-a.z).norm(), SPEED, ACCELERATION, 0, stopped);
+    }
+  }
+
+  ScanRoute::ScanRoute(const C5G::Pose& start, const std::vector<Bin>& bins)
+    :
+      _start(start),
+      _cost(0)
+  {
+    if(bins.size()<=MAX_EXACT){
+      planExact(bins);
+    }
+    else{
+      planHeuristic(bins);
+    }
+    for(size_t k=0; k<_order.size(); ++k){
+      _cost+=legCost(k ? &_order[k-1] : nullptr, _order[k]);
+    }
+  }
+
+  const std::vector<ScanRoute::Bin>& ScanRoute::getOrder() const {
+    return _order;
+  }
+
+  std::vector<C5G::Pose> ScanRoute::getWaypoints(size_t k) const {
+    return path(k ? &_order.at(k-1) : nullptr, _order.at(k));
+  }
+
+  double ScanRoute::getCost() const {
+    return _cost;
+  }
+
+  C5G::Pose ScanRoute::getScanPose(const Bin& bin){
+    C5G::Pose p=Shelf::getBinSafePose(bin.first, bin.second)+Shelf::POSE;
+    p.alpha=0;
+    p.beta=1.57;
+    p.gamma=0;
+    return p;
+  }
+
+  C5G::Pose ScanRoute::getRetreatPose(const Bin& bin){
+    C5G::Pose p=getScanPose(bin);
+    p.x=C5G::C5G::safePose().x;
+    return p;
+  }
+
+  bool ScanRoute::isDirect(const Bin& from, const Bin& to){
+    return std::abs(from.first-to.first)+std::abs(from.second-to.second)==1;
+  }
+
+  std::vector<C5G::Pose> ScanRoute::path(const Bin* from, const Bin& to) const {
+    if(from && isDirect(*from, to)){
+      return {getScanPose(to)};
+    }
+    std::vector<C5G::Pose> result;
+    if(from){
+      result.push_back(getRetreatPose(*from));
+    }
+    result.push_back(getRetreatPose(to));
+    result.push_back(getScanPose(to));
+    return result;
+  }
+
+  double ScanRoute::legCost(const Bin* from, const Bin& to) const {
+    C5G::Pose current=from ? getScanPose(*from) : _start;
+    double result=0;
+    for(const auto& p : path(from, to)){
+      result+=moveTime(current, p);
+      current=p;
+    }
+    return result;
+  }
+
+  /** Held-Karp: cost[visited][last] is the cheapest way to visit the set of bins, ending into last */
+  void ScanRoute::planExact(const std::vector<Bin>& bins){
+    const size_t n=bins.size();
+    if(n==0){
+      return;
+    }
+    const double INF=std::numeric_limits<double>::infinity();
+    std::vector<std::vector<double>> between(n, std::vector<double>(n));
+    for(size_t a=0; a<n; ++a){
+      for(size_t b=0; b<n; ++b){
+        between[a][b]=legCost(&bins[a], bins[b]);
+      }
+    }
+
+    const size_t subsets=size_t(1) << n;
+    std::vector<std::vector<double>> cost(subsets, std::vector<double>(n, INF));
+    std::vector<std::vector<int>> previous(subsets, std::vector<int>(n, -1));
+    for(size_t b=0; b<n; ++b){
+      cost[size_t(1) << b][b]=legCost(nullptr, bins[b]);
+    }
+    for(size_t visited=1; visited<subsets; ++visited){
+      for(size_t last=0; last<n; ++last){
+        if(cost[visited][last]==INF){
+          continue;
+        }
+        for(size_t next=0; next<n; ++next){
+          if(visited & (size_t(1) << next)){
+            continue;
+          }
+          size_t extended=visited | (size_t(1) << next);
+          double c=cost[visited][last]+between[last][next];
+          if(c<cost[extended][next]){
+            cost[extended][next]=c;
+            previous[extended][next]=last;
+          }
+        }
+      }
+    }
+
+    const size_t all=subsets-1;
+    int last=std::min_element(cost[all].begin(), cost[all].end())-cost[all].begin();
+    std::vector<Bin> reversed;
+    for(size_t visited=all; last>=0; ){
+      reversed.push_back(bins[last]);
+      int before=previous[visited][last];
+      visited&=~(size_t(1) << last);
+      last=before;
+    }
+    _order.assign(reversed.rbegin(), reversed.rend());
+  }
+
+  /** Nearest neighbour, then segments are reversed while the route gets shorter */
+  void ScanRoute::planHeuristic(const std::vector<Bin>& bins){
+    std::vector<Bin> left=bins;
+    const Bin* current=nullptr;
+    while(!left.empty()){
+      auto nearest=std::min_element(left.begin(), left.end(), [this, current] (const Bin& a, const Bin& b) {
+          return legCost(current, a)<legCost(current, b);
+          });
+      _order.push_back(*nearest);
+      left.erase(nearest);
+      current=&_order.back();
+    }
+
+    auto total=[this] (const std::vector<Bin>& route) {
+      double result=0;
+      for(size_t k=0; k<route.size(); ++k){
+        result+=legCost(k ? &route[k-1] : nullptr, route[k]);
+      }
+      return result;
+    };
+    double best=total(_order);
+    for(bool improved=true; improved; ){
+      improved=false;
+      for(size_t i=0; i<_order.size(); ++i){
+        for(size_t j=i+1; j<_order.size(); ++j){
+          std::vector<Bin> candidate=_order;
+          std::reverse(candidate.begin()+i, candidate.begin()+j+1);
+          double c=total(candidate);
+          if(c<best-1e-9){
+            best=c;
+            _order=candidate;
+            improved=true;
+          }
+        }
+      }
+    }
+  }
+}
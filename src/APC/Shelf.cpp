@@ -17,6 +17,9 @@ namespace APC {
   /** Distance from the front of a bin to the safe position (margin) */
   const double Shelf::SECURITY_DISTANCE=0.05;
 
+  /** Thickness of the walls between the bins */
+  const double Shelf::WALL_THICKNESS=0.01;
+
   /** Position of bin A wrt the origin of the shelf */
   const Pose Shelf::BIN0(0, -0.15, -0.30, 0, 0, 0);
 
@@ -32,4 +35,10 @@ namespace APC {
     return (getBinPose(i, j)+Pose(-Shelf::SECURITY_DISTANCE, -BIN_WIDTH/2, BIN_HEIGHT/2, 0, 0, 0));
   }
 
+  Eigen::AlignedBox3d Shelf::getBinBounds(int i, int j){
+    /** The corner is the front-left-bottom one: the bin goes deeper on X and rightwards on -Y */
+    Pose corner=getBinPose(i, j)+POSE;
+    return Eigen::AlignedBox3d(Eigen::Vector3d{corner.x, corner.y-BIN_WIDTH, corner.z}, Eigen::Vector3d{corner.x+BIN_DEPTH, corner.y, corner.z+BIN_HEIGHT});
+  }
+
 }
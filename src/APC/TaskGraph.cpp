@@ -0,0 +1,144 @@
+#include <APC/TaskGraph.h>
+#include <stdexcept>
+#include <Sim/Clock.h>
+#include <Sim/Timeline.h>
+
+namespace APC{
+  TaskGraph::TaskGraph(size_t nThreads)
+    :
+      _unfinished(0),
+      _stop(false)
+  {
+    for(size_t i=0; i<nThreads; ++i){
+      _threads.emplace_back(&TaskGraph::worker, this);
+    }
+  }
+
+  TaskGraph::~TaskGraph(){
+    waitAll();
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+      _stop=true;
+    }
+    _ready.notify_all();
+    for(auto& t : _threads){
+      t.join();
+    }
+  }
+
+  TaskGraph::Task TaskGraph::add(const std::function<void()>& f, const std::vector<Task>& dependencies, const std::string& name){
+    const double now=Sim::Clock::now();
+    std::lock_guard<std::mutex> lock(_mutex);
+    const Task task=_nodes.size();
+    for(Task d : dependencies){
+      if(d>=task){
+        throw std::logic_error("Tasks can only depend on tasks which have been added before");
+      }
+    }
+    _nodes.push_back(Node{f, 0, {}, false, nullptr, name, now, now});
+    ++_unfinished;
+
+    for(Task d : dependencies){
+      if(_nodes[d].done && _nodes[d].error){
+        /** It will never run */
+        finish(task, _nodes[d].error, std::max(now, _nodes[d].end));
+        return task;
+      }
+    }
+
+    for(Task d : dependencies){
+      if(!_nodes[d].done){
+        _nodes[d].successors.push_back(task);
+        ++_nodes[task].pending;
+      }
+      else{
+        _nodes[task].start=std::max(_nodes[task].start, _nodes[d].end);
+      }
+    }
+    if(_nodes[task].pending==0){
+      _queue.push(task);
+      _ready.notify_one();
+    }
+    return task;
+  }
+
+  void TaskGraph::finish(Task task, const std::exception_ptr& error, double end){
+    Node& node=_nodes[task];
+    node.done=true;
+    node.error=error;
+    node.end=end;
+    node.f=nullptr;
+    --_unfinished;
+
+    /** Copied: finishing the successors may grow _nodes */
+    const std::vector<Task> successors=node.successors;
+    for(Task s : successors){
+      Node& succ=_nodes[s];
+      if(succ.done){
+        continue;
+      }
+      succ.start=std::max(succ.start, end);
+      if(error){
+        finish(s, error, succ.start);
+      }
+      else if(--succ.pending==0){
+        _queue.push(s);
+        _ready.notify_one();
+      }
+    }
+    _finished.notify_all();
+  }
+
+  void TaskGraph::worker(){
+    std::unique_lock<std::mutex> lock(_mutex);
+    while(true){
+      _ready.wait(lock, [this] () { return _stop || !_queue.empty(); });
+      if(_queue.empty()){
+        return;
+      }
+      const Task task=_queue.front();
+      _queue.pop();
+      std::function<void()> f=_nodes[task].f;
+      const std::string name=_nodes[task].name;
+      const double start=_nodes[task].start;
+
+      lock.unlock();
+      Sim::Clock::startAt(start);
+      std::exception_ptr error;
+      try{
+        f();
+      }
+      catch(...){
+        error=std::current_exception();
+      }
+      const double end=Sim::Clock::now();
+      Sim::Timeline::getInstance().record(name, start, end);
+      lock.lock();
+      finish(task, error, end);
+    }
+  }
+
+  void TaskGraph::wait(Task task){
+    std::exception_ptr error;
+    double end;
+    std::string name;
+    {
+      /** The real time spent here is the one of the task, which is joined below */
+      Sim::Clock::Excluded blocked;
+      std::unique_lock<std::mutex> lock(_mutex);
+      _finished.wait(lock, [this, task] () { return _nodes[task].done; });
+      error=_nodes[task].error;
+      end=_nodes[task].end;
+      name=_nodes[task].name;
+    }
+    Sim::Clock::waitUntil(end, name.c_str());
+    if(error){
+      std::rethrow_exception(error);
+    }
+  }
+
+  void TaskGraph::waitAll(){
+    std::unique_lock<std::mutex> lock(_mutex);
+    _finished.wait(lock, [this] () { return _unfinished==0; });
+  }
+}
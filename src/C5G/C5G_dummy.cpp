@@ -19,11 +19,26 @@ namespace C5G{
     std::cout << "Global movement to (" << p.x << ", " << p.y << ", " << p.z << ")\nOrientation: (" << p.alpha << ", " << p.beta << ", " << p.gamma << "\n";
   }
 
+  /** Movements are instantaneous */
+  std::shared_future<void> C5G::moveCartesianGlobalAsync(const Pose& p, Blending){
+    moveCartesianGlobal(p);
+    std::promise<void> done;
+    done.set_value();
+    return done.get_future().share();
+  }
+
+  void C5G::waitMotion(){
+  }
+
   void C5G::init(){
     std::cout << "Initing the system..\nConnecting to IP address: " << _ip << "\nSystem ID: " << _sys_id << "\n";
     std::cout << "Done.\n";
   }
 
+  /** Nothing but what C5G already has */
+  struct C5G::Impl{
+  };
+
   C5G::C5G(const std::string& ip, const std::string& sys_id, bool mustinit)
     :
       _ip(ip),
@@ -1,6 +1,7 @@
 #include <boost/thread.hpp>
 #include <stdexcept>
 #include <boost/chrono.hpp>
+#include <future>
 #include <C5G/C5G.h>
 #include <C5G/userCallback.h>
 #include <eORL.h>
@@ -33,6 +34,7 @@ namespace C5G{
   }
 
   void C5G::setPosition(const Pose& p){
+    waitMotion();
     if(_currentMovementMode==MOVING_GLOBAL){
       /** We were in global mode; save current position in order to restore it when needed */
       _lastGlobalPose=ORL2Pose(current_position[0]);
@@ -44,6 +46,18 @@ namespace C5G{
   }
 
   void C5G::moveCartesianGlobal(const Pose& p){
+    moveCartesianGlobalAsync(p).get();
+  }
+
+  void C5G::waitMotion(){
+    if(_lastMove.valid()){
+      _lastMove.get();
+    }
+  }
+
+  /** Blending is not supported yet: every movement waits for the previous one to be over, so there would be nothing to blend with */
+  std::shared_future<void> C5G::moveCartesianGlobalAsync(const Pose& p, Blending){
+    waitMotion();
     ORL_cartesian_position  target_pos=pose2ORL(p);
     ORL_joint_value         target_jnt, temp_joints;
     int ret;
@@ -59,10 +73,17 @@ namespace C5G{
     std::cout << "--> Move acquired.\n";
 
     std::cout << "Global movement to (" << target_pos.x << ", " << target_pos.y << ", " << target_pos.z << ")\nOrientation: (" << target_pos.a << ", " << target_pos.e << ", " << target_pos.r << "\n";
+    /** Read before starting: the callback counts the completion of this movement only after flag_RunningMove is set */
+    const int completed=get_completed_moves(ORL_ARM1);
     flag_RunningMove[0] = 1;
-    while(flag_RunningMove[0]);
-    flag_hasCompletedTheMovement[0]=0;
-    std::cout << "Movement ended.\n";
+
+    /** The waiting thread sleeps on a futex which user_callback wakes up, instead of spinning on flag_RunningMove */
+    _lastMove=std::async(std::launch::async, [completed] () {
+        wait_move_completed(ORL_ARM1, completed);
+        flag_hasCompletedTheMovement[0]=0;
+        std::cout << "Movement ended.\n";
+        }).share();
+    return _lastMove;
   }
 
   /** TODO CHECK THIS!*/
@@ -175,6 +196,10 @@ namespace C5G{
     std::cout << "Goodbye.\n";
   }
 
+  /** Nothing but what C5G already has */
+  struct C5G::Impl{
+  };
+
   C5G::C5G(const std::string& ip, const std::string& sys_id, bool mustInit):
     _ip(ip),
     _sys_id(sys_id),
@@ -189,6 +214,7 @@ namespace C5G{
   }
 
   void C5G::setGripping(double strength){
+    waitMotion();
     std::cout << "Closing the plier with strength " << strength << "\n";
     boost::this_thread::sleep_for(boost::chrono::milliseconds(500));
   }
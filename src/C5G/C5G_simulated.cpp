@@ -0,0 +1,128 @@
+#include <algorithm>
+#include <iostream>
+#include <C5G/C5G.h>
+#include <C5G/Grasp.h>
+#include <Sim/Clock.h>
+#include <Sim/Motion.h>
+#include <Sim/Params.h>
+#include <Sim/Timeline.h>
+#include <Sim/World.h>
+
+/** Simulated robot: movements take the time given by the limits of Sim::Params, but no real time, as the clock is virtual
+ * (see Sim::Clock). The arm pose is published to Sim::World, for the simulated camera.
+ */
+namespace C5G{
+  namespace{
+    const char* const ROBOT="robot";
+
+    /** How far from the tool the gripper can take an object [m] */
+    const double REACH=0.1;
+
+    /** Speed at the end of the last movement, non zero if it flew by its pose */
+    double theExitSpeed=0;
+  }
+
+  void C5G::setZero(){
+    std::cout << "I'm now at zero.\n";
+  }
+
+  void C5G::moveCartesian(const Pose& p){
+    std::cout << "Relative movement to (" << p.x << ", " << p.y << ", " << p.z << ")\nOrientation: (" << p.alpha << ", " << p.beta << ", " << p.gamma << "\n";
+  }
+
+  const Pose C5G::safePose(){
+    static const Pose theSafePose(0.3, 0, 0.9, 0, 1.57, 0);
+    return theSafePose;
+  }
+
+  void C5G::moveCartesianGlobal(const Pose& p){
+    moveCartesianGlobalAsync(p).get();
+  }
+
+  /** Translation and rotation follow trapezoidal profiles, the slower one giving the duration. The speed is kept between
+   * movements flying by their pose if the next one is asked for before the robot gets there (otherwise the braking time is
+   * not accounted for).
+   */
+  std::shared_future<void> C5G::moveCartesianGlobalAsync(const Pose& p, Blending blending){
+    std::cout << "Global movement to (" << p.x << ", " << p.y << ", " << p.z << ")\nOrientation: (" << p.alpha << ", " << p.beta << ", " << p.gamma << "\n";
+    const Sim::Params& params=Sim::Params::get();
+    Sim::Timeline& timeline=Sim::Timeline::getInstance();
+    const double now=Sim::Clock::now();
+
+    const Eigen::Affine3d from=_lastGlobalPose.toTransform(), to=p.toTransform();
+    double entrySpeed=(now<timeline.busyUntil(ROBOT)) ? theExitSpeed : 0;
+    double exitSpeed=(blending==FLY) ? params.maxSpeed : 0;
+    double duration=Sim::trapezoidTime((to.translation()-from.translation()).norm(), params.maxSpeed, params.maxAcceleration, entrySpeed, exitSpeed);
+    double stopped=0;
+    double angle=Eigen::AngleAxisd(from.rotation().transpose()*to.rotation()).angle();
+    duration=std::max(duration, Sim::trapezoidTime(angle, params.maxAngularSpeed, params.maxAngularAcceleration, 0, stopped));
+
+    const double end=timeline.reserve(ROBOT, now, duration);
+    theExitSpeed=exitSpeed;
+    _lastGlobalPose=p;
+    Sim::World::getInstance().setArmPose(to);
+
+    /** Deferred: whoever waits for the movement jumps to its end */
+    _lastMove=std::async(std::launch::deferred, [end] () {
+        Sim::Clock::waitUntil(end, ROBOT);
+        }).share();
+    return _lastMove;
+  }
+
+  void C5G::waitMotion(){
+    if(_lastMove.valid()){
+      _lastMove.get();
+    }
+  }
+
+  void C5G::setPosition(const Pose& p){
+    waitMotion();
+    _lastGlobalPose=p;
+    Sim::World::getInstance().setArmPose(p.toTransform());
+  }
+
+  void C5G::init(){
+    std::cout << "Initing the simulated system..\nIP address: " << _ip << "\nSystem ID: " << _sys_id << "\n";
+    const Sim::Params& params=Sim::Params::get();
+    std::cout << "Limits: " << params.maxSpeed << " m/s, " << params.maxAcceleration << " m/s^2, " << params.maxAngularSpeed << " rad/s, " << params.maxAngularAcceleration << " rad/s^2\n";
+    std::cout << "Done.\n";
+  }
+
+  /** Nothing but what C5G already has */
+  struct C5G::Impl{
+  };
+
+  C5G::C5G(const std::string& ip, const std::string& sys_id, bool mustinit)
+    :
+      _ip(ip),
+      _sys_id(sys_id),
+      _currentMovementMode(MOVING_GLOBAL),
+      _lastGlobalPose(safePose())
+  {
+    Sim::Clock::setVirtual(true);
+    Sim::World::getInstance().setArmPose(_lastGlobalPose.toTransform());
+    if(mustinit){
+      init();
+    }
+  }
+
+  void C5G::standby(){
+    std::cout << "End of the simulation.\n";
+  }
+
+  void C5G::setGripping(double strength){
+    std::cout << "Closing the plier with strength " << strength << "\n";
+    waitMotion();
+    const double end=Sim::Timeline::getInstance().reserve(ROBOT, Sim::Clock::now(), Sim::Params::get().gripperTime);
+    Sim::Clock::waitUntil(end, ROBOT);
+    if(strength>0){
+      std::string taken=Sim::World::getInstance().grab(REACH);
+      std::cout << (taken=="" ? "Nothing to take here" : "Took "+taken) << "\n";
+    }
+  }
+
+  C5G::~C5G(){
+    waitMotion();
+    standby();
+  }
+}
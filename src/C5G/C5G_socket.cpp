@@ -1,16 +1,115 @@
-#include <C5G/C5G_socket.h>
+#include <C5G/C5G.h>
+#include <condition_variable>
+#include <map>
+#include <mutex>
 #include <stdexcept>
 #include <sstream>
+#include <thread>
+#include <boost/asio/connect.hpp>
+#include <boost/asio/io_service.hpp>
+#include <boost/asio/ip/tcp.hpp>
+#include <boost/asio/read_until.hpp>
+#include <boost/asio/streambuf.hpp>
+#include <boost/asio/write.hpp>
 
 namespace C5G{
+  /** Movements are streamed to the controller, up to WINDOW of them ahead of the one being executed.
+   * Protocol (one command or reply per line):
+   *   L <seq> <x,y,z,alpha,beta,gamma,blending>   move to the pose; blending is FLY to pass by the pose without stopping, empty to stop there
+   *   ACK <seq>                                   the movement has been queued by the controller
+   *   DONE <seq>                                  the movement is over (or the robot has flown by its pose)
+   *   ERR <seq>                                   the movement has been refused
+   * Sequence ids grow by one at every command, so that replies can be matched with the movements they refer to.
+   */
+  struct C5G::Impl{
+    static const std::string CONNECTION_PORT;
 
-  const std::string C5G::CONNECTION_PORT("1101");
+    /** All the socket operations happen on the thread running io */
+    boost::asio::io_service io;
+    boost::asio::ip::tcp::socket socket;
+    boost::asio::streambuf incoming;
+    std::thread ioThread;
+
+    /** Movements sent and not completed yet, by sequence id */
+    std::map<unsigned long, std::promise<void>> inFlight;
+    unsigned long nextSeq;
+    bool connectionLost;
+    std::mutex mutex;
+    std::condition_variable completed;
+
+    Impl()
+      :
+        socket(io),
+        nextSeq(0),
+        connectionLost(false)
+    {
+    }
+
+    void readReply(){
+      boost::asio::async_read_until(socket, incoming, '\n', [this] (const boost::system::error_code& ec, size_t) {
+          if(ec){
+            failAll("Connection to the robot lost: "+ec.message());
+            return;
+          }
+          std::istream in(&incoming);
+          std::string line;
+          std::getline(in, line);
+          std::istringstream parse(line);
+          std::string reply;
+          unsigned long seq;
+          if(parse >> reply >> seq){
+            handleReply(reply, seq);
+          }
+          else{
+            std::cerr << "Unexpected reply from the robot: " << line << "\n";
+          }
+          readReply();
+          });
+    }
+
+    void handleReply(const std::string& reply, unsigned long seq){
+      if(reply=="ACK"){
+        return;
+      }
+      std::lock_guard<std::mutex> lock(mutex);
+      auto it=inFlight.find(seq);
+      if(it==inFlight.end()){
+        std::cerr << "Reply " << reply << " for unknown movement " << seq << "\n";
+        return;
+      }
+      if(reply=="DONE"){
+        std::cout << "Movement " << seq << " ended.\n";
+        it->second.set_value();
+      }
+      else{
+        std::ostringstream what;
+        what << "Movement " << seq << " refused by the robot (" << reply << ")\n";
+        it->second.set_exception(std::make_exception_ptr(std::runtime_error(what.str())));
+      }
+      inFlight.erase(it);
+      completed.notify_all();
+    }
+
+    void failAll(const std::string& why){
+      std::lock_guard<std::mutex> lock(mutex);
+      connectionLost=true;
+      for(auto& m : inFlight){
+        m.second.set_exception(std::make_exception_ptr(std::runtime_error(why)));
+      }
+      inFlight.clear();
+      completed.notify_all();
+    }
+  };
+
+  const std::string C5G::Impl::CONNECTION_PORT("1101");
+  constexpr size_t C5G::WINDOW;
   void C5G::setZero(){
     setPosition(Pose(0, 0, 0, 0, 0, 0));
     std::cout << "I'm now at zero.\n";
   }
 
   void C5G::setPosition(const Pose& p){
+    waitMotion();
     if(_currentMovementMode==MOVING_GLOBAL){
       /** We were in global mode; save current position in order to restore it when needed */
       _lastGlobalPose={0,0,0,0,0,0};
@@ -20,16 +119,50 @@ namespace C5G{
   }
 
   void C5G::moveCartesianGlobal(const Pose& p){
+    moveCartesianGlobalAsync(p).get();
+  }
 
-    std::cout << "Global movement to " << p << "\n";
-    _connectionToRobot << "L <" << p.x << "," << p.y << "," << p.z << "," << p.alpha << "," << p.beta << "," << p.gamma << "," << ""/**TODO?*/<< ">";
-    _connectionToRobot.flush();
-    std::string s;
-    _connectionToRobot >> s;
-    if(s!="ACK"){
-      throw std::runtime_error("No ACK received\n");
+  std::shared_future<void> C5G::moveCartesianGlobalAsync(const Pose& p, Blending blending){
+    Impl& impl=*_impl;
+    std::shared_future<void> result;
+    unsigned long seq;
+    {
+      std::unique_lock<std::mutex> lock(impl.mutex);
+      impl.completed.wait(lock, [&impl] () { return impl.inFlight.size()<WINDOW || impl.connectionLost; });
+      if(impl.connectionLost){
+        throw std::runtime_error("Connection to the robot lost\n");
+      }
+      seq=impl.nextSeq++;
+      result=impl.inFlight[seq].get_future().share();
+      _lastMove=result;
+    }
+
+    std::cout << "Global movement " << seq << " to " << p << (blending==FLY ? " (fly by)" : "") << "\n";
+    auto command=std::make_shared<std::string>();
+    {
+      std::ostringstream s;
+      s << "L " << seq << " <" << p.x << "," << p.y << "," << p.z << "," << p.alpha << "," << p.beta << "," << p.gamma << "," << (blending==FLY ? "FLY" : "") << ">\n";
+      *command=s.str();
+    }
+    impl.io.post([&impl, command] () {
+        boost::system::error_code ec;
+        boost::asio::write(impl.socket, boost::asio::buffer(*command), ec);
+        if(ec){
+          impl.failAll("Couldn't send a movement: "+ec.message());
+        }
+        });
+    return result;
+  }
+
+  void C5G::waitMotion(){
+    std::shared_future<void> last;
+    {
+      std::lock_guard<std::mutex> lock(_impl->mutex);
+      last=_lastMove;
+    }
+    if(last.valid()){
+      last.get();
     }
-    std::cout << "Movement ended.\n";
   }
 
   /** TODO CHECK THIS!*/
@@ -43,11 +176,16 @@ namespace C5G{
   }
 
   void C5G::init(){
-    std::cout << "Connecting to " << _ip << " on port " << CONNECTION_PORT << "..\n";
-    _connectionToRobot.connect(_ip, CONNECTION_PORT);
-    if(!_connectionToRobot){
+    Impl& impl=*_impl;
+    std::cout << "Connecting to " << _ip << " on port " << Impl::CONNECTION_PORT << "..\n";
+    boost::system::error_code ec;
+    boost::asio::ip::tcp::resolver resolver(impl.io);
+    boost::asio::connect(impl.socket, resolver.resolve(boost::asio::ip::tcp::resolver::query(_ip, Impl::CONNECTION_PORT)), ec);
+    if(ec){
       throw std::runtime_error("Could not connect to robot!\n");
     }
+    impl.readReply();
+    impl.ioThread=std::thread([&impl] () { impl.io.run(); });
     std::cout << "Done.\n";
   }
 
@@ -67,7 +205,8 @@ namespace C5G{
     :
     _ip(ip),
     _sys_id(sys_id),
-    _currentMovementMode(MOVING_GLOBAL)
+    _currentMovementMode(MOVING_GLOBAL),
+    _impl(new Impl)
   {
     if(mustInit){
       init();
@@ -75,9 +214,18 @@ namespace C5G{
   }
   C5G::~C5G(){
     standby();
+    Impl& impl=*_impl;
+    if(impl.ioThread.joinable()){
+      impl.io.post([&impl] () {
+          boost::system::error_code ignored;
+          impl.socket.close(ignored);
+          });
+      impl.ioThread.join();
+    }
   }
 
   void C5G::setGripping(double strength){
+    waitMotion();
     std::cout << "Closing the plier with strength " << strength << "\n";
     boost::this_thread::sleep_for(boost::chrono::milliseconds(500));
   }
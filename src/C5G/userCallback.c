@@ -2,6 +2,30 @@
 #include <C5G/userCallback.h>
 #include <stdio.h>
 #include <string.h>
+#include <limits.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+
+void notify_move_completed(int idx_arm)
+{
+  __atomic_add_fetch(&completed_moves[idx_arm], 1, __ATOMIC_RELEASE);
+  syscall(SYS_futex, &completed_moves[idx_arm], FUTEX_WAKE_PRIVATE, INT_MAX, NULL, NULL, 0);
+}
+
+int get_completed_moves(int idx_arm)
+{
+  return __atomic_load_n(&completed_moves[idx_arm], __ATOMIC_ACQUIRE);
+}
+
+void wait_move_completed(int idx_arm, int completed)
+{
+  /* The kernel only puts us to sleep if the counter still has the value we have seen: no wake up can be lost */
+  while (get_completed_moves(idx_arm) == completed)
+  {
+    syscall(SYS_futex, &completed_moves[idx_arm], FUTEX_WAIT_PRIVATE, completed, NULL, NULL, 0);
+  }
+}
 
 int initialize_Control_position ( void )
 {
@@ -154,6 +178,7 @@ int user_callback (int period)
   int armIndex=0;
 
   flag_new_modality[armIndex] = false;
+  flag_MustSetComplete[armIndex] = false;
   modality_old[armIndex] = modality_active[armIndex];
   modality_active[armIndex] = ORLOPEN_GetModeMasterAx(ORL_SILENT,ORL_CNTRL01, armIndex);
   mask = ORLOPEN_GetOpenMask( ORL_SILENT,ORL_CNTRL01,armIndex );
@@ -238,6 +263,7 @@ int user_callback (int period)
   if(flag_MustSetComplete[armIndex]){
     flag_MustSetComplete[armIndex]=0;
     flag_hasCompletedTheMovement[armIndex] = 1;
+    notify_move_completed(armIndex);
   }
   return ORLOPEN_RES_OK;
 }
@@ -1,48 +1,193 @@
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
 #include <iostream>
+#include <map>
+#include <mutex>
+#include <set>
+#include <thread>
 #include <Img/Image.h>
 #include <Camera/ImageViewer.h>
 #include <highgui.h>
 
 namespace Camera{
+  namespace{
+#ifdef HEADLESS
+    std::atomic<bool> headless(true);
+#else
+    std::atomic<bool> headless(std::getenv("DISPLAY")==nullptr);
+#endif
+
+    /** How often the UI thread runs the event loop of the windows, when nothing new has to be drawn */
+    const int EVENT_LOOP_MS=10;
+  }
+
+  /** Owns all the windows: requests of the viewers are merged (the last image and title win) and carried out here */
+  class ImageViewer::UiThread{
+    public:
+      static std::shared_ptr<UiThread> get(){
+        static std::shared_ptr<UiThread> instance(new UiThread);
+        return instance;
+      }
+
+      ~UiThread(){
+        {
+          std::lock_guard<std::mutex> lock(_mutex);
+          _stop=true;
+        }
+        _changed.notify_all();
+        if(_thread.joinable()){
+          _thread.join();
+        }
+      }
+
+      void show(const std::string& ID, const Image& what){
+        post(ID, [&what] (Window& w) {
+            w.image=what;
+            w.hasImage=true;
+            });
+      }
+
+      void setTitle(const std::string& ID, const std::string& title){
+        post(ID, [&title] (Window& w) {
+            w.title=title;
+            w.hasTitle=true;
+            });
+      }
+
+      void close(const std::string& ID){
+        {
+          std::lock_guard<std::mutex> lock(_mutex);
+          if(!_thread.joinable()){
+            /** Nothing has ever been shown */
+            return;
+          }
+          _pending[ID].close=true;
+        }
+        _changed.notify_one();
+      }
+
+    private:
+      struct Window{
+        Image image;
+        bool hasImage;
+        std::string title;
+        bool hasTitle;
+        bool close;
+        Window() : hasImage(false), hasTitle(false), close(false) {}
+      };
+
+      UiThread()
+        :
+          _stop(false)
+      {
+      }
+
+      template<typename F>
+      void post(const std::string& ID, const F& change){
+        {
+          std::lock_guard<std::mutex> lock(_mutex);
+          if(!_thread.joinable()){
+            _thread=std::thread(&UiThread::run, this);
+          }
+          change(_pending[ID]);
+        }
+        _changed.notify_one();
+      }
+
+      void run(){
+        std::set<std::string> open;
+        std::unique_lock<std::mutex> lock(_mutex);
+        while(!_stop || !_pending.empty()){
+          _changed.wait_for(lock, std::chrono::milliseconds(EVENT_LOOP_MS), [this] () { return _stop || !_pending.empty(); });
+          std::map<std::string, Window> todo;
+          todo.swap(_pending);
+          lock.unlock();
+
+          for(auto& x : todo){
+            draw(x.first, x.second, open);
+          }
+          if(!open.empty()){
+            cv::waitKey(EVENT_LOOP_MS);
+          }
+
+          lock.lock();
+        }
+        lock.unlock();
+        for(const auto& ID : open){
+          cv::destroyWindow(ID+" (RGB)");
+          cv::destroyWindow(ID+" (DEPTH)");
+        }
+      }
+
+      static void draw(const std::string& ID, const Window& w, std::set<std::string>& open){
+        if(w.close){
+          if(open.erase(ID)){
+            cv::destroyWindow(ID+" (RGB)");
+            cv::destroyWindow(ID+" (DEPTH)");
+          }
+          return;
+        }
+        if(!open.count(ID)){
+          cv::namedWindow(ID+" (RGB)", cv::WINDOW_AUTOSIZE);
+          cv::namedWindow(ID+" (DEPTH)", cv::WINDOW_AUTOSIZE);
+          open.insert(ID);
+        }
+        if(w.hasImage){
+          ///cv::putText(_toRender.rgb, _title+" RGB", {0,0});
+          ///cv::putText(_toRender.depth, _title+" DEPTH", {0,0});
+          cv::imshow(ID+" (RGB)", w.image.rgb);
+          cv::imshow(ID+" (DEPTH)", w.image.depth);
+        }
+        if(w.hasTitle){
+          std::cout <<
+            "\n**********************************************\n"
+            << w.title <<
+            "\n**********************************************\n";
+        }
+      }
+
+      std::mutex _mutex;
+      std::condition_variable _changed;
+      std::map<std::string, Window> _pending;
+      bool _stop;
+      std::thread _thread;
+  };
+
   ImageViewer::ImageViewer(const std::string& ID)
     :
       _ID(ID),
-      _what()
+      _ui(UiThread::get())
   {
-      cv::namedWindow(_ID+" (RGB)", cv::WINDOW_AUTOSIZE);
-      cv::namedWindow(_ID+" (DEPTH)", cv::WINDOW_AUTOSIZE);
   }
 
   ImageViewer::~ImageViewer(){
-      cv::destroyWindow(_ID+" (RGB)");
-      cv::destroyWindow(_ID+" (DEPTH)");
-  }
-  void ImageViewer::updateMyself(){
-    _toRender=_what;
-    ///cv::putText(_toRender.rgb, _title+" RGB", {0,0});
-    ///cv::putText(_toRender.depth, _title+" DEPTH", {0,0});
-
-    //cv::destroyAllWindows();
-    cv::imshow(_ID+" (RGB)", _toRender.rgb);
-    cv::imshow(_ID+" (DEPTH)", _toRender.depth);
-    std::cout <<
-      "\n**********************************************\n"
-      << _title <<
-      "\n**********************************************\n";
-
-    //cv::putText(_ID+" (RGB)", _title+" RGB");
-    //cv::putText(_ID+" (DEPTH)", _title+" DEPTH");
-    cv::waitKey(10);
+    if(!headless){
+      _ui->close(_ID);
+    }
   }
 
   void ImageViewer::showImage(const Image& what){
-    _what=what;
-    updateMyself();
+    if(!headless){
+      _ui->show(_ID, what);
+    }
   }
 
   void ImageViewer::setTitle(const std::string& title){
-    _title=title;
-    updateMyself();
+    if(!headless){
+      _ui->setTitle(_ID, title);
+    }
+  }
+
+  void ImageViewer::setHeadless(bool h){
+#ifndef HEADLESS
+    headless=h;
+#endif
+  }
+
+  bool ImageViewer::isHeadless(){
+    return headless;
   }
 
 }
@@ -1,24 +1,63 @@
 #include <Camera/OpenniStreamProvider.h>
 #include <Img/Image.h>
+#include <chrono>
+#include <stdexcept>
+#include <unistd.h>
 
 namespace Camera{
-  OpenniStreamProvider::OpenniStreamProvider(const std::string& path, const std::string& ID)
+  const std::string OpenniStreamProvider::DEFAULT_STREAM="/apc_openni_stream";
+  const double OpenniStreamProvider::ATTACH_TIMEOUT=10;
+  const double OpenniStreamProvider::FRAME_TIMEOUT=2;
+
+  OpenniStreamProvider::OpenniStreamProvider(const std::string& name, const std::string& ID)
     :
 	ImageProvider(ID),
-  _path(path)
+  _name(name),
+  _lastSeq(0)
   {
-    std::cout << ImageProvider::_id << ": set default image path to " << _path+"/rgb.png" << " and "<< _path+"/depth.png" << "\n";
+    attach();
   };
-	
+
+  void OpenniStreamProvider::attach() const {
+    std::cout << ImageProvider::_id << ": waiting for the streamer to publish on " << _name << "..\n";
+    /** The old ring is kept until a new one is there, so that a failed attempt can be retried by the next getFrame */
+    std::unique_ptr<SharedFrameRing> ring;
+    const auto deadline=std::chrono::steady_clock::now()+std::chrono::duration<double>(ATTACH_TIMEOUT);
+    while(!ring){
+      try{
+        ring.reset(new SharedFrameRing(_name, SharedFrameRing::CONSUMER));
+      }
+      catch(const std::runtime_error& e){
+        if(std::chrono::steady_clock::now()>deadline){
+          throw std::runtime_error("No streamer publishing on "+_name+" (is it running?): "+e.what());
+        }
+        usleep(100000);
+      }
+    }
+    _ring=std::move(ring);
+    /** A new streamer counts its frames from the beginning */
+    _lastSeq=0;
+    std::cout << ImageProvider::_id << ": attached to " << _name << "\n";
+  }
+
   Img::Image OpenniStreamProvider::getFrame() const {
-    std::cout << "Waiting for a frame to arrive..\n";
-    system("touch /tmp/shameonme");
-    std::cout << "Lock acquired. Waiting for release..\n";
-    while(!system("ls /tmp/shameonme > /dev/null"));
-    std::cout << "Done.\n";
-    Image::Matrix rgb=cv::imread(_path+"/rgb.png");
-    Image::Matrix depthMap=cv::imread(_path+"/depth.png");
-    return Image(depthMap, rgb);
+    SharedFrameRing::FrameView v;
+    while(true){
+      if(!_ring->waitNewer(_lastSeq, v, int(FRAME_TIMEOUT*1000))){
+        if(!_ring->replaced()){
+          throw std::runtime_error("The streamer publishing on "+_name+" is stuck");
+        }
+        /** The old segment is never written anymore */
+        attach();
+        continue;
+      }
+      /** Image converts the depth map to meters, which is our only copy; the RGB buffer still has to be detached from the ring */
+      Image result(v.depth, v.rgb.clone());
+      if(v.stillValid()){
+        _lastSeq=v.seq;
+        return result;
+      }
+    }
 	}
   OpenniStreamProvider::~OpenniStreamProvider(){};
 }
@@ -0,0 +1,150 @@
+#include <Camera/RVL.h>
+#include <cstring>
+
+namespace Camera{
+  namespace RVL{
+
+    namespace{
+      class NibbleWriter{
+        public:
+          NibbleWriter(char* out)
+            :
+              _out(out),
+              _begin(out),
+              _word(0),
+              _nibbles(0)
+          {
+          }
+
+          void encode(uint32_t value){
+            do{
+              uint32_t nibble=value & 0x7;
+              value>>=3;
+              if(value){
+                nibble|=0x8;
+              }
+              _word=(_word<<4) | nibble;
+              if(++_nibbles==8){
+                flushWord();
+                _nibbles=0;
+                _word=0;
+              }
+            } while(value);
+          }
+
+          /** Flushes the last partial word, returning the number of bytes written */
+          size_t finish(){
+            if(_nibbles){
+              _word<<=4*(8-_nibbles);
+              flushWord();
+            }
+            return _out-_begin;
+          }
+
+        private:
+          /** The output is not guaranteed to be aligned, as several streams get packed into the same buffer */
+          void flushWord(){
+            std::memcpy(_out, &_word, sizeof(_word));
+            _out+=sizeof(_word);
+          }
+
+          char* _out;
+          char* _begin;
+          uint32_t _word;
+          int _nibbles;
+      };
+
+      class NibbleReader{
+        public:
+          NibbleReader(const char* in)
+            :
+              _in(in),
+              _begin(in),
+              _word(0),
+              _nibbles(0)
+          {
+          }
+
+          uint32_t decode(){
+            uint32_t value=0;
+            int shift=0;
+            uint32_t nibble;
+            do{
+              if(!_nibbles){
+                /** The stream is not guaranteed to be aligned inside a mmapped file */
+                std::memcpy(&_word, _in, sizeof(_word));
+                _in+=sizeof(_word);
+                _nibbles=8;
+              }
+              nibble=_word>>28;
+              value|=(nibble & 0x7) << shift;
+              _word<<=4;
+              --_nibbles;
+              shift+=3;
+            } while(nibble & 0x8);
+            return value;
+          }
+
+          size_t consumed() const {
+            return _in-_begin;
+          }
+
+        private:
+          const char* _in;
+          const char* _begin;
+          uint32_t _word;
+          int _nibbles;
+      };
+    }
+
+    size_t maxCompressedSize(size_t nPixels){
+      /** Worst case: alternating zero/non-zero pixels with 17 bit deltas = 1+1+6 nibbles every 2 pixels, plus the final runs */
+      return nPixels*4+16;
+    }
+
+    size_t compress(const uint16_t* input, size_t nPixels, std::vector<char>& output){
+      size_t start=output.size();
+      output.resize(start+maxCompressedSize(nPixels));
+      NibbleWriter w(&output[start]);
+
+      const uint16_t* end=input+nPixels;
+      int previous=0;
+      while(input!=end){
+        uint32_t zeros=0, nonzeros=0;
+        for(; input!=end && !*input; ++input, ++zeros);
+        w.encode(zeros);
+        for(const uint16_t* p=input; p!=end && *p; ++p, ++nonzeros);
+        w.encode(nonzeros);
+        for(uint32_t i=0; i<nonzeros; ++i){
+          int current=*input++;
+          int delta=current-previous;
+          w.encode((uint32_t(delta) << 1) ^ uint32_t(delta >> 31));
+          previous=current;
+        }
+      }
+      size_t written=w.finish();
+      output.resize(start+written);
+      return written;
+    }
+
+    size_t decompress(const char* input, uint16_t* output, size_t nPixels){
+      NibbleReader r(input);
+      int previous=0;
+      while(nPixels>0){
+        uint32_t zeros=r.decode();
+        nPixels-=zeros;
+        std::memset(output, 0, zeros*sizeof(uint16_t));
+        output+=zeros;
+        uint32_t nonzeros=r.decode();
+        nPixels-=nonzeros;
+        for(uint32_t i=0; i<nonzeros; ++i){
+          uint32_t positive=r.decode();
+          int delta=int(positive >> 1) ^ -int(positive & 1);
+          previous+=delta;
+          *output++=uint16_t(previous);
+        }
+      }
+      return r.consumed();
+    }
+  }
+}
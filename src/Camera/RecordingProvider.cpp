@@ -0,0 +1,173 @@
+#include <Camera/RecordingProvider.h>
+#include <Camera/RVL.h>
+#include <Img/Image.h>
+#include <stdexcept>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <opencv2/opencv.hpp>
+
+namespace Camera{
+  RecordingProvider::RecordingProvider(const std::string& filename, bool loop, int readAhead, const std::string& ID)
+    :
+      ImageProvider(ID),
+      _data(nullptr),
+      _size(0),
+      _loop(loop),
+      _readAhead(readAhead),
+      _stop(false),
+      _lastTimestamp(0),
+      _lastModel(0,0,0,0,0,0,0)
+  {
+    assert(readAhead>0);
+    int fd=open(filename.c_str(), O_RDONLY);
+    if(fd<0){
+      throw std::runtime_error("Couldn't open recording "+filename);
+    }
+    struct stat st;
+    fstat(fd, &st);
+    _size=st.st_size;
+    if(_size<sizeof(Recording::FileHeader)+sizeof(Recording::Trailer)){
+      close(fd);
+      throw std::runtime_error(filename+" is not a recording");
+    }
+    void* mem=mmap(nullptr, _size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if(mem==MAP_FAILED){
+      throw std::runtime_error("Couldn't map recording "+filename);
+    }
+    _data=static_cast<const char*>(mem);
+
+    const Recording::FileHeader* h=reinterpret_cast<const Recording::FileHeader*>(_data);
+    Recording::Trailer t;
+    std::memcpy(&t, _data+_size-sizeof(t), sizeof(t));
+    if(std::memcmp(h->magic, Recording::FILE_MAGIC, sizeof(h->magic)) || h->version!=Recording::VERSION
+        || std::memcmp(t.magic, Recording::TRAILER_MAGIC, sizeof(t.magic))
+        || t.indexOffset+t.nChunks*sizeof(uint64_t)+sizeof(t)!=_size){
+      munmap(mem, _size);
+      throw std::runtime_error(filename+" is not a valid recording (or it has not been closed)");
+    }
+
+    /** Only the headers are touched here: the payload is paged in on demand by the decoder */
+    _frames.reserve(t.nFrames);
+    for(uint64_t i=0; i<t.nChunks; ++i){
+      uint64_t offset;
+      std::memcpy(&offset, _data+t.indexOffset+i*sizeof(uint64_t), sizeof(offset));
+      const Recording::ChunkHeader* c=reinterpret_cast<const Recording::ChunkHeader*>(_data+offset);
+      assert(c->magic==Recording::CHUNK_MAGIC);
+      _chunkFirstFrame.push_back(_frames.size());
+      _chunks.emplace_back(_data+offset, sizeof(*c)+c->payloadBytes);
+      const char* p=reinterpret_cast<const char*>(c+1);
+      for(uint32_t j=0; j<c->nFrames; ++j){
+        const Recording::FrameHeader* f=reinterpret_cast<const Recording::FrameHeader*>(p);
+        _frames.push_back(f);
+        p+=Recording::frameRecordSize(*f);
+      }
+    }
+    if(_frames.empty()){
+      munmap(mem, _size);
+      throw std::runtime_error(filename+" contains no frames");
+    }
+    madvise(mem, _size, MADV_SEQUENTIAL);
+    std::cout << ImageProvider::_id << ": replaying " << _frames.size() << " frames from " << filename << "\n";
+
+    _decoder=std::thread(&RecordingProvider::decodeLoop, this);
+  }
+
+  RecordingProvider::~RecordingProvider(){
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+      _stop=true;
+    }
+    _notFull.notify_all();
+    _decoder.join();
+    munmap(const_cast<char*>(_data), _size);
+  }
+
+  size_t RecordingProvider::size() const {
+    return _frames.size();
+  }
+
+  RecordingProvider::Decoded RecordingProvider::decode(size_t index) const {
+    const Recording::FrameHeader* h=_frames[index];
+    const char* rgbData=reinterpret_cast<const char*>(h+1);
+    const char* depthData=rgbData+h->rgbBytes;
+
+    Image::Matrix rgb;
+    if(h->rgbCodec==Recording::RGB_RAW){
+      rgb=cv::Mat(h->height, h->width, CV_8UC3, const_cast<char*>(rgbData)).clone();
+    }
+    else{
+      /** Wraps the mapped bytes, so that no copy of the compressed stream is made */
+      rgb=cv::imdecode(cv::Mat(1, h->rgbBytes, CV_8UC1, const_cast<char*>(rgbData)), CV_LOAD_IMAGE_COLOR);
+    }
+    Image::Matrix depth(h->height, h->width, CV_16UC1);
+    RVL::decompress(depthData, depth.ptr<uint16_t>(), depth.total());
+
+    cv::Matx33f K(h->K);
+    cv::Matx44f extr(h->extr);
+    return Decoded{Image(depth, rgb), h->timestamp, CameraModel(h->width, h->height, K, extr), false};
+  }
+
+  void RecordingProvider::decodeLoop(){
+    size_t chunk=0;
+    size_t index=0;
+    while(true){
+      /** Ask the kernel to start reading the next chunk while we decode the current one */
+      if(chunk<_chunks.size() && index==_chunkFirstFrame[chunk]){
+        size_t next=(chunk+1)%_chunks.size();
+        const char* start=_chunks[next].first;
+        uintptr_t page=sysconf(_SC_PAGESIZE);
+        const char* aligned=reinterpret_cast<const char*>(reinterpret_cast<uintptr_t>(start) & ~(page-1));
+        madvise(const_cast<char*>(aligned), _chunks[next].second+(start-aligned), MADV_WILLNEED);
+        ++chunk;
+      }
+
+      Decoded d=(index<_frames.size() ? decode(index) : Decoded{Image(), 0, CameraModel(0,0,0,0,0,0,0), true});
+
+      std::unique_lock<std::mutex> lock(_mutex);
+      _notFull.wait(lock, [this] { return _stop || _queue.size()<_readAhead; });
+      if(_stop){
+        return;
+      }
+      _queue.push_back(d);
+      lock.unlock();
+      _notEmpty.notify_one();
+
+      if(d.end){
+        return;
+      }
+      if(++index==_frames.size() && _loop){
+        index=0;
+        chunk=0;
+      }
+    }
+  }
+
+  Img::Image RecordingProvider::getFrame() const {
+    std::unique_lock<std::mutex> lock(_mutex);
+    _notEmpty.wait(lock, [this] { return !_queue.empty(); });
+    Decoded d=_queue.front();
+    if(d.end){
+      /** Leave the marker in the queue, so that every further call throws as well */
+      throw std::runtime_error("End of the recording reached");
+    }
+    _queue.pop_front();
+    lock.unlock();
+    _notFull.notify_one();
+
+    _lastTimestamp=d.timestamp;
+    _lastModel=d.model;
+    return d.frame;
+  }
+
+  uint64_t RecordingProvider::lastTimestamp() const {
+    return _lastTimestamp;
+  }
+
+  CameraModel RecordingProvider::lastCameraModel() const {
+    return _lastModel;
+  }
+}
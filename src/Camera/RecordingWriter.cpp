@@ -0,0 +1,141 @@
+#include <Camera/Recording.h>
+#include <Camera/RVL.h>
+#include <stdexcept>
+#include <cassert>
+#include <cstring>
+#include <time.h>
+#include <opencv2/opencv.hpp>
+
+namespace Camera{
+
+  namespace Recording{
+    const char FILE_MAGIC[8]={'A','P','C','R','G','B','D','1'};
+    const char TRAILER_MAGIC[8]={'A','P','C','R','G','B','D','E'};
+    const uint32_t CHUNK_MAGIC=0x4b4e4843; /* "CHNK" */
+    const uint32_t VERSION=1;
+  }
+
+  RecordingWriter::RecordingWriter(const std::string& filename, Recording::RgbCodec codec, int framesPerChunk, int jpegQuality)
+    :
+      _out(filename, std::ios::binary | std::ios::trunc),
+      _codec(codec),
+      _framesPerChunk(framesPerChunk),
+      _jpegQuality(jpegQuality),
+      _framesInChunk(0),
+      _nFrames(0),
+      _closed(false)
+  {
+    assert(framesPerChunk>0);
+    if(!_out){
+      throw std::runtime_error("Couldn't open "+filename+" for writing");
+    }
+    Recording::FileHeader h;
+    std::memcpy(h.magic, Recording::FILE_MAGIC, sizeof(h.magic));
+    h.version=Recording::VERSION;
+    h.reserved=0;
+    _out.write(reinterpret_cast<const char*>(&h), sizeof(h));
+  }
+
+  RecordingWriter::~RecordingWriter(){
+    if(!_closed){
+      close();
+    }
+  }
+
+  uint64_t RecordingWriter::framesWritten() const {
+    return _nFrames;
+  }
+
+  void RecordingWriter::addFrame(const Img::Image& frame, const CameraModel& model, uint64_t timestamp){
+    assert(!_closed && "Recording already closed");
+    assert(frame.rgb.type()==CV_8UC3);
+    assert(frame.rgb.size()==frame.depth.size());
+
+    if(timestamp==0){
+      timespec t;
+      clock_gettime(CLOCK_REALTIME, &t);
+      timestamp=uint64_t(t.tv_sec)*1000000000ULL+t.tv_nsec;
+    }
+
+    if(frame.depth.depth()==CV_16U){
+      _depthMm=frame.depth;
+    }
+    else{
+      /** Back to mm, as Img::Image stores depth in meters */
+      frame.depth.convertTo(_depthMm, CV_16U, 1000.0);
+    }
+    if(!_depthMm.isContinuous()){
+      _depthMm=_depthMm.clone();
+    }
+
+    Recording::FrameHeader h;
+    std::memset(&h, 0, sizeof(h));
+    h.timestamp=timestamp;
+    h.width=frame.rgb.cols;
+    h.height=frame.rgb.rows;
+    h.rgbCodec=_codec;
+
+    cv::Matx33f K=model.getIntrinsic();
+    std::memcpy(h.K, K.val, sizeof(h.K));
+    Eigen::Matrix<float, 4, 4, Eigen::RowMajor> extr=model.getExtrinsic().matrix();
+    std::memcpy(h.extr, extr.data(), sizeof(h.extr));
+
+    const uchar* rgbData;
+    if(_codec==Recording::RGB_RAW){
+      cv::Mat rgb=frame.rgb.isContinuous() ? frame.rgb : frame.rgb.clone();
+      _encoded.assign(rgb.data, rgb.data+rgb.total()*rgb.elemSize());
+    }
+    else if(_codec==Recording::RGB_PNG){
+      /** Fastest zlib level: the goal is decoding speed and a reasonable size, not the smallest file */
+      cv::imencode(".png", frame.rgb, _encoded, {CV_IMWRITE_PNG_COMPRESSION, 1});
+    }
+    else{
+      cv::imencode(".jpg", frame.rgb, _encoded, {CV_IMWRITE_JPEG_QUALITY, _jpegQuality});
+    }
+    rgbData=_encoded.data();
+    h.rgbBytes=_encoded.size();
+
+    size_t headerPos=_chunk.size();
+    _chunk.resize(headerPos+sizeof(h));
+    _chunk.insert(_chunk.end(), rgbData, rgbData+h.rgbBytes);
+    h.depthBytes=RVL::compress(_depthMm.ptr<uint16_t>(), _depthMm.total(), _chunk);
+    std::memcpy(&_chunk[headerPos], &h, sizeof(h));
+    _chunk.resize(headerPos+Recording::frameRecordSize(h), 0);
+
+    ++_nFrames;
+    if(++_framesInChunk==uint32_t(_framesPerChunk)){
+      flushChunk();
+    }
+  }
+
+  void RecordingWriter::flushChunk(){
+    if(_framesInChunk==0){
+      return;
+    }
+    Recording::ChunkHeader h;
+    h.magic=Recording::CHUNK_MAGIC;
+    h.nFrames=_framesInChunk;
+    h.payloadBytes=_chunk.size();
+    _chunkOffsets.push_back(_out.tellp());
+    _out.write(reinterpret_cast<const char*>(&h), sizeof(h));
+    _out.write(_chunk.data(), _chunk.size());
+    if(!_out){
+      throw std::runtime_error("Error while writing a recording chunk");
+    }
+    _chunk.clear();
+    _framesInChunk=0;
+  }
+
+  void RecordingWriter::close(){
+    flushChunk();
+    Recording::Trailer t;
+    t.indexOffset=_out.tellp();
+    t.nChunks=_chunkOffsets.size();
+    t.nFrames=_nFrames;
+    std::memcpy(t.magic, Recording::TRAILER_MAGIC, sizeof(t.magic));
+    _out.write(reinterpret_cast<const char*>(_chunkOffsets.data()), _chunkOffsets.size()*sizeof(uint64_t));
+    _out.write(reinterpret_cast<const char*>(&t), sizeof(t));
+    _out.close();
+    _closed=true;
+  }
+}
@@ -0,0 +1,238 @@
+#include <Camera/SharedFrameRing.h>
+#include <Img/Image.h>
+#include <stdexcept>
+#include <cassert>
+#include <chrono>
+#include <climits>
+#include <cerrno>
+#include <cstring>
+#include <new>
+#include <fcntl.h>
+#include <unistd.h>
+#include <time.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+
+namespace Camera{
+
+  namespace{
+    const int WIDTH=640;
+    const int HEIGHT=480;
+    const uint32_t MAGIC=0x52474244; /* "RGBD" */
+
+    /** The segment is shared between processes, so the futex calls MUST NOT be the private variants */
+    int futexWait(const std::atomic<uint32_t>* addr, uint32_t val, const timespec* timeout){
+      return syscall(SYS_futex, reinterpret_cast<const uint32_t*>(addr), FUTEX_WAIT, val, timeout, nullptr, 0);
+    }
+
+    int futexWakeAll(std::atomic<uint32_t>* addr){
+      return syscall(SYS_futex, reinterpret_cast<uint32_t*>(addr), FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0);
+    }
+
+    uint64_t monotonicNs(){
+      timespec t;
+      clock_gettime(CLOCK_MONOTONIC, &t);
+      return uint64_t(t.tv_sec)*1000000000ULL+t.tv_nsec;
+    }
+  }
+
+  struct SharedFrameRing::Slot{
+    /** Seqlock: odd while the producer is writing into the slot */
+    std::atomic<uint32_t> version;
+    std::atomic<uint64_t> seq;
+    std::atomic<uint64_t> timestamp;
+    alignas(64) uint16_t depth[WIDTH*HEIGHT];
+    alignas(64) uint8_t rgb[WIDTH*HEIGHT*3];
+  };
+
+  struct SharedFrameRing::Header{
+    std::atomic<uint32_t> magic;
+    /** Futex word, incremented at every publication */
+    std::atomic<uint32_t> published;
+    std::atomic<uint64_t> lastSeq;
+    alignas(64) Slot slots[SharedFrameRing::SLOTS];
+  };
+
+  SharedFrameRing::FrameView::FrameView()
+    :
+      seq(0),
+      timestamp(0),
+      _version(nullptr),
+      _seenVersion(0)
+  {
+  }
+
+  bool SharedFrameRing::FrameView::stillValid() const {
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return _version!=nullptr && _version->load(std::memory_order_relaxed)==_seenVersion;
+  }
+
+  SharedFrameRing::SharedFrameRing(const std::string& name, Mode mode)
+    :
+      _name(name),
+      _mode(mode),
+      _size(sizeof(Header)),
+      _header(nullptr),
+      _device(0),
+      _inode(0)
+  {
+    assert(WIDTH==Img::Image::ALLOWED_WIDTH && HEIGHT==Img::Image::ALLOWED_HEIGHT);
+    int fd;
+    if(_mode==PRODUCER){
+      /** Remove stale segments left by a crashed streamer, so that the layout is always fresh */
+      shm_unlink(_name.c_str());
+      fd=shm_open(_name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0666);
+      if(fd<0){
+        throw std::runtime_error("Couldn't create shared memory segment "+_name+": "+strerror(errno));
+      }
+      if(ftruncate(fd, _size)!=0){
+        close(fd);
+        throw std::runtime_error("Couldn't resize shared memory segment "+_name+": "+strerror(errno));
+      }
+    }
+    else{
+      fd=shm_open(_name.c_str(), O_RDONLY, 0);
+      if(fd<0){
+        throw std::runtime_error("Couldn't open shared memory segment "+_name+": "+strerror(errno));
+      }
+      struct stat st;
+      if(fstat(fd, &st)!=0 || size_t(st.st_size)<_size){
+        close(fd);
+        throw std::runtime_error("Shared memory segment "+_name+" is not a frame ring");
+      }
+    }
+
+    struct stat st;
+    if(fstat(fd, &st)==0){
+      _device=st.st_dev;
+      _inode=st.st_ino;
+    }
+
+    void* mem=mmap(nullptr, _size, _mode==PRODUCER ? PROT_READ | PROT_WRITE : PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if(mem==MAP_FAILED){
+      throw std::runtime_error("Couldn't map shared memory segment "+_name+": "+strerror(errno));
+    }
+
+    if(_mode==PRODUCER){
+      /** ftruncate zero-fills the segment, which is a valid initial state for all the atomics */
+      _header=new(mem) Header;
+      _header->published.store(0, std::memory_order_relaxed);
+      _header->lastSeq.store(0, std::memory_order_relaxed);
+      for(int i=0; i<SLOTS; ++i){
+        _header->slots[i].version.store(0, std::memory_order_relaxed);
+        _header->slots[i].seq.store(0, std::memory_order_relaxed);
+      }
+      _header->magic.store(MAGIC, std::memory_order_release);
+    }
+    else{
+      _header=static_cast<Header*>(mem);
+      if(_header->magic.load(std::memory_order_acquire)!=MAGIC){
+        munmap(mem, _size);
+        throw std::runtime_error("Shared memory segment "+_name+" has not been initialized yet");
+      }
+    }
+  }
+
+  SharedFrameRing::~SharedFrameRing(){
+    munmap(_header, _size);
+    if(_mode==PRODUCER){
+      shm_unlink(_name.c_str());
+    }
+  }
+
+  bool SharedFrameRing::replaced() const {
+    int fd=shm_open(_name.c_str(), O_RDONLY, 0);
+    if(fd<0){
+      return true;
+    }
+    struct stat st;
+    bool same=(fstat(fd, &st)==0 && uint64_t(st.st_dev)==_device && uint64_t(st.st_ino)==_inode);
+    close(fd);
+    return !same;
+  }
+
+  SharedFrameRing::Slot& SharedFrameRing::slot(uint64_t seq) const {
+    return _header->slots[seq%SLOTS];
+  }
+
+  uint64_t SharedFrameRing::publish(const cv::Mat& depth, const cv::Mat& rgb){
+    assert(_mode==PRODUCER && "Only the producer can publish frames");
+    assert(depth.rows==HEIGHT && depth.cols==WIDTH && depth.type()==CV_16UC1);
+    assert(rgb.rows==HEIGHT && rgb.cols==WIDTH && rgb.type()==CV_8UC3);
+
+    uint64_t seq=_header->lastSeq.load(std::memory_order_relaxed)+1;
+    Slot& s=slot(seq);
+
+    s.version.fetch_add(1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    cv::Mat dstDepth(HEIGHT, WIDTH, CV_16UC1, s.depth);
+    cv::Mat dstRgb(HEIGHT, WIDTH, CV_8UC3, s.rgb);
+    depth.copyTo(dstDepth);
+    rgb.copyTo(dstRgb);
+    s.seq.store(seq, std::memory_order_relaxed);
+    s.timestamp.store(monotonicNs(), std::memory_order_relaxed);
+
+    s.version.fetch_add(1, std::memory_order_release);
+    _header->lastSeq.store(seq, std::memory_order_release);
+    _header->published.fetch_add(1, std::memory_order_release);
+    futexWakeAll(&_header->published);
+    return seq;
+  }
+
+  uint64_t SharedFrameRing::lastSeq() const {
+    return _header->lastSeq.load(std::memory_order_acquire);
+  }
+
+  bool SharedFrameRing::view(uint64_t seq, FrameView& v) const {
+    const Slot& s=slot(seq);
+    uint32_t version=s.version.load(std::memory_order_acquire);
+    if(version & 1){
+      return false;
+    }
+    v.seq=s.seq.load(std::memory_order_relaxed);
+    v.timestamp=s.timestamp.load(std::memory_order_relaxed);
+    v._version=&s.version;
+    v._seenVersion=version;
+    if(v.seq!=seq || !v.stillValid()){
+      return false;
+    }
+    /** The segment is mapped read-only on the consumer side: these matrices MUST NOT be written */
+    v.depth=cv::Mat(HEIGHT, WIDTH, CV_16UC1, const_cast<uint16_t*>(s.depth));
+    v.rgb=cv::Mat(HEIGHT, WIDTH, CV_8UC3, const_cast<uint8_t*>(s.rgb));
+    return true;
+  }
+
+  bool SharedFrameRing::waitNewer(uint64_t after, FrameView& v, int timeoutMs) const {
+    typedef std::chrono::steady_clock Clock;
+    const Clock::time_point deadline=Clock::now()+std::chrono::milliseconds(timeoutMs);
+    while(true){
+      uint32_t published=_header->published.load(std::memory_order_acquire);
+      uint64_t last=_header->lastSeq.load(std::memory_order_acquire);
+      if(last>after){
+        if(view(last, v)){
+          return true;
+        }
+        /** The producer lapped us while we were looking at the slot: just pick the newest one again */
+        continue;
+      }
+
+      if(timeoutMs<0){
+        futexWait(&_header->published, published, nullptr);
+      }
+      else{
+        auto remaining=std::chrono::duration_cast<std::chrono::nanoseconds>(deadline-Clock::now()).count();
+        if(remaining<=0){
+          return false;
+        }
+        timespec t;
+        t.tv_sec=remaining/1000000000LL;
+        t.tv_nsec=remaining%1000000000LL;
+        futexWait(&_header->published, published, &t);
+      }
+    }
+  }
+}
@@ -1,3 +1,5 @@
+#include <algorithm>
+#include <limits>
 #include <Gripper/ComposedShape.h>
 #include <Gripper/ShapeBuilder.h>
 #include <Utils/Eigen2CV.h>
@@ -6,8 +8,26 @@ namespace Gripper{
   std::string ComposedShape::getID() const {
     return "Composed";
   }
-  auto ComposedShape::getKnownIntersections() const -> KnownIntersections{
-    return {"Anything"};
+  auto ComposedShape::getType() const -> Type{
+    return COMPOSED;
+  }
+
+  Eigen::AlignedBox3d ComposedShape::getLocalBounds() const {
+    Eigen::AlignedBox3d result;
+    for(const auto& x : _components){
+      result.extend(x->getBounds());
+    }
+    return result;
+  }
+
+  double ComposedShape::getSignedDistance(const Eigen::Vector3d& p) const {
+    /** Components are expressed in our own frame */
+    Eigen::Vector3d local=_pose.inverse(Eigen::Isometry)*p;
+    double result=std::numeric_limits<double>::max();
+    for(const auto& x : _components){
+      result=std::min(result, x->getSignedDistance(local));
+    }
+    return result;
   }
 
   double ComposedShape::getVolume() const {
@@ -20,10 +40,20 @@ namespace Gripper{
   double ComposedShape::getIntersectionVolume(const Shape& s) const {
     double result=0;
     for(const auto& x : _components){
-      result+=x->getIntersectionVolume(s);
+      /** Components are expressed in our own frame */
+      result+=(_pose*x)->getIntersectionVolume(s);
     }
     return result;
   }
+
+  bool ComposedShape::intersects(const Shape& s) const {
+    for(const auto& x : _components){
+      if((_pose*x)->intersects(s)){
+        return true;
+      }
+    }
+    return false;
+  }
   ComposedShape::ComposedShape(const Eigen::Affine3d& pose, const Components& comp)
     :
       Shape(pose, {}),
@@ -52,6 +82,20 @@ namespace Gripper{
     return _pose*result;
   }
 
+  ComposedShape::PointsMatrix ComposedShape::getWeightedCubettiVolume(size_t level, std::vector<double>& weights) const{
+    PointsMatrix result(4,0);
+    weights.clear();
+    for(const auto& x: _components){
+      std::vector<double> partialWeights;
+      const auto& partial=x->getWeightedCubettiVolume(level, partialWeights);
+      size_t curSize=result.cols();
+      result.conservativeResize(Eigen::NoChange,curSize+partial.cols());
+      result.rightCols(partial.cols())=partial;
+      weights.insert(weights.end(), partialWeights.begin(), partialWeights.end());
+    }
+    return _pose*result;
+  }
+
   void ComposedShape::writeTo(cv::FileStorage& fs) const{
     fs << "{";
     fs << "name" << getID();
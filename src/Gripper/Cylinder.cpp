@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <cmath>
 
 #include <Eigen/Geometry>
@@ -13,99 +14,48 @@ namespace Gripper{
   {
   }
 
-  Cylinder::PointsMatrix Cylinder::getCubettiSurface(size_t level) const{
-    size_t pos=0;
-
-    double H=_dimensions[1];
-    double R=_dimensions[0];
-    double stepZ=H/level;
-    double stepR=R/level;
-    double stepAngle=2*M_PI/level;
-
-    size_t expectedSize=3*level*level-level+2;
-    PointsMatrix result(4, expectedSize);
-    /** On height */
-    for(size_t i=0; i<=level; ++i){
-      double z=stepZ*i;
-      for(size_t j=0; j<level; ++j){
-        double alpha=j*stepAngle;
-        double x=R*cos(alpha), y=R*sin(alpha);
-        result.col(pos++)=Eigen::Vector4d{x,y,z,1};
-      }
-    }
-
-    /** Now add caps */
-    for(size_t i=1; i<level; ++i){
-      double r=stepR*i;
-      for(size_t j=0; j<level; ++j){
-        double alpha=j*stepAngle;
-        double x=r*cos(alpha), y=r*sin(alpha);
-        result.col(pos++)=Eigen::Vector4d{x,y,0,1};
-        result.col(pos++)=Eigen::Vector4d{x,y,H,1};
-      }
-    }
-
-    /** Center of caps, just for beautiness */
-    result.col(pos++)=Eigen::Vector4d{0,0,0,1};
-    result.col(pos++)=Eigen::Vector4d{0,0,H,1};
-    assert(pos==expectedSize);
-    return _pose*result;
-
+  Samples::Ptr Cylinder::getUnitSurface(size_t level) const{
+    return Samples::get(Samples::CYLINDER_SURFACE, level);
   }
 
-  Cylinder::PointsMatrix Cylinder::getCubettiVolume(size_t level) const{
-    /** Get an approximation using points of this cube size 1/level */
-    double stepX=2.0/level;
-    double stepY=2.0/level;
-    double stepZ=1.0/level;
-    double startX=-1.0+stepX/2.0;
-    double startY=-1.0+stepY/2.0;
-    double startZ=stepZ/2.0;
-
-    Eigen::Matrix<double, Eigen::Dynamic, 4> cubePoints(level*level*level, 4);
-
-    size_t pos=0;
-    for(size_t i=0; i<level; ++i){
-      for(size_t j=0; j<level; ++j){
-        for(size_t k=0; k<level; ++k){
-          double x=startX+i*stepX, y=startY+j*stepY, z=startZ+k*stepZ;
-          if(x*x+y*y<1.0){
-            cubePoints.row(pos++)=Eigen::Vector4d{x,y,z,1}.transpose();
-          }
-        }
-      }
-    }
+  Samples::Ptr Cylinder::getUnitVolume(size_t level) const{
+    return Samples::get(Samples::CYLINDER_VOLUME, level);
+  }
 
-    cubePoints.conservativeResize(pos, Eigen::NoChange);
-    Eigen::Matrix4d mySize;
+  Eigen::Affine3d Cylinder::getUnitToWorld() const{
+    double r=_dimensions[0], h=_dimensions[1];
+    return _pose*Eigen::Scaling(r, r, h);
+  }
 
-    double r=_dimensions[0];
-    double H=_dimensions[1];
-    mySize << 
-      r, 0, 0, 0,
-      0, r, 0, 0,
-      0, 0, H, 0,
-      0, 0, 0, 1;
-    return (_pose*mySize*cubePoints.transpose());
+  Samples::Containment Cylinder::getContainment() const{
+    double r=_dimensions[0], h=_dimensions[1];
+    return Samples::Containment{Samples::Containment::UNIT_CYLINDER, Eigen::Scaling(1.0/r, 1.0/r, 1.0/h)*_pose.inverse(Eigen::Isometry)};
   }
+
   std::string Cylinder::getID() const{
     return "Cylinder";
   }
+  Shape::Type Cylinder::getType() const{
+    return CYLINDER;
+  }
+  Eigen::AlignedBox3d Cylinder::getLocalBounds() const {
+    double r=_dimensions[0], h=_dimensions[1];
+    return Eigen::AlignedBox3d(Eigen::Vector3d{-r, -r, 0}, Eigen::Vector3d{r, r, h});
+  }
+  double Cylinder::getSignedDistance(const Eigen::Vector3d& p) const {
+    double r=_dimensions[0], h=_dimensions[1];
+    Eigen::Vector3d local=_pose.inverse(Eigen::Isometry)*p;
+    /** Distances from the side and from the caps */
+    Eigen::Vector2d d{local.head<2>().norm()-r, std::abs(local[2]-h/2)-h/2};
+    return std::min(d.maxCoeff(), 0.0)+d.cwiseMax(0.0).norm();
+  }
   double Cylinder::getVolume() const{
     double r=_dimensions[0], h=_dimensions[1];
     return r*r*M_PI*h;
   }
 
-  size_t Cylinder::countContainedPoints(const PointsMatrix& pt) const {
-    auto myFramePts=(_pose.inverse().matrix()*pt).topRows<3>().array();
-    auto d=_dimensions;
-    Eigen::Array<bool,1,Eigen::Dynamic> ltdPoints=(myFramePts.row(2) < d[2] ) && (myFramePts.row(2) > 0);
-    Eigen::Array<bool,1,Eigen::Dynamic> inCirclePoints=myFramePts.cwiseAbs2().colwise().sum() < d[0]*d[0];
-    return (ltdPoints && inCirclePoints).count();
-  }
   Shape* Cylinder::clone() const {
     return new Cylinder(*this);
   }
 
 }
-
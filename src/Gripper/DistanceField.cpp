@@ -0,0 +1,118 @@
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <Gripper/DistanceField.h>
+
+namespace Gripper{
+  constexpr DistanceField::Id DistanceField::NONE;
+
+  DistanceField::DistanceField(const Eigen::AlignedBox3d& region, double voxelSize)
+    :
+      _region(region),
+      _voxelSize(voxelSize)
+  {
+    if(region.isEmpty() || voxelSize<=0){
+      throw std::runtime_error("Invalid region for the distance field");
+    }
+    _size=(region.sizes()/voxelSize).array().ceil().cast<int>().max(1);
+    _far=region.diagonal().norm();
+    size_t n=size_t(_size[0])*_size[1]*_size[2];
+    _distance.assign(n, _far);
+    _owner.assign(n, NONE);
+  }
+
+  size_t DistanceField::index(int x, int y, int z) const {
+    return (size_t(z)*_size[1]+y)*_size[0]+x;
+  }
+
+  Eigen::Vector3d DistanceField::center(int x, int y, int z) const {
+    return _region.min()+(Eigen::Vector3d{double(x), double(y), double(z)}.array()+0.5).matrix()*_voxelSize;
+  }
+
+  Eigen::Vector3d DistanceField::toGrid(const Eigen::Vector3d& p) const {
+    Eigen::Array3d g=(p-_region.min()).array()/_voxelSize-0.5;
+    return g.max(0.0).min((_size.array()-1).cast<double>()).matrix();
+  }
+
+  DistanceField::Id DistanceField::add(const Shape::Ptr& shape, double weight){
+    Id id=_shapes.size();
+    _shapes.push_back(shape);
+    _weights.push_back(weight);
+    for(int z=0; z<_size[2]; ++z){
+      for(int y=0; y<_size[1]; ++y){
+        for(int x=0; x<_size[0]; ++x){
+          size_t i=index(x, y, z);
+          float d=shape->getSignedDistance(center(x, y, z));
+          if(d<_distance[i]){
+            _distance[i]=d;
+            _owner[i]=id;
+          }
+        }
+      }
+    }
+    return id;
+  }
+
+  void DistanceField::remove(Id id){
+    if(id<0 || size_t(id)>=_shapes.size() || !_shapes[id]){
+      throw std::runtime_error("Removing a shape which is not into the distance field");
+    }
+    _shapes[id].reset();
+    for(int z=0; z<_size[2]; ++z){
+      for(int y=0; y<_size[1]; ++y){
+        for(int x=0; x<_size[0]; ++x){
+          size_t i=index(x, y, z);
+          if(_owner[i]!=id){
+            continue;
+          }
+          const Eigen::Vector3d c=center(x, y, z);
+          _distance[i]=_far;
+          _owner[i]=NONE;
+          for(size_t other=0; other<_shapes.size(); ++other){
+            if(!_shapes[other]){
+              continue;
+            }
+            float d=_shapes[other]->getSignedDistance(c);
+            if(d<_distance[i]){
+              _distance[i]=d;
+              _owner[i]=other;
+            }
+          }
+        }
+      }
+    }
+  }
+
+  double DistanceField::distance(const Eigen::Vector3d& p) const {
+    const Eigen::Vector3d g=toGrid(p);
+    const Eigen::Vector3i base=g.cast<int>().cwiseMin(_size-Eigen::Vector3i::Ones()).cwiseMax(0);
+    const Eigen::Vector3i next=(base+Eigen::Vector3i::Ones()).cwiseMin(_size-Eigen::Vector3i::Ones());
+    const Eigen::Vector3d t=g-base.cast<double>();
+
+    auto at=[this] (int x, int y, int z) { return double(_distance[index(x, y, z)]); };
+    double c00=at(base[0], base[1], base[2])*(1-t[0])+at(next[0], base[1], base[2])*t[0];
+    double c10=at(base[0], next[1], base[2])*(1-t[0])+at(next[0], next[1], base[2])*t[0];
+    double c01=at(base[0], base[1], next[2])*(1-t[0])+at(next[0], base[1], next[2])*t[0];
+    double c11=at(base[0], next[1], next[2])*(1-t[0])+at(next[0], next[1], next[2])*t[0];
+    double c0=c00*(1-t[1])+c10*t[1];
+    double c1=c01*(1-t[1])+c11*t[1];
+    return c0*(1-t[2])+c1*t[2];
+  }
+
+  DistanceField::Id DistanceField::owner(const Eigen::Vector3d& p) const {
+    const Eigen::Vector3d g=toGrid(p);
+    return _owner[index(std::lround(g[0]), std::lround(g[1]), std::lround(g[2]))];
+  }
+
+  double DistanceField::weight(Id id) const {
+    return _weights.at(id);
+  }
+
+  size_t DistanceField::ids() const {
+    return _shapes.size();
+  }
+
+  const Eigen::AlignedBox3d& DistanceField::region() const {
+    return _region;
+  }
+}
@@ -5,8 +5,92 @@
 #include <limits>
 #include <algorithm>
 #include <cmath>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include <Log/Log.h>
 
 namespace Gripper{
+  namespace{
+    Log::Module& gripperLog=Log::module("gripper");
+
+    /** Threads helping every search at once: searches running concurrently (e.g. on the threads of APC::TaskGraph)
+     * share them, so that there are never more of them than cores. Never destroyed, as the other singletons.
+     */
+    class HelperPool{
+      public:
+        static HelperPool& getInstance(){
+          static HelperPool* instance=new HelperPool;
+          return *instance;
+        }
+
+        /** Runs f on the calling thread and on up to n idle helpers, and returns once all of them are done. Helpers busy
+         * with other searches are not waited for, so f must do whatever is left to do, and nothing once it is all done.
+         */
+        void run(const std::function<void()>& f, size_t n){
+          Batch batch{&f, std::min(n, _threads.size()), 0};
+          {
+            std::lock_guard<std::mutex> lock(_mutex);
+            if(batch.wanted>0){
+              _batches.push_back(&batch);
+            }
+          }
+          _work.notify_all();
+          f();
+          std::unique_lock<std::mutex> lock(_mutex);
+          /** Helpers which haven't joined yet aren't needed anymore */
+          auto queued=std::find(_batches.begin(), _batches.end(), &batch);
+          if(queued!=_batches.end()){
+            _batches.erase(queued);
+          }
+          _done.wait(lock, [&batch] () { return batch.running==0; });
+        }
+
+      private:
+        struct Batch{
+          const std::function<void()>* f;
+          size_t wanted;
+          size_t running;
+        };
+
+        HelperPool(){
+          /** The calling thread is the last core */
+          for(size_t i=1; i<std::max(1u, std::thread::hardware_concurrency()); ++i){
+            _threads.emplace_back(&HelperPool::helper, this);
+          }
+        }
+
+        void helper(){
+          std::unique_lock<std::mutex> lock(_mutex);
+          while(true){
+            _work.wait(lock, [this] () { return !_batches.empty(); });
+            Batch& batch=*_batches.front();
+            if(--batch.wanted==0){
+              _batches.pop_front();
+            }
+            ++batch.running;
+            lock.unlock();
+            (*batch.f)();
+            lock.lock();
+            if(--batch.running==0){
+              _done.notify_all();
+            }
+          }
+        }
+
+        std::mutex _mutex;
+        std::condition_variable _work;
+        std::condition_variable _done;
+        std::deque<Batch*> _batches;
+        std::vector<std::thread> _threads;
+    };
+  }
+
   double GripperModel::scoreFunction(double vInt){
     constexpr double VMAX=ScoreParams::VMAX;
     constexpr double VEASY=ScoreParams::VEASY;
@@ -20,128 +104,279 @@ namespace Gripper{
     }
     return ALPHA*vInt/VEASY;
   }
-  std::pair<double, Eigen::Affine3d> GripperModel::getBestGrasp(const std::string& name, const ObjectsScene& scene, const ObjectDB& objDB){
-    auto poses=objDB.at(name).myGrasps;
-    std::sort(poses.begin(), poses.end());
+  Eigen::Affine3d GripperModel::fitArmPose(const GraspPose& currentPose, const Eigen::Affine3d& objectPose, std::ostream* log) const {
+    if(log){
+      *log << "Analyzing pose with Z axis:\n" << currentPose.axis[2]<< "\nPick position:\n" << currentPose.pickPose << "\n";
+    }
+    assert(currentPose.constraints[2] && "Object not constrained over Z axis!");
 
-    double currentBestScore=std::numeric_limits<double>::max();
+    /** Relative to the gripper's local frame */
+    auto toolPose=_toolPoses[currentPose.toolNumber];
+    if(log){
+      *log << "Tool pose: \n" << toolPose.matrix() << "\n";
+      *log << "Base pose: \n" << _basePose.matrix() << "\n";
+    }
 
-    Eigen::Affine3d bestGrasp;
+    /** We want to minimize at our best the difference in rotation from a fixed frame (base) in the gripper's reference and the identity */
+    Eigen::Affine3d transformFromToolToBase=toolPose.inverse()*_basePose;
+    Eigen::Affine3d transformFromBaseToTool=transformFromToolToBase.inverse();
 
-    /** Intersect the gripper with all the (other) objects into the scene  -- iterating for each pose and for each object after this imposes that as soon as a valid pose is taken, it is the best one (doing it the other way would mean that the other objects have to be scanned fully) */
-    for(const auto& currentPose : poses){
+    /** Fitted transformation of the tool 
+        This is relative to the object's frame */
+    Eigen::Affine3d fittedToolPose;
+
+    if(std::count(currentPose.constraints.begin(),currentPose.constraints.end(), true)>=2){
+      /** Totally constrained */
+      std::array<Eigen::Vector3d, 3> myConstraints=currentPose.axis;
+
+      if(currentPose.constraints[0]){
+        /** XZ constraint */
+        myConstraints[1]=myConstraints[2].cross(myConstraints[0]);
+      }
+      if(currentPose.constraints[1]){
+        myConstraints[0]=myConstraints[1].cross(myConstraints[2]);
+      }
 
-      std::cout << "Analyzing pose with Z axis:\n" << currentPose.axis[2]<< "\nPick position:\n" << currentPose.pickPose << "\n";
-      assert(currentPose.constraints[2] && "Object not constrained over Z axis!");
+      /** Build rotation matrix in object's coordinates from the 3 axes */
+      fittedToolPose.linear().matrix() << myConstraints[0], myConstraints[1], myConstraints[2];
+      fittedToolPose.translation().matrix() << currentPose.pickPose;
+    }
+    else{
+      /** Desired alignment of the base reference on the gripper in GLOBAL coordinates */
+      Eigen::Affine3d wantedBaseAlignment = Eigen::Affine3d::Identity();
 
-      /** Iterate over all the possible items of the same name */ 
-      for(const auto& object : scene){
+      /** How this transforms into object's space: base frame, in object coordinates, transformed into tool's space */
+      Eigen::Affine3d idealToolPose = transformFromBaseToTool*objectPose.inverse()*wantedBaseAlignment;
+
+      if(log){
+        *log << "We would like our tool to be aligned to \n" << idealToolPose.matrix() << "\n";
+      }
 
-        if(object.first!=name){
-          continue;
+      /** Find the rotation of the ideal tool's Z axis and align it to the constrained one */
+      Eigen::Vector3d idealToolZAxis = idealToolPose.linear()*Eigen::Vector3d{0,0,1};
+      Eigen::Vector3d realToolZAxis = currentPose.axis[2];
+      if(log){
+        *log << "\n\nidealToolZAxis: \n" << idealToolZAxis << "\n\nrealToolZAxis:\n" << realToolZAxis.matrix() << "\n";
+      }
+      Eigen::Vector3d axis;
+      double angle;
+      if(idealToolZAxis.isApprox(realToolZAxis)){
+        if(log){
+          *log << "Wow already aligned\n";
         }
+        angle=0;
+        axis=Eigen::Vector3d::UnitX(); /** Dummy */
+      }
+      else if(idealToolZAxis.isApprox(-realToolZAxis)){
+        angle=M_PI;
+        axis=Eigen::Vector3d::UnitX(); /** Dummy */
+      }
+      else{
+        /** Find angle-axis rotation */
+        axis = idealToolZAxis.cross(realToolZAxis).normalized();
+        angle = ::acos(idealToolZAxis.dot(realToolZAxis));
+      }
 
-        /** Relative to the gripper's local frame */
-        auto toolPose=_toolPoses[currentPose.toolNumber];
-        std::cout << "Tool pose: \n" << toolPose.matrix() << "\n";
-        std::cout << "Base pose: \n" << _basePose.matrix() << "\n";
+      /** Align the two axis */
+      Eigen::Affine3d alignment(Eigen::AngleAxisd(angle, axis));
+      if(log){
+        *log << "Angle: " << angle <<"\nAxis:\n" << axis << "\n";
+        *log << "\nMultiplication c*i:\n" << (alignment.linear()*idealToolZAxis).matrix() << "\n";
+      }
+      fittedToolPose.linear()=alignment.linear()*idealToolPose.linear();
+      fittedToolPose.translation().matrix() << currentPose.pickPose;
+      assert((fittedToolPose.linear()*Eigen::Vector3d::UnitZ()).isApprox(realToolZAxis));
+      if(log){
+        *log << "fitted tool pose: \n" << fittedToolPose.matrix()  << "\n" ;
+      }
+    }
 
-        /** We want to minimize at our best the difference in rotation from a fixed frame (base) in the gripper's reference and the identity */
-        Eigen::Affine3d transformFromToolToBase=toolPose.inverse()*_basePose;
-        Eigen::Affine3d transformFromBaseToTool=transformFromToolToBase.inverse();
+    /** Pose of the base of the gripper in object's coordinate frames */
+    /** We want to solve gripperPose(in object)*ToolPose(in gripper)=fittedToolPose(in object)
+        -> gripperPose(in object) = fittedToolPose*ToolPose^(-1)(in gripper)*/
+    Eigen::Affine3d armPose{fittedToolPose*toolPose.inverse()};
 
-        /** Fitted transformation of the tool 
-            This is relative to the object's frame */
-        Eigen::Affine3d fittedToolPose;
+    if(log){
+      *log << "Arm pose in object coordinates: \n" << armPose.matrix() << "\n";
+    }
+    return armPose;
+  }
 
-        if(std::count(currentPose.constraints.begin(),currentPose.constraints.end(), true)>=2){
-          /** Totally constrained */
-          std::array<Eigen::Vector3d, 3> myConstraints=currentPose.axis;
+  bool GripperModel::scoreAgainstScene(const Eigen::Affine3d& objectPose, const Eigen::Affine3d& armPose, const ObjectsScene& scene, const SceneIndex& index, const ObjectDB& objDB, const std::function<bool()>& cancelled, double& score) const {
+    /** Gripper's shape in object's frame */
+    Shape::Ptr myShapeInPose=armPose*_myShape;
 
-          if(currentPose.constraints[0]){
-            /** XZ constraint */
-            myConstraints[1]=myConstraints[2].cross(myConstraints[0]);
-          }
-          if(currentPose.constraints[1]){
-            myConstraints[0]=myConstraints[1].cross(myConstraints[2]);
-          }
+    /** Broad phase, in global coordinates: objects whose bounds don't touch the gripper's ones can't add anything to the score */
+    const Eigen::Affine3d grasp=objectPose*armPose;
+    std::vector<size_t> nearObjects;
+    index.query(transformBounds(grasp, _myBounds), grasp*_myBoundingCenter, _myBoundingRadius, nearObjects);
 
-          /** Build rotation matrix in object's coordinates from the 3 axes */
-          fittedToolPose.linear().matrix() << myConstraints[0], myConstraints[1], myConstraints[2];
-          fittedToolPose.translation().matrix() << currentPose.pickPose;
-        }
-        else{
-          /** Desired alignment of the base reference on the gripper in GLOBAL coordinates */
-          Eigen::Affine3d wantedBaseAlignment = Eigen::Affine3d::Identity();
-
-          /** How this transforms into object's space: base frame, in object coordinates, transformed into tool's space */
-          Eigen::Affine3d idealToolPose = transformFromBaseToTool*object.second.inverse()*wantedBaseAlignment;
-
-          std::cout << "We would like our tool to be aligned to \n" << idealToolPose.matrix() << "\n";
-
-          /** Find the rotation of the ideal tool's Z axis and align it to the constrained one */
-          Eigen::Vector3d idealToolZAxis = idealToolPose.linear()*Eigen::Vector3d{0,0,1};
-          Eigen::Vector3d realToolZAxis = currentPose.axis[2];
-          std::cout << "\n\nidealToolZAxis: \n" << idealToolZAxis << "\n\nrealToolZAxis:\n" << realToolZAxis.matrix() << "\n";
-          Eigen::Vector3d axis;
-          double angle;
-          if(idealToolZAxis.isApprox(realToolZAxis)){
-            std::cout << "Wow already aligned\n";
-            angle=0;
-            axis=Eigen::Vector3d::UnitX(); /** Dummy */
-          }
-          else if(idealToolZAxis.isApprox(-realToolZAxis)){
-            angle=M_PI;
-            axis=Eigen::Vector3d::UnitX(); /** Dummy */
-          }
-          else{
-            /** Find angle-axis rotation */
-            axis = idealToolZAxis.cross(realToolZAxis).normalized();
-            angle = ::acos(idealToolZAxis.dot(realToolZAxis));
-          }
+    score=0;
+
+    /** Now, intersect the gripper with anyone in the world */
+    for(size_t i : nearObjects){
+      if(cancelled()){
+        return false;
+      }
+      const auto& otherObject=scene[i];
+      /** Transform all the scene into objects' coordinate frames */
+      Eigen::Affine3d otherObjectPose=objectPose.inverse()*otherObject.second;
+      auto otherObjectShape=otherObjectPose*(objDB.at(otherObject.first).myShape);
+
+      /** Compute intersection with an obejct of the scene and apply score function and mobility coefficient */
+      score+=scoreFunction(myShapeInPose->getIntersectionVolume(*otherObjectShape))*objDB.at(otherObject.first).myMobility;
+    }
+    return true;
+  }
 
-          /** Align the two axis */
-          Eigen::Affine3d alignment(Eigen::AngleAxisd(angle, axis));
-          std::cout << "Angle: " << angle <<"\nAxis:\n" << axis << "\n";
-          std::cout << "\nMultiplication c*i:\n" << (alignment.linear()*idealToolZAxis).matrix() << "\n";
-          fittedToolPose.linear()=alignment.linear()*idealToolPose.linear();
-          fittedToolPose.translation().matrix() << currentPose.pickPose;
-          assert((fittedToolPose.linear()*Eigen::Vector3d::UnitZ()).isApprox(realToolZAxis));
-          std::cout << "fitted tool pose: \n" << fittedToolPose.matrix()  << "\n" ;
+  bool GripperModel::scoreAgainstField(const Eigen::Affine3d& grasp, const DistanceField& field, double& score) const {
+    /** Volume of the gripper penetrating each shape of the field */
+    std::vector<double> penetration(field.ids(), 0);
+    const Shape::PointsMatrix points=grasp*_fieldSamples;
+    for(int i=0; i<points.cols(); ++i){
+      const Eigen::Vector3d p=points.col(i).head<3>();
+      if(field.distance(p)<0){
+        DistanceField::Id owner=field.owner(p);
+        if(owner!=DistanceField::NONE){
+          penetration[owner]+=_fieldSampleWeights[i];
         }
+      }
+    }
+
+    score=0;
+    for(size_t i=0; i<penetration.size(); ++i){
+      if(penetration[i]>0){
+        score+=scoreFunction(penetration[i])*field.weight(i);
+      }
+    }
+    return true;
+  }
 
-        /** Pose of the base of the gripper in object's coordinate frames */
-        /** We want to solve gripperPose(in object)*ToolPose(in gripper)=fittedToolPose(in object)
-            -> gripperPose(in object) = fittedToolPose*ToolPose^(-1)(in gripper)*/
-        Eigen::Affine3d armPose{fittedToolPose*toolPose.inverse()};
+  std::pair<double, Eigen::Affine3d> GripperModel::getBestGrasp(const std::string& name, const ObjectsScene& scene, const ObjectDB& objDB){
+    const SceneIndex index(scene, objDB);
+    return searchBestGrasp(name, scene, objDB, [this, &scene, &index, &objDB] (const Eigen::Affine3d& objectPose, const Eigen::Affine3d& armPose, const std::function<bool()>& cancelled, double& score) {
+        return scoreAgainstScene(objectPose, armPose, scene, index, objDB, cancelled, score);
+        });
+  }
 
-        std::cout << "Arm pose in object coordinates: \n" << armPose.matrix() << "\n";
+  std::pair<double, Eigen::Affine3d> GripperModel::getBestGrasp(const std::string& name, const ObjectsScene& scene, const ObjectDB& objDB, const DistanceField& field){
+    return searchBestGrasp(name, scene, objDB, [this, &field] (const Eigen::Affine3d& objectPose, const Eigen::Affine3d& armPose, const std::function<bool()>&, double& score) {
+        return scoreAgainstField(objectPose*armPose, field, score);
+        });
+  }
 
-        /** Gripper's shape in object's frame */
-        Shape::Ptr myShapeInPose=armPose*_myShape;
+  std::pair<double, Eigen::Affine3d> GripperModel::searchBestGrasp(const std::string& name, const ObjectsScene& scene, const ObjectDB& objDB, const Scorer& scorer) const {
+    /** Poses are pulled from the generator in preference order, only as long as the search goes on */
+    const auto source=objDB.at(name).myGraspSource->restart();
 
-        double score=0;
+    /** Iterate over all the possible items of the same name */ 
+    std::vector<const Eigen::Affine3d*> instances;
+    for(const auto& object : scene){
+      if(object.first==name){
+        instances.push_back(&object.second);
+      }
+    }
 
-        /** Now, intersect the gripper with anyone in the world */
-        for(const auto& otherObject : scene){
-          /** Transform all the scene into objects' coordinate frames */
-          Eigen::Affine3d otherObjectPose=object.second.inverse()*otherObject.second;
-          auto otherObjectShape=otherObjectPose*(objDB.at(otherObject.first).myShape);
+    /** Intersect the gripper with all the (other) objects into the scene  -- iterating for each pose and for each object after this imposes that as soon as a valid pose is taken, it is the best one (doing it the other way would mean that the other objects have to be scanned fully) */
+    struct Candidate{
+      const GraspPose* pose;
+      const Eigen::Affine3d* objectPose;
+      double score;
+      Eigen::Affine3d grasp;
+      std::string log;
+      std::exception_ptr error;
+      bool evaluated;
+    };
 
-          /** Compute intersection with an obejct of the scene and apply score function and mobility coefficient */
-          score+=scoreFunction(myShapeInPose->getIntersectionVolume(*otherObjectShape))*objDB.at(otherObject.first).myMobility;
+    double currentBestScore=std::numeric_limits<double>::max();
+    Eigen::Affine3d bestGrasp;
+    std::vector<GraspPose> poses;
+    std::vector<Candidate> candidates;
+    std::vector<const GraspPose*> promising;
+    while(!instances.empty()){
+      /** The batch size doesn't depend on the number of cores, so neither do the refinements nor the result */
+      poses.clear();
+      GraspPose pose;
+      while(poses.size()*instances.size()<BATCH_CANDIDATES && source->next(pose)){
+        poses.push_back(pose);
+      }
+      if(poses.empty()){
+        break;
+      }
+      candidates.clear();
+      for(const auto& currentPose : poses){
+        for(const auto* objectPose : instances){
+          candidates.push_back(Candidate{&currentPose, objectPose, 0, Eigen::Affine3d::Identity(), "", nullptr, false});
         }
+      }
 
-        if(score < ScoreParams::THRESHOLD_NO_INTERSECTION){
-          std::cout << "\n\n\n\nArmPose:\n" << armPose.matrix() << "object pose: \n" << object.second.matrix() << "\n";
-          return std::make_pair(score, object.second*armPose);
+      /** Candidates are evaluated speculatively on the cores (shared with the other searches, see HelperPool), but they are
+       * handed out in order: as soon as one of them meets the threshold (or fails), no candidate after it can be the result,
+       * so they are skipped (or interrupted).
+       * Every candidate before the first good one is always evaluated, hence the result is the same as the sequential scan.
+       */
+      const size_t n=candidates.size();
+      /** The matrices of every candidate are only formatted if they are going to be logged */
+      const bool verbose=Log::compiled(Log::TRACE) && gripperLog.enabled(Log::TRACE);
+      std::atomic<size_t> next{0};
+      std::atomic<size_t> firstStop{n};
+      auto stopAt=[&firstStop] (size_t i) {
+        size_t current=firstStop.load();
+        while(i<current && !firstStop.compare_exchange_weak(current, i));
+      };
+      auto worker=[&] () {
+        for(size_t i=next++; i<n && i<firstStop.load(std::memory_order_relaxed); i=next++){
+          Candidate& c=candidates[i];
+          std::ostringstream log;
+          std::ostream* details=verbose ? &log : nullptr;
+          try{
+            const Eigen::Affine3d armPose=fitArmPose(*c.pose, *c.objectPose, details);
+            /** In global coordinates */
+            c.grasp=(*c.objectPose)*armPose;
+            c.evaluated=scorer(*c.objectPose, armPose, [&firstStop, i] () { return firstStop.load(std::memory_order_relaxed)<i; }, c.score);
+            if(c.evaluated && c.score < ScoreParams::THRESHOLD_NO_INTERSECTION){
+              if(details){
+                log << "\n\n\n\nArmPose:\n" << armPose.matrix() << "object pose: \n" << c.objectPose->matrix() << "\n";
+              }
+              stopAt(i);
+            }
+          }
+          catch(...){
+            c.error=std::current_exception();
+            c.evaluated=true;
+            stopAt(i);
+          }
+          c.log=log.str();
         }
+      };
+
+      HelperPool::getInstance().run(worker, std::max<size_t>(n, 1)-1);
 
-        if(score < currentBestScore){
-          currentBestScore=score;
-          /** In global coordinates */
-          bestGrasp=object.second*armPose;
+      /** Ordered commit */
+      promising.clear();
+      for(const auto& c : candidates){
+        if(!c.evaluated){
+          break;
         }
+        if(!c.log.empty()){
+          LOG(gripperLog, TRACE) << c.log;
+        }
+        if(c.error){
+          std::rethrow_exception(c.error);
+        }
+        if(c.score < ScoreParams::THRESHOLD_NO_INTERSECTION){
+          return std::make_pair(c.score, c.grasp);
+        }
+        if(c.score < currentBestScore){
+          currentBestScore=c.score;
+          bestGrasp=c.grasp;
+          promising.push_back(c.pose);
+        }
+      }
+
+      /** Poses which improved the best score so far are worth a closer look */
+      for(const auto* p : promising){
+        source->refine(*p);
       }
     }
     return std::make_pair(currentBestScore,bestGrasp);
@@ -150,15 +385,29 @@ namespace Gripper{
     return _myShape;
   }
 
-  GripperModel::GripperModel(){
+  GripperModel::GripperModel()
+    :
+      _myBoundingCenter(Eigen::Vector3d::Zero()),
+      _myBoundingRadius(0)
+  {
   }
 
   GripperModel::GripperModel(const std::vector<Eigen::Affine3d> poses, Eigen::Affine3d base, const Shape::Ptr& shape)
     :
     _toolPoses(poses),
     _basePose(base),
-    _myShape(shape)
+    _myShape(shape),
+    _myBoundingCenter(Eigen::Vector3d::Zero()),
+    _myBoundingRadius(0)
   {
+    if(_myShape){
+      _myBounds=_myShape->getBounds();
+      if(!_myBounds.isEmpty()){
+        _myBoundingCenter=_myBounds.center();
+        _myBoundingRadius=_myBounds.diagonal().norm()/2;
+      }
+      _fieldSamples=_myShape->getWeightedCubettiVolume(FIELD_SAMPLES_LEVEL, _fieldSampleWeights);
+    }
   }
 }
 
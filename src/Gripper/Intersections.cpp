@@ -0,0 +1,386 @@
+#include <cmath>
+#include <algorithm>
+#include <Gripper/Intersections.h>
+#include <Gripper/Cuboid.h>
+#include <Gripper/Sphere.h>
+#include <Gripper/Cylinder.h>
+
+namespace Gripper{
+
+  namespace{
+    /** Oriented box, described by its center, axes (columns) and half sizes */
+    struct Obb{
+      Eigen::Vector3d center;
+      Eigen::Matrix3d axes;
+      Eigen::Vector3d half;
+    };
+
+    Obb boundingObb(const Shape& s){
+      Eigen::AlignedBox3d b=s.getLocalBounds();
+      Eigen::Affine3d pose=s.getPose();
+      return Obb{pose*b.center(), pose.linear(), b.sizes()/2.0};
+    }
+
+    /** Some shapes hide getVolume() in their protected interface */
+    double volumeOf(const Shape& s){
+      return s.getVolume();
+    }
+
+    /** Pose of b in a's frame */
+    Eigen::Affine3d relativePose(const Shape& a, const Shape& b){
+      return a.getPose().inverse(Eigen::Isometry)*b.getPose();
+    }
+
+    /** Separating axis test between two oriented boxes (15 candidate axes) */
+    bool obbOverlap(const Obb& a, const Obb& b){
+      constexpr double EPS=1e-12;
+      Eigen::Matrix3d R=a.axes.transpose()*b.axes;
+      Eigen::Vector3d t=a.axes.transpose()*(b.center-a.center);
+      Eigen::Matrix3d absR=R.cwiseAbs().array()+EPS;
+
+      for(int i=0; i<3; ++i){
+        if(std::abs(t[i]) > a.half[i]+b.half.dot(absR.row(i))){
+          return false;
+        }
+      }
+      for(int j=0; j<3; ++j){
+        if(std::abs(t.dot(R.col(j))) > a.half.dot(absR.col(j))+b.half[j]){
+          return false;
+        }
+      }
+      for(int i=0; i<3; ++i){
+        int i1=(i+1)%3, i2=(i+2)%3;
+        for(int j=0; j<3; ++j){
+          int j1=(j+1)%3, j2=(j+2)%3;
+          double ra=a.half[i1]*absR(i2,j)+a.half[i2]*absR(i1,j);
+          double rb=b.half[j1]*absR(i,j2)+b.half[j2]*absR(i,j1);
+          if(std::abs(t[i2]*R(i1,j)-t[i1]*R(i2,j)) > ra+rb){
+            return false;
+          }
+        }
+      }
+      return true;
+    }
+
+    /** Whether all the corners of the box b, transformed by pose, are into container */
+    bool containsAllCorners(const Eigen::AlignedBox3d& container, const Eigen::Affine3d& pose, const Eigen::AlignedBox3d& b){
+      for(int i=0; i<8; ++i){
+        if(!container.contains(pose*b.corner(static_cast<Eigen::AlignedBox3d::CornerType>(i)))){
+          return false;
+        }
+      }
+      return true;
+    }
+
+    /** Integrates f over [z0, z1], where f(z) is the area of a slice of a sphere of radius r centered in cz.
+     * Substituting z=cz+r*sin(t) removes the square-root singularities at the poles, so Simpson converges quickly.
+     */
+    template<typename SliceArea>
+      double integrateSphereSlices(double cz, double r, double z0, double z1, const SliceArea& f){
+        constexpr size_t N=Intersections::INTEGRATION_SLICES;
+        double t0=std::asin(std::max(-1.0, std::min(1.0, (z0-cz)/r)));
+        double t1=std::asin(std::max(-1.0, std::min(1.0, (z1-cz)/r)));
+        if(t1<=t0){
+          return 0;
+        }
+        double h=(t1-t0)/N;
+        double result=0;
+        for(size_t i=0; i<=N; ++i){
+          double t=t0+i*h;
+          double weight=(i==0 || i==N) ? 1 : (i%2 ? 4 : 2);
+          double c=std::cos(t);
+          result+=weight*f(cz+r*std::sin(t), r*c)*r*c;
+        }
+        return result*h/3.0;
+      }
+
+    /** Area of the portion of a circle (centered in the origin) above the line y=h (h>=0) and between x0 and x1 */
+    double circleAreaAbove(double x0, double x1, double h, double r){
+      if(h>=r){
+        return 0;
+      }
+      double s=std::sqrt(r*r-h*h);
+      auto g=[h, r] (double x) {
+        return 0.5*(x*std::sqrt(std::max(0.0, r*r-x*x))+r*r*std::asin(std::max(-1.0, std::min(1.0, x/r))))-h*x;
+      };
+      x0=std::max(-s, std::min(s, x0));
+      x1=std::max(-s, std::min(s, x1));
+      return g(x1)-g(x0);
+    }
+
+    /** Area of the intersection between the rectangle [x0,x1]x[y0,y1] and a circle of radius r centered in the origin */
+    double circleRectangleArea(double x0, double x1, double y0, double y1, double r){
+      if(x0>=x1 || y0>=y1 || r<=0){
+        return 0;
+      }
+      if(y0<0){
+        if(y1<=0){
+          return circleAreaAbove(x0, x1, -y1, r)-circleAreaAbove(x0, x1, -y0, r);
+        }
+        return circleRectangleArea(x0, x1, 0, -y0, r)+circleRectangleArea(x0, x1, 0, y1, r);
+      }
+      return circleAreaAbove(x0, x1, y0, r)-circleAreaAbove(x0, x1, y1, r);
+    }
+
+    /** Area of the intersection of two circles of radii r1 and r2, with centers at distance d */
+    double circleCircleArea(double r1, double r2, double d){
+      if(d>=r1+r2){
+        return 0;
+      }
+      double rMin=std::min(r1, r2);
+      if(d<=std::abs(r1-r2)){
+        return M_PI*rMin*rMin;
+      }
+      double a1=std::acos(std::max(-1.0, std::min(1.0, (d*d+r1*r1-r2*r2)/(2*d*r1))));
+      double a2=std::acos(std::max(-1.0, std::min(1.0, (d*d+r2*r2-r1*r1)/(2*d*r2))));
+      double k=(-d+r1+r2)*(d+r1-r2)*(d-r1+r2)*(d+r1+r2);
+      return r1*r1*a1+r2*r2*a2-0.5*std::sqrt(std::max(0.0, k));
+    }
+
+    /** Squared distance between the segments p1-q1 and p2-q2 (Ericson, Real-Time Collision Detection, 5.1.9) */
+    double segmentsSquaredDistance(const Eigen::Vector3d& p1, const Eigen::Vector3d& q1, const Eigen::Vector3d& p2, const Eigen::Vector3d& q2){
+      constexpr double EPS=1e-12;
+      Eigen::Vector3d d1=q1-p1, d2=q2-p2, r=p1-p2;
+      double a=d1.squaredNorm(), e=d2.squaredNorm(), f=d2.dot(r);
+      double s, t;
+      if(a<=EPS && e<=EPS){
+        return r.squaredNorm();
+      }
+      if(a<=EPS){
+        s=0;
+        t=std::max(0.0, std::min(1.0, f/e));
+      }
+      else{
+        double c=d1.dot(r);
+        if(e<=EPS){
+          t=0;
+          s=std::max(0.0, std::min(1.0, -c/a));
+        }
+        else{
+          double b=d1.dot(d2);
+          double denom=a*e-b*b;
+          s=(denom>EPS) ? std::max(0.0, std::min(1.0, (b*f-c*e)/denom)) : 0.0;
+          t=(b*s+f)/e;
+          if(t<0){
+            t=0;
+            s=std::max(0.0, std::min(1.0, -c/a));
+          }
+          else if(t>1){
+            t=1;
+            s=std::max(0.0, std::min(1.0, (b-c)/a));
+          }
+        }
+      }
+      return ((p1+d1*s)-(p2+d2*t)).squaredNorm();
+    }
+
+    /** Cuboid - Cuboid */
+
+    bool overlap(const Cuboid& a, const Cuboid& b){
+      return obbOverlap(boundingObb(a), boundingObb(b));
+    }
+
+    double volume(const Cuboid& a, const Cuboid& b){
+      Obb oa=boundingObb(a), ob=boundingObb(b);
+      if(!obbOverlap(oa, ob)){
+        return 0;
+      }
+      Eigen::AlignedBox3d boundsA=a.getLocalBounds(), boundsB=b.getLocalBounds();
+      Eigen::Affine3d bInA=relativePose(a, b);
+
+      /** If the boxes are aligned (up to a permutation of the axes) the overlap of the bounds is exact */
+      Eigen::Matrix3d absR=bInA.linear().cwiseAbs();
+      constexpr double ALIGNED_TOL=1e-9;
+      if(((absR.array()<ALIGNED_TOL) || (absR.array()>1-ALIGNED_TOL)).all()){
+        Eigen::AlignedBox3d common=boundsA.intersection(transformBounds(bInA, boundsB));
+        return common.isEmpty() ? 0 : common.volume();
+      }
+
+      if(containsAllCorners(boundsA, bInA, boundsB)){
+        return volumeOf(b);
+      }
+      if(containsAllCorners(boundsB, bInA.inverse(Eigen::Isometry), boundsA)){
+        return volumeOf(a);
+      }
+      return Intersections::sampledVolume(a, b);
+    }
+
+    /** Cuboid - Sphere */
+
+    bool overlap(const Cuboid& a, const Sphere& b){
+      Eigen::AlignedBox3d bounds=a.getLocalBounds();
+      Eigen::Vector3d c=a.getPose().inverse(Eigen::Isometry)*b.getPose().translation();
+      double r=b.getDimensions()[0];
+      return bounds.squaredExteriorDistance(c) < r*r;
+    }
+
+    double volume(const Cuboid& a, const Sphere& b){
+      if(!overlap(a, b)){
+        return 0;
+      }
+      Eigen::AlignedBox3d bounds=a.getLocalBounds();
+      Eigen::Vector3d c=a.getPose().inverse(Eigen::Isometry)*b.getPose().translation();
+      double r=b.getDimensions()[0];
+
+      Eigen::AlignedBox3d sphereBounds(c-Eigen::Vector3d::Constant(r), c+Eigen::Vector3d::Constant(r));
+      if(bounds.contains(sphereBounds)){
+        return volumeOf(b);
+      }
+      bool allInside=true;
+      for(int i=0; i<8 && allInside; ++i){
+        allInside=(bounds.corner(static_cast<Eigen::AlignedBox3d::CornerType>(i))-c).squaredNorm() <= r*r;
+      }
+      if(allInside){
+        return volumeOf(a);
+      }
+
+      /** Slice along the box's Z axis: each slice is a circle against the box's XY rectangle */
+      Eigen::Vector3d lo=bounds.min()-c, hi=bounds.max()-c;
+      return integrateSphereSlices(c[2], r, bounds.min()[2], bounds.max()[2], [&lo, &hi] (double, double sliceR) {
+          return circleRectangleArea(lo[0], hi[0], lo[1], hi[1], sliceR);
+      });
+    }
+
+    /** Sphere - Sphere */
+
+    bool overlap(const Sphere& a, const Sphere& b){
+      double r=a.getDimensions()[0]+b.getDimensions()[0];
+      return (a.getPose().translation()-b.getPose().translation()).squaredNorm() < r*r;
+    }
+
+    double volume(const Sphere& a, const Sphere& b){
+      using std::max;
+      using std::min;
+      double r1=a.getDimensions()[0];
+      double r2=b.getDimensions()[0];
+      double R=max(r1, r2);
+      double r=min(r1, r2);
+      double d=(a.getPose().translation()-b.getPose().translation()).norm();
+
+      if(d>R+r){
+        return 0;
+      }
+      if(d<=R-r){
+        /** Small sphere is contained fully into other one */
+        return 4.0/3.0*M_PI*r*r*r;
+      }
+      return M_PI*pow(R+r-d, 2)*(d*d+2*d*r-3*r*r+2*d*R+6*r*R-3*R*R)/(12*d);
+    }
+
+    /** Cylinder - Sphere */
+
+    bool overlap(const Cylinder& a, const Sphere& b){
+      Eigen::Vector3d c=a.getPose().inverse(Eigen::Isometry)*b.getPose().translation();
+      double R=a.getDimensions()[0], H=a.getDimensions()[1];
+      double r=b.getDimensions()[0];
+      double dz=c[2]-std::max(0.0, std::min(H, c[2]));
+      double dr=std::max(0.0, std::hypot(c[0], c[1])-R);
+      return dz*dz+dr*dr < r*r;
+    }
+
+    double volume(const Cylinder& a, const Sphere& b){
+      if(!overlap(a, b)){
+        return 0;
+      }
+      Eigen::Vector3d c=a.getPose().inverse(Eigen::Isometry)*b.getPose().translation();
+      double R=a.getDimensions()[0], H=a.getDimensions()[1];
+      double r=b.getDimensions()[0];
+      double rho=std::hypot(c[0], c[1]);
+
+      if(rho+r<=R && c[2]-r>=0 && c[2]+r<=H){
+        return volumeOf(b);
+      }
+      double farZ=std::max(std::abs(c[2]), std::abs(H-c[2]));
+      if((rho+R)*(rho+R)+farZ*farZ<=r*r){
+        return volumeOf(a);
+      }
+
+      /** Slice along the cylinder's axis: each slice is a lens between two circles */
+      return integrateSphereSlices(c[2], r, 0, H, [R, rho] (double, double sliceR) {
+          return circleCircleArea(R, sliceR, rho);
+      });
+    }
+
+    /** Cylinder - Cuboid and Cylinder - Cylinder: conservative tests on the bounds, then bounded sampling */
+
+    bool overlap(const Cylinder& a, const Cuboid& b){
+      return obbOverlap(boundingObb(a), boundingObb(b)) && Intersections::sampledVolume(a, b)>0;
+    }
+
+    double volume(const Cylinder& a, const Cuboid& b){
+      if(!obbOverlap(boundingObb(a), boundingObb(b))){
+        return 0;
+      }
+      return Intersections::sampledVolume(a, b);
+    }
+
+    bool mayOverlap(const Cylinder& a, const Cylinder& b){
+      /** Each cylinder is contained in the capsule around its axis */
+      Eigen::Vector3d pa=a.getPose().translation(), qa=a.getPose()*Eigen::Vector3d{0, 0, a.getDimensions()[1]};
+      Eigen::Vector3d pb=b.getPose().translation(), qb=b.getPose()*Eigen::Vector3d{0, 0, b.getDimensions()[1]};
+      double r=a.getDimensions()[0]+b.getDimensions()[0];
+      return segmentsSquaredDistance(pa, qa, pb, qb) < r*r && obbOverlap(boundingObb(a), boundingObb(b));
+    }
+
+    bool overlap(const Cylinder& a, const Cylinder& b){
+      return mayOverlap(a, b) && Intersections::sampledVolume(a, b)>0;
+    }
+
+    double volume(const Cylinder& a, const Cylinder& b){
+      if(!mayOverlap(a, b)){
+        return 0;
+      }
+      return Intersections::sampledVolume(a, b);
+    }
+
+    /** Adapters from the generic signature to the typed routines above; SWAP handles the symmetric entries */
+    template<typename A, typename B, bool SWAP>
+      bool overlapKernel(const Shape& a, const Shape& b){
+        return SWAP ? overlap(static_cast<const A&>(b), static_cast<const B&>(a)) : overlap(static_cast<const A&>(a), static_cast<const B&>(b));
+      }
+
+    template<typename A, typename B, bool SWAP>
+      double volumeKernel(const Shape& a, const Shape& b){
+        return SWAP ? volume(static_cast<const A&>(b), static_cast<const B&>(a)) : volume(static_cast<const A&>(a), static_cast<const B&>(b));
+      }
+
+    template<typename A, typename B, bool SWAP=false>
+      constexpr Intersections::Kernel kernel(){
+        return Intersections::Kernel{&overlapKernel<A, B, SWAP>, &volumeKernel<A, B, SWAP>};
+      }
+
+    constexpr Intersections::Kernel NONE{nullptr, nullptr};
+  }
+
+  /** Rows and columns follow Shape::Type: GENERIC, CUBOID, SPHERE, CYLINDER, COMPOSED */
+  const Intersections::Kernel Intersections::TABLE[Shape::N_TYPES][Shape::N_TYPES]={
+    { NONE, NONE,                            NONE,                            NONE,                              NONE },
+    { NONE, kernel<Cuboid, Cuboid>(),        kernel<Cuboid, Sphere>(),        kernel<Cylinder, Cuboid, true>(),  NONE },
+    { NONE, kernel<Cuboid, Sphere, true>(),  kernel<Sphere, Sphere>(),        kernel<Cylinder, Sphere, true>(),  NONE },
+    { NONE, kernel<Cylinder, Cuboid>(),      kernel<Cylinder, Sphere>(),      kernel<Cylinder, Cylinder>(),      NONE },
+    { NONE, NONE,                            NONE,                            NONE,                              NONE }
+  };
+
+  const Intersections::Kernel* Intersections::find(Shape::Type a, Shape::Type b){
+    const Kernel* k=&TABLE[a][b];
+    return k->volume ? k : nullptr;
+  }
+
+  double Intersections::sampledVolume(const Shape& a, const Shape& b, size_t level){
+    /** Sample in the frame where the bounded region is the smallest */
+    Eigen::AlignedBox3d regionA=a.getLocalBounds().intersection(transformBounds(relativePose(a, b), b.getLocalBounds()));
+    Eigen::AlignedBox3d regionB=b.getLocalBounds().intersection(transformBounds(relativePose(b, a), a.getLocalBounds()));
+    if(regionA.isEmpty() || regionB.isEmpty()){
+      return 0;
+    }
+    bool useA=regionA.volume()<=regionB.volume();
+    const Eigen::AlignedBox3d& region=(useA ? regionA : regionB);
+    const Eigen::Affine3d pose=(useA ? a : b).getPose();
+
+    /** The unit cube grid, stretched over the region */
+    auto grid=Samples::get(Samples::CUBE_VOLUME, level);
+    Eigen::Affine3d gridToWorld=pose*Eigen::Translation3d(region.min())*Eigen::Scaling(region.sizes());
+    size_t count=Samples::countContained(*grid, gridToWorld, a.getContainment(), b.getContainment());
+    return count*region.volume()/grid->cols();
+  }
+}
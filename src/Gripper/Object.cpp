@@ -4,21 +4,53 @@
 
 namespace Gripper{
   Object::Object()
+    :
+      myGraspSource(PoseFactory::posesFromList(GraspSet{})),
+      myMobility(0),
+      myBoundingCenter(Eigen::Vector3d::Zero()),
+      myBoundingRadius(0)
   {
   }
 
   Object::Object(const std::shared_ptr<const Shape>& shape, const GraspSet& grips, double mobility)
     :
       myShape(shape),
-      myGrasps(grips)
+      myGraspSource(PoseFactory::posesFromList(grips)),
+      myMobility(mobility),
+      myBoundingCenter(Eigen::Vector3d::Zero()),
+      myBoundingRadius(0)
+  {
+    initBounds();
+  }
+
+  Object::Object(const std::shared_ptr<const Shape>& shape, const PoseFactory::Generator::Ptr& grasps, double mobility)
+    :
+      myShape(shape),
+      myGraspSource(grasps),
+      myMobility(mobility),
+      myBoundingCenter(Eigen::Vector3d::Zero()),
+      myBoundingRadius(0)
   {
+    initBounds();
+  }
+
+  void Object::initBounds(){
+    if(myShape){
+      myBounds=myShape->getBounds();
+      if(!myBounds.isEmpty()){
+        myBoundingCenter=myBounds.center();
+        myBoundingRadius=myBounds.diagonal().norm()/2;
+      }
+    }
   }
 
 
   Object Object::readFrom(const cv::FileNode& fs){
 
     Shape::Ptr s;
-    GraspSet g;
+    /** Custom grasps are collected into a single source, the generated ones are only described here and built on demand */
+    GraspSet custom;
+    std::vector<PoseFactory::Generator::Ptr> g;
     double mob;
 
     bool autoPoses;
@@ -45,7 +77,7 @@ namespace Gripper{
       if(type=="custom"){
         GraspPose customGrasp;
         data >> customGrasp;
-        g.push_back(customGrasp);
+        custom.push_back(customGrasp);
       }
       else if(type=="line"){
         int toolN;
@@ -56,8 +88,7 @@ namespace Gripper{
         data["p2"] >> p2;
         data["planeVector"] >> planeVector;
         data["level"] >> level;
-        auto newPoses=PoseFactory::generatePosesOnLine(level,p1,p2,planeVector,toolN);
-        g.insert(g.end(), newPoses.begin(), newPoses.end());
+        g.push_back(PoseFactory::posesOnLine(level,p1,p2,planeVector,toolN));
       }
       else if(type=="Plane"){
         int toolN;
@@ -68,8 +99,7 @@ namespace Gripper{
         data["width"] >> width;
         data["height"] >> height;
         data["level"] >> level;
-        auto newPoses=PoseFactory::generatePosesOnPlane(level,origin, width, height, toolN);
-        g.insert(g.end(), newPoses.begin(), newPoses.end());
+        g.push_back(PoseFactory::posesOnPlane(level,origin, width, height, toolN));
       }
       else if(type=="Cuboid"){
         int toolN;
@@ -82,11 +112,11 @@ namespace Gripper{
         data["height"] >> height;
         data["depth"] >> depth;
         data["level"] >> level;
-        auto newPoses=PoseFactory::generatePosesOnCuboid(level, Eigen::Affine3d{pose}, width, height, depth, toolN);
-        g.insert(g.end(), newPoses.begin(), newPoses.end());
+        g.push_back(PoseFactory::posesOnCuboid(level, Eigen::Affine3d{pose}, width, height, depth, toolN));
       }
     }
-    return Object{s,g,mob};
+    g.push_back(PoseFactory::posesFromList(custom));
+    return Object{s,PoseFactory::merge(g),mob};
 
   }
 }
@@ -1,28 +1,286 @@
 #include <Gripper/PoseFactory.h>
-#include <iterator>
+#include <Eigen/SVD>
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <limits>
+#include <map>
+#include <queue>
 
 namespace Gripper{
   namespace PoseFactory{
-    std::vector<GraspPose> generatePosesOnLine(size_t level, const Eigen::Vector3d& p1, const Eigen::Vector3d& p2, const Eigen::Vector3d& planeVector, int toolNumber){
-      std::vector<GraspPose> result;
+    constexpr int Generator::MAX_REFINEMENT;
+
+    namespace{
+      /** Poses on the lattice origin+stepW*i+stepH*j (0<=i<nW, 0<=j<nH), scored by their distance from center.
+       * When the two steps are orthogonal the score is separable, so it never decreases moving away from the best point
+       * along i or j: a best-first visit from it, which pushes the neighbours of every popped point, yields the whole
+       * lattice in order while building only its frontier. Otherwise the lattice is queued at once.
+       */
+      class GridGenerator : public Generator{
+        public:
+          GridGenerator(size_t nW, size_t nH, const Eigen::Vector3d& origin, const Eigen::Vector3d& stepW, const Eigen::Vector3d& stepH, const Eigen::Vector3d& center, const GraspPose& prototype)
+            :
+              _nW(nW),
+              _nH(nH),
+              _origin(origin),
+              _stepW(stepW),
+              _stepH(stepH),
+              _center(center),
+              _prototype(prototype),
+              _queued(nW*nH, false),
+              _separable(nW<=1 || nH<=1 || std::abs(stepW.dot(stepH))<=1e-9*stepW.norm()*stepH.norm())
+          {
+            if(_nW==0 || _nH==0){
+              return;
+            }
+            if(_separable){
+              pushBase(closest(_stepW, _nW), closest(_stepH, _nH));
+            }
+            else{
+              for(size_t i=0; i<_nW; ++i){
+                for(size_t j=0; j<_nH; ++j){
+                  pushBase(i, j);
+                }
+              }
+            }
+          }
+
+          double peekScore() const override {
+            return _queue.empty() ? std::numeric_limits<double>::infinity() : _queue.top().score;
+          }
+
+          bool next(GraspPose& pose) override {
+            if(_queue.empty()){
+              return false;
+            }
+            Entry e=_queue.top();
+            _queue.pop();
+            if(e.depth==0 && _separable){
+              long i=e.u/FINE, j=e.v/FINE;
+              pushBase(i-1, j);
+              pushBase(i+1, j);
+              pushBase(i, j-1);
+              pushBase(i, j+1);
+            }
+            pose=_prototype;
+            pose.pickPose=point(e.u, e.v);
+            pose.preferenceScore=e.score;
+            return true;
+          }
+
+          void refine(const GraspPose& pose) override {
+            if(pose.toolNumber!=_prototype.toolNumber){
+              return;
+            }
+            long u, v;
+            if(!locate(pose.pickPose, u, v)){
+              return;
+            }
+            int depth;
+            if(u%FINE==0 && v%FINE==0){
+              depth=0;
+            }
+            else{
+              auto it=_refined.find(std::make_pair(u, v));
+              if(it==_refined.end()){
+                return;
+              }
+              depth=it->second;
+            }
+            if(depth>=MAX_REFINEMENT){
+              return;
+            }
+
+            const long h=FINE>>(depth+1);
+            for(long du=-h; du<=h; du+=h){
+              for(long dv=-h; dv<=h; dv+=h){
+                long nu=u+du, nv=v+dv;
+                if((du==0 && dv==0) || !inside(nu, nv)){
+                  continue;
+                }
+                /** Points of the lattice are already there */
+                if(nu%FINE==0 && nv%FINE==0){
+                  continue;
+                }
+                if(_refined.insert(std::make_pair(std::make_pair(nu, nv), depth+1)).second){
+                  _queue.push(Entry{score(nu, nv), nu, nv, depth+1});
+                }
+              }
+            }
+          }
+
+          Ptr restart() const override {
+            return std::make_shared<GridGenerator>(_nW, _nH, _origin, _stepW, _stepH, _center, _prototype);
+          }
+
+        private:
+          /** Coordinates are kept on a lattice 2^MAX_REFINEMENT times finer, so that refined samples have integer coordinates too */
+          static constexpr long FINE=1L<<MAX_REFINEMENT;
+
+          struct Entry{
+            double score;
+            long u, v;
+            int depth;
+
+            bool operator>(const Entry& other) const {
+              return score>other.score;
+            }
+          };
+
+          size_t _nW, _nH;
+          Eigen::Vector3d _origin, _stepW, _stepH, _center;
+          GraspPose _prototype;
+
+          std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> _queue;
+          /** Points of the lattice which have been queued */
+          std::vector<bool> _queued;
+          /** Refined samples which have been queued, with their depth */
+          std::map<std::pair<long, long>, int> _refined;
+          bool _separable;
+
+          Eigen::Vector3d point(long u, long v) const {
+            return _origin+(_stepW*u+_stepH*v)/FINE;
+          }
+
+          double score(long u, long v) const {
+            return (point(u, v)-_center).norm();
+          }
+
+          bool inside(long u, long v) const {
+            return u>=0 && v>=0 && u<=long(_nW-1)*FINE && v<=long(_nH-1)*FINE;
+          }
+
+          /** Index of the lattice point along step which is closest to the projection of center */
+          size_t closest(const Eigen::Vector3d& step, size_t n) const {
+            double len2=step.squaredNorm();
+            if(len2==0){
+              return 0;
+            }
+            double t=std::round((_center-_origin).dot(step)/len2);
+            return size_t(std::min(std::max(t, 0.0), double(n-1)));
+          }
+
+          void pushBase(long i, long j){
+            if(i<0 || j<0 || i>=long(_nW) || j>=long(_nH) || _queued[i*_nH+j]){
+              return;
+            }
+            _queued[i*_nH+j]=true;
+            _queue.push(Entry{score(i*FINE, j*FINE), i*FINE, j*FINE, 0});
+          }
+
+          /** Fine coordinates of p, if it is one of the samples of this lattice */
+          bool locate(const Eigen::Vector3d& p, long& u, long& v) const {
+            Eigen::Matrix<double, 3, 2> A;
+            A << _stepW, _stepH;
+            Eigen::Vector2d c=A.jacobiSvd(Eigen::ComputeFullU | Eigen::ComputeFullV).solve(p-_origin);
+            u=std::lround(c[0]*FINE);
+            v=std::lround(c[1]*FINE);
+            if(_nH<=1){
+              v=0;
+            }
+            if(_nW<=1){
+              u=0;
+            }
+            const double tolerance=1e-6*(_stepW.norm()+_stepH.norm());
+            return inside(u, v) && (point(u, v)-p).norm()<=tolerance;
+          }
+      };
+
+      constexpr long GridGenerator::FINE;
+
+      class ListGenerator : public Generator{
+        public:
+          ListGenerator(const std::shared_ptr<const std::vector<GraspPose>>& sorted)
+            :
+              _poses(sorted),
+              _next(0)
+          {
+          }
+
+          double peekScore() const override {
+            return _next<_poses->size() ? (*_poses)[_next].preferenceScore : std::numeric_limits<double>::infinity();
+          }
+
+          bool next(GraspPose& pose) override {
+            if(_next>=_poses->size()){
+              return false;
+            }
+            pose=(*_poses)[_next++];
+            return true;
+          }
+
+          Ptr restart() const override {
+            return std::make_shared<ListGenerator>(_poses);
+          }
+
+        private:
+          /** Shared by all the restarted copies */
+          std::shared_ptr<const std::vector<GraspPose>> _poses;
+          size_t _next;
+      };
+
+      class MergedGenerator : public Generator{
+        public:
+          MergedGenerator(const std::vector<Ptr>& sources)
+            :
+              _sources(sources)
+          {
+          }
 
+          double peekScore() const override {
+            double best=std::numeric_limits<double>::infinity();
+            for(const auto& s : _sources){
+              best=std::min(best, s->peekScore());
+            }
+            return best;
+          }
+
+          /** Sources are few (one per entry of the object's grasps), a linear scan is enough */
+          bool next(GraspPose& pose) override {
+            Generator* best=nullptr;
+            double bestScore=std::numeric_limits<double>::infinity();
+            for(const auto& s : _sources){
+              double score=s->peekScore();
+              if(score<bestScore){
+                bestScore=score;
+                best=s.get();
+              }
+            }
+            return best!=nullptr && best->next(pose);
+          }
+
+          void refine(const GraspPose& pose) override {
+            for(const auto& s : _sources){
+              s->refine(pose);
+            }
+          }
+
+          Ptr restart() const override {
+            std::vector<Ptr> sources;
+            for(const auto& s : _sources){
+              sources.push_back(s->restart());
+            }
+            return std::make_shared<MergedGenerator>(sources);
+          }
+
+        private:
+          std::vector<Ptr> _sources;
+      };
+    }
+
+    Generator::Ptr posesOnLine(size_t level, const Eigen::Vector3d& p1, const Eigen::Vector3d& p2, const Eigen::Vector3d& planeVector, int toolNumber){
       Eigen::Vector3d center=(p1+p2)/2;
       Eigen::Vector3d line=p2-p1;
       Eigen::Vector3d step=line/level;
 
       Eigen::Vector3d zAxis=line.cross(planeVector);
 
-      for(int i=0; i<level; ++i){
-        Eigen::Vector3d pt=p1+step*i;
-        result.emplace_back(std::array<bool,3>{{true, true, true}}, std::array<Eigen::Vector3d, 3>{{planeVector, line, zAxis}}, pt, (pt-center).norm(), toolNumber);
-      }
-
-      return result;
+      GraspPose prototype(std::array<bool,3>{{true, true, true}}, std::array<Eigen::Vector3d, 3>{{planeVector, line, zAxis}}, p1, 0, toolNumber);
+      return std::make_shared<GridGenerator>(level, 1, p1, step, Eigen::Vector3d::Zero(), center, prototype);
     }
 
-    std::vector<GraspPose> generatePosesOnPlane(size_t level, const Eigen::Vector3d& origin, const Eigen::Vector3d& width, const Eigen::Vector3d& height, int toolNumber){
-      std::vector<GraspPose> result;
-
+    Generator::Ptr posesOnPlane(size_t level, const Eigen::Vector3d& origin, const Eigen::Vector3d& width, const Eigen::Vector3d& height, int toolNumber){
       Eigen::Vector3d center=origin+(width+height)/2;
 
       Eigen::Vector3d stepW=width/level;
@@ -30,20 +288,14 @@ namespace Gripper{
 
       Eigen::Vector3d zAxis=width.cross(height).normalized();
 
-      for(int i=0; i<level; ++i){
-        for(int j=0; j<level; ++j){
-          Eigen::Vector3d pt=origin+stepW*i+stepH*j;
-          result.emplace_back(std::array<bool,3>{{false,false,true}}, std::array<Eigen::Vector3d,3>{{{},{},zAxis}}, pt, (pt-center).norm(), toolNumber);
-        }
-      }
-
-      return result;
+      GraspPose prototype(std::array<bool,3>{{false,false,true}}, std::array<Eigen::Vector3d,3>{{{},{},zAxis}}, origin, 0, toolNumber);
+      return std::make_shared<GridGenerator>(level, level, origin, stepW, stepH, center, prototype);
     }
-    std::vector<GraspPose> generatePosesOnCuboid(size_t level, const Eigen::Affine3d& pose, double width, double height, double depth, int toolNumber){
+
+    Generator::Ptr posesOnCuboid(size_t level, const Eigen::Affine3d& pose, double width, double height, double depth, int toolNumber){
       constexpr double margin=0.1;
       constexpr double reduceSize=1.0-2*margin;
 
-      std::vector<GraspPose> result;
       Eigen::Vector3d origin=pose*Eigen::Vector3d::Zero();
       Eigen::Vector3d xDir=pose*Eigen::Vector3d::UnitX();
       Eigen::Vector3d yDir=pose*Eigen::Vector3d::UnitY();
@@ -61,27 +313,41 @@ namespace Gripper{
       Eigen::Vector3d yMargin=margin*ySide;
       Eigen::Vector3d zMargin=margin*zSide;
 
-      std::array<std::vector<GraspPose>, 6> srcs;
       /** Generate poses for each of the 6 planes of the cube */
+      std::vector<Generator::Ptr> srcs(6);
 
       /** Bottom and top face */
-      srcs[0]=generatePosesOnPlane(level, origin+xMargin+yMargin, xSideRed, ySideRed, toolNumber);
-      srcs[1]=generatePosesOnPlane(level, origin+zSide+xMargin+yMargin, ySideRed, xSideRed, toolNumber);
+      srcs[0]=posesOnPlane(level, origin+xMargin+yMargin, xSideRed, ySideRed, toolNumber);
+      srcs[1]=posesOnPlane(level, origin+zSide+xMargin+yMargin, ySideRed, xSideRed, toolNumber);
 
 
       /** Left and right face */
-      srcs[2]=generatePosesOnPlane(level, origin+yMargin+zMargin, ySideRed, zSideRed, toolNumber);
-      srcs[3]=generatePosesOnPlane(level, origin+xSide+yMargin+zMargin, zSideRed, ySideRed, toolNumber);
+      srcs[2]=posesOnPlane(level, origin+yMargin+zMargin, ySideRed, zSideRed, toolNumber);
+      srcs[3]=posesOnPlane(level, origin+xSide+yMargin+zMargin, zSideRed, ySideRed, toolNumber);
 
       /** Front and rear */
-      srcs[4]=generatePosesOnPlane(level, origin+xMargin+zMargin, zSideRed, xSideRed, toolNumber);
-      srcs[5]=generatePosesOnPlane(level, origin+ySide+xMargin+zMargin, xSideRed, zSideRed, toolNumber);
+      srcs[4]=posesOnPlane(level, origin+xMargin+zMargin, zSideRed, xSideRed, toolNumber);
+      srcs[5]=posesOnPlane(level, origin+ySide+xMargin+zMargin, xSideRed, zSideRed, toolNumber);
 
-      /** Sums them all (well, moves them all) */
-      for(const auto& x : srcs){
-        result.insert(result.end(), std::make_move_iterator(x.begin()), std::make_move_iterator(x.end()));
-      }
+      return merge(srcs);
+    }
 
+    Generator::Ptr posesFromList(const std::vector<GraspPose>& poses){
+      auto sorted=std::make_shared<std::vector<GraspPose>>(poses);
+      std::stable_sort(sorted->begin(), sorted->end(), [] (const GraspPose& a, const GraspPose& b) { return a.preferenceScore<b.preferenceScore; });
+      return std::make_shared<ListGenerator>(sorted);
+    }
+
+    Generator::Ptr merge(const std::vector<Generator::Ptr>& sources){
+      return std::make_shared<MergedGenerator>(sources);
+    }
+
+    std::vector<GraspPose> drain(Generator& generator){
+      std::vector<GraspPose> result;
+      GraspPose pose;
+      while(generator.next(pose)){
+        result.push_back(pose);
+      }
       return result;
     }
   }
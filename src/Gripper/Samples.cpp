@@ -0,0 +1,246 @@
+#include <cmath>
+#include <cassert>
+#include <map>
+#include <mutex>
+#include <stdexcept>
+#include <Gripper/Samples.h>
+
+namespace Gripper{
+  namespace Samples{
+
+    namespace{
+      Set cubeSurface(size_t level){
+        /** Get an approximation using points of this cube size 1/level */
+        float step=1.0f/level;
+        const size_t expectedPts=6*level*level+2;
+        Set result(3, expectedPts);
+
+        size_t pos=0;
+        auto add=[&result, &pos] (float x, float y, float z) {
+          result.col(pos++) << x, y, z;
+        };
+
+        /** Work on Z axis, we will add caps later */
+        for(size_t i=0; i<=level; ++i){
+          float zCoord=i*step;
+
+          /** Left and right borders */
+          for(size_t j=0; j<=level; ++j){
+            float yCoord=j*step;
+            add(0, yCoord, zCoord);
+            add(1, yCoord, zCoord);
+          }
+
+          /** Up and down borders */
+          for(size_t j=1; j<level; ++j){
+            float xCoord=j*step;
+            add(xCoord, 0, zCoord);
+            add(xCoord, 1, zCoord);
+          }
+        }
+
+        /** Now add caps */
+        for(size_t i=1; i<level; ++i){
+          for(size_t j=1; j<level; ++j){
+            add(i*step, j*step, 0);
+            add(i*step, j*step, 1);
+          }
+        }
+        assert(pos==expectedPts);
+        return result;
+      }
+
+      /** Centers of a level^3 grid of cubes over [0,1]^3, [-1,1]^3 or [-1,1]^2x[0,1], filtered by inside */
+      template<typename Inside>
+        Set volumeGrid(size_t level, const Eigen::Vector3f& start, const Eigen::Vector3f& size, const Inside& inside){
+          Eigen::Vector3f step=size/level;
+          Eigen::Vector3f first=start+step/2.0f;
+          Set result(3, level*level*level);
+          size_t pos=0;
+          for(size_t i=0; i<level; ++i){
+            for(size_t j=0; j<level; ++j){
+              for(size_t k=0; k<level; ++k){
+                float x=first[0]+i*step[0], y=first[1]+j*step[1], z=first[2]+k*step[2];
+                if(inside(x, y, z)){
+                  result.col(pos++) << x, y, z;
+                }
+              }
+            }
+          }
+          result.conservativeResize(Eigen::NoChange, pos);
+          return result;
+        }
+
+      Set sphereSurface(size_t level){
+        /** No equal  density is required, let's go with UV coordinates */
+        double stepLat=2*M_PI/level;
+        double stepLon=2*M_PI/level;
+
+        Set result(3, level*(level-1)+2);
+        size_t pos=0;
+        for(size_t i=1; i<level; ++i){
+          double lat=stepLat*i;
+          double z=cos(lat);
+          for(size_t j=0; j<level; ++j){
+            double lon=stepLon*j;
+            result.col(pos++) << sin(lat)*cos(lon), sin(lat)*sin(lon), z;
+          }
+        }
+        result.col(pos++) << 0, 0, 1;
+        result.col(pos++) << 0, 0, -1;
+        return result;
+      }
+
+      Set cylinderSurface(size_t level){
+        size_t pos=0;
+        double stepZ=1.0/level;
+        double stepR=1.0/level;
+        double stepAngle=2*M_PI/level;
+
+        size_t expectedSize=3*level*level-level+2;
+        Set result(3, expectedSize);
+        /** On height */
+        for(size_t i=0; i<=level; ++i){
+          double z=stepZ*i;
+          for(size_t j=0; j<level; ++j){
+            double alpha=j*stepAngle;
+            result.col(pos++) << cos(alpha), sin(alpha), z;
+          }
+        }
+
+        /** Now add caps */
+        for(size_t i=1; i<level; ++i){
+          double r=stepR*i;
+          for(size_t j=0; j<level; ++j){
+            double alpha=j*stepAngle;
+            result.col(pos++) << r*cos(alpha), r*sin(alpha), 0;
+            result.col(pos++) << r*cos(alpha), r*sin(alpha), 1;
+          }
+        }
+
+        /** Center of caps, just for beautiness */
+        result.col(pos++) << 0, 0, 0;
+        result.col(pos++) << 0, 0, 1;
+        assert(pos==expectedSize);
+        return result;
+      }
+
+      Set build(Kind kind, size_t level){
+        switch(kind){
+          case CUBE_SURFACE:
+            return cubeSurface(level);
+          case CUBE_VOLUME:
+            return volumeGrid(level, Eigen::Vector3f::Zero(), Eigen::Vector3f::Ones(), [] (float, float, float) { return true; });
+          case SPHERE_SURFACE:
+            return sphereSurface(level);
+          case SPHERE_VOLUME:
+            return volumeGrid(level, Eigen::Vector3f::Constant(-1), Eigen::Vector3f::Constant(2), [] (float x, float y, float z) { return x*x+y*y+z*z<=1.0f; });
+          case CYLINDER_SURFACE:
+            return cylinderSurface(level);
+          case CYLINDER_VOLUME:
+            return volumeGrid(level, Eigen::Vector3f{-1, -1, 0}, Eigen::Vector3f{2, 2, 1}, [] (float x, float y, float) { return x*x+y*y<1.0f; });
+          default:
+            throw std::logic_error("Unknown kind of samples");
+        }
+      }
+
+      /** Builds the expression which tells whether the points (x, y, z), transformed by m, are inside the primitive */
+      template<typename Row>
+        auto transformed(const Eigen::Matrix<float, 3, 4>& m, int i, const Row& x, const Row& y, const Row& z) -> decltype(m(i,0)*x+m(i,1)*y+m(i,2)*z+m(i,3)) {
+          return m(i,0)*x+m(i,1)*y+m(i,2)*z+m(i,3);
+        }
+
+      template<Containment::Primitive P>
+        struct Test;
+
+      template<>
+        struct Test<Containment::UNIT_CUBE>{
+          template<typename X, typename Y, typename Z>
+            static auto inside(const X& x, const Y& y, const Z& z) -> decltype((x>0.0f) && (x<1.0f) && (y>0.0f) && (y<1.0f) && (z>0.0f) && (z<1.0f)) {
+              return (x>0.0f) && (x<1.0f) && (y>0.0f) && (y<1.0f) && (z>0.0f) && (z<1.0f);
+            }
+        };
+
+      template<>
+        struct Test<Containment::UNIT_SPHERE>{
+          template<typename X, typename Y, typename Z>
+            static auto inside(const X& x, const Y& y, const Z& z) -> decltype(x.square()+y.square()+z.square() < 1.0f) {
+              return x.square()+y.square()+z.square() < 1.0f;
+            }
+        };
+
+      template<>
+        struct Test<Containment::UNIT_CYLINDER>{
+          template<typename X, typename Y, typename Z>
+            static auto inside(const X& x, const Y& y, const Z& z) -> decltype((x.square()+y.square() < 1.0f) && (z>0.0f) && (z<1.0f)) {
+              return (x.square()+y.square() < 1.0f) && (z>0.0f) && (z<1.0f);
+            }
+        };
+
+      Eigen::Matrix<float, 3, 4> unitMatrix(const Eigen::Affine3d& ptsToWorld, const Containment& c){
+        return (c.toUnit*ptsToWorld).matrix().topRows<3>().cast<float>();
+      }
+
+      template<Containment::Primitive P>
+        size_t count(const Set& pts, const Eigen::Affine3d& ptsToWorld, const Containment& c){
+          const Eigen::Matrix<float, 3, 4> m=unitMatrix(ptsToWorld, c);
+          auto x=pts.row(0), y=pts.row(1), z=pts.row(2);
+          return Test<P>::inside(transformed(m, 0, x, y, z), transformed(m, 1, x, y, z), transformed(m, 2, x, y, z)).count();
+        }
+
+      template<Containment::Primitive P1, Containment::Primitive P2>
+        size_t count(const Set& pts, const Eigen::Affine3d& ptsToWorld, const Containment& c1, const Containment& c2){
+          const Eigen::Matrix<float, 3, 4> m1=unitMatrix(ptsToWorld, c1), m2=unitMatrix(ptsToWorld, c2);
+          auto x=pts.row(0), y=pts.row(1), z=pts.row(2);
+          return (Test<P1>::inside(transformed(m1, 0, x, y, z), transformed(m1, 1, x, y, z), transformed(m1, 2, x, y, z))
+              && Test<P2>::inside(transformed(m2, 0, x, y, z), transformed(m2, 1, x, y, z), transformed(m2, 2, x, y, z))).count();
+        }
+
+      template<Containment::Primitive P1>
+        size_t countSecond(const Set& pts, const Eigen::Affine3d& ptsToWorld, const Containment& c1, const Containment& c2){
+          switch(c2.primitive){
+            case Containment::UNIT_CUBE:
+              return count<P1, Containment::UNIT_CUBE>(pts, ptsToWorld, c1, c2);
+            case Containment::UNIT_SPHERE:
+              return count<P1, Containment::UNIT_SPHERE>(pts, ptsToWorld, c1, c2);
+            default:
+              return count<P1, Containment::UNIT_CYLINDER>(pts, ptsToWorld, c1, c2);
+          }
+        }
+    }
+
+    Ptr get(Kind kind, size_t level){
+      static std::mutex mutex;
+      static std::map<std::pair<Kind, size_t>, Ptr> cache;
+
+      std::lock_guard<std::mutex> lock(mutex);
+      Ptr& result=cache[std::make_pair(kind, level)];
+      if(!result){
+        result=std::make_shared<const Set>(build(kind, level));
+      }
+      return result;
+    }
+
+    size_t countContained(const Set& pts, const Eigen::Affine3d& ptsToWorld, const Containment& c){
+      switch(c.primitive){
+        case Containment::UNIT_CUBE:
+          return count<Containment::UNIT_CUBE>(pts, ptsToWorld, c);
+        case Containment::UNIT_SPHERE:
+          return count<Containment::UNIT_SPHERE>(pts, ptsToWorld, c);
+        default:
+          return count<Containment::UNIT_CYLINDER>(pts, ptsToWorld, c);
+      }
+    }
+
+    size_t countContained(const Set& pts, const Eigen::Affine3d& ptsToWorld, const Containment& c1, const Containment& c2){
+      switch(c1.primitive){
+        case Containment::UNIT_CUBE:
+          return countSecond<Containment::UNIT_CUBE>(pts, ptsToWorld, c1, c2);
+        case Containment::UNIT_SPHERE:
+          return countSecond<Containment::UNIT_SPHERE>(pts, ptsToWorld, c1, c2);
+        default:
+          return countSecond<Containment::UNIT_CYLINDER>(pts, ptsToWorld, c1, c2);
+      }
+    }
+  }
+}
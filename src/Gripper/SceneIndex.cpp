@@ -0,0 +1,85 @@
+#include <algorithm>
+#include <Gripper/SceneIndex.h>
+
+namespace Gripper{
+  SceneIndex::SceneIndex(const ObjectsScene& scene, const ObjectDB& objDB)
+  {
+    _items.reserve(scene.size());
+    for(const auto& x : scene){
+      const Object& o=objDB.at(x.first);
+      Item item;
+      item.box=transformBounds(x.second, o.myBounds);
+      item.center=x.second*o.myBoundingCenter;
+      item.radius=o.myBoundingRadius;
+      _items.push_back(item);
+      _order.push_back(_order.size());
+    }
+    if(!_items.empty()){
+      _nodes.reserve(2*_items.size());
+      build(0, _items.size());
+    }
+  }
+
+  int SceneIndex::build(size_t begin, size_t end){
+    int id=_nodes.size();
+    _nodes.push_back(Node{Eigen::AlignedBox3d{}, -1, -1, begin, end});
+    Eigen::AlignedBox3d box, centers;
+    for(size_t i=begin; i<end; ++i){
+      box.extend(_items[_order[i]].box);
+      centers.extend(_items[_order[i]].center);
+    }
+    _nodes[id].box=box;
+
+    if(end-begin<=LEAF_SIZE){
+      return id;
+    }
+
+    /** Median split along the axis where the centers are most spread */
+    int axis;
+    centers.sizes().maxCoeff(&axis);
+    size_t middle=begin+(end-begin)/2;
+    std::nth_element(_order.begin()+begin, _order.begin()+middle, _order.begin()+end, [this, axis] (size_t a, size_t b) {
+        return _items[a].center[axis] < _items[b].center[axis];
+        });
+    int left=build(begin, middle);
+    int right=build(middle, end);
+    _nodes[id].left=left;
+    _nodes[id].right=right;
+    return id;
+  }
+
+  void SceneIndex::query(const Eigen::AlignedBox3d& box, const Eigen::Vector3d& center, double radius, std::vector<size_t>& result) const {
+    result.clear();
+    if(_nodes.empty()){
+      return;
+    }
+    int stack[64];
+    int top=0;
+    stack[top++]=0;
+    while(top){
+      const Node& n=_nodes[stack[--top]];
+      if(!n.box.intersects(box)){
+        continue;
+      }
+      if(n.left<0){
+        for(size_t i=n.begin; i<n.end; ++i){
+          const Item& item=_items[_order[i]];
+          double r=item.radius+radius;
+          if(item.box.intersects(box) && (item.center-center).squaredNorm()<=r*r){
+            result.push_back(_order[i]);
+          }
+        }
+      }
+      else{
+        stack[top++]=n.left;
+        stack[top++]=n.right;
+      }
+    }
+    /** Callers accumulate scores, keep the order of the scene so that sums are not affected by the index */
+    std::sort(result.begin(), result.end());
+  }
+
+  size_t SceneIndex::size() const {
+    return _items.size();
+  }
+}
@@ -1,71 +1,97 @@
+#include <stdexcept>
 #include <Gripper/Shape.h>
+#include <Gripper/Intersections.h>
 #include <Utils/Eigen2CV.h>
 #include <pcl/point_types.h>
 
 namespace Gripper{
 
-  double Shape::intersectionVolumeHeuristic(const Shape& s) const{
-    throw std::logic_error("Asking for intersection heuristic to a shape which doesn't know any!");
-    return 0;
+  std::string Shape::getID() const {
+    return "Generic";
   }
 
-  double Shape::haveNoIntersection(const Shape& s) const{
-    throw std::logic_error("Asking for noIntersection heuristic to a shape which doesn't know any!");
-    return 0;
-  }
- 
-  Shape::ShapeList Shape::intersectionHeuristic() const {
-    return {};
+  Shape::Type Shape::getType() const {
+    return GENERIC;
   }
 
-  Shape::ShapeList Shape::noIntersectionHeuristic() const {
-    return {};
+  Eigen::AlignedBox3d Shape::getLocalBounds() const {
+    throw std::logic_error("Asking for the bounds of a shape which doesn't know them!");
   }
 
+  Eigen::AlignedBox3d Shape::getBounds() const {
+    return transformBounds(_pose, getLocalBounds());
+  }
 
-  std::string Shape::getID() const {
-    return "Generic";
+  bool Shape::intersects(const Shape& s) const {
+    if(s.getType()==COMPOSED){
+      return s.intersects(*this);
+    }
+    const Intersections::Kernel* k=Intersections::find(getType(), s.getType());
+    if(k){
+      return k->overlap(*this, s);
+    }
+    return getIntersectionVolume(s)>0;
   }
 
   double Shape::getIntersectionVolume(const Shape& s) const {
-    if(s.getID() == "Composed"){
+    if(s.getType()==COMPOSED){
       return s.getIntersectionVolume(*this);
     }
 
-    if(haveNoIntersectionHeuristic(s) && haveNoIntersection(s)){
-      return 0;
-    }
-    if(s.haveNoIntersectionHeuristic(*this) && s.haveNoIntersection(*this)){
-      return 0;
+    /** Closed-form (or bounded) routines for the known pairs of primitives */
+    const Intersections::Kernel* k=Intersections::find(getType(), s.getType());
+    if(k){
+      return k->volume(*this, s);
     }
 
-    if(haveIntersectionHeuristic(s)){
-      return intersectionVolumeHeuristic(s);
-    }
-    if(s.haveIntersectionHeuristic(*this)){
-      return s.intersectionVolumeHeuristic(*this);
-    }
-    
-    const Shape& smaller=(getVolume() > s.getVolume() ? *this : s);
-    const Shape& bigger=(getVolume() > s.getVolume() ? s : *this);
+    /** Fallback: point sampling */
+    const Shape& smaller=(getVolume() > s.getVolume() ? s : *this);
+    const Shape& bigger=(getVolume() > s.getVolume() ? *this : s);
+    const Eigen::Affine3d smallerToWorld=smaller.getUnitToWorld();
 
     std::array<size_t, 3> toTry={2,10,30};
     for(size_t surfLevel : toTry){
-      auto surfApprox=smaller.getCubettiSurface(surfLevel);
-      size_t countSurf=bigger.countContainedPoints(surfApprox);
+      auto surfApprox=smaller.getUnitSurface(surfLevel);
+      size_t countSurf=bigger.countContainedPoints(*surfApprox, smallerToWorld);
       if(countSurf){
-        if(countSurf==surfApprox.cols()){
+        if(countSurf==size_t(surfApprox->cols())){
           return smaller.getVolume();
         }
         else{
-          auto cubes=smaller.getCubettiVolume(BASE_APPROX_LEVEL);
-          return (bigger.countContainedPoints(cubes)*smaller.getVolume())/cubes.cols();
+          auto cubes=smaller.getUnitVolume(BASE_APPROX_LEVEL);
+          return (bigger.countContainedPoints(*cubes, smallerToWorld)*smaller.getVolume())/cubes->cols();
         }
       }
     }
     return 0;
   }
 
+  Shape::PointsMatrix Shape::getCubettiSurface(size_t level) const {
+    auto samples=getUnitSurface(level);
+    PointsMatrix result(4, samples->cols());
+    result.topRows<3>()=samples->cast<double>().matrix();
+    result.row(3).setOnes();
+    return getUnitToWorld()*result;
+  }
+
+  Shape::PointsMatrix Shape::getCubettiVolume(size_t level) const {
+    auto samples=getUnitVolume(level);
+    PointsMatrix result(4, samples->cols());
+    result.topRows<3>()=samples->cast<double>().matrix();
+    result.row(3).setOnes();
+    return getUnitToWorld()*result;
+  }
+
+  Shape::PointsMatrix Shape::getWeightedCubettiVolume(size_t level, std::vector<double>& weights) const {
+    PointsMatrix result=getCubettiVolume(level);
+    weights.assign(result.cols(), result.cols() ? getVolume()/result.cols() : 0);
+    return result;
+  }
+
+  double Shape::getSignedDistance(const Eigen::Vector3d& p) const {
+    throw std::logic_error("Asking for the distance from a shape which doesn't know it!");
+  }
+
   const std::vector<double>& Shape::getDimensions() const {
     return _dimensions;
   }
@@ -103,9 +129,24 @@ namespace Gripper{
     return _pose;
   }
 
-  size_t Shape::countContainedPoints(const Shape::PointsMatrix& pt) const {
-    assert(false && "Empty shape called.. This is probably a bug in your shape tree");
-    return 0;
+  size_t Shape::countContainedPoints(const Samples::Set& pts, const Eigen::Affine3d& ptsToWorld) const {
+    return Samples::countContained(pts, ptsToWorld, getContainment());
+  }
+
+  Samples::Ptr Shape::getUnitSurface(size_t level) const {
+    throw std::logic_error("Empty shape called.. This is probably a bug in your shape tree");
+  }
+
+  Samples::Ptr Shape::getUnitVolume(size_t level) const {
+    throw std::logic_error("Empty shape called.. This is probably a bug in your shape tree");
+  }
+
+  Eigen::Affine3d Shape::getUnitToWorld() const {
+    throw std::logic_error("Empty shape called.. This is probably a bug in your shape tree");
+  }
+
+  Samples::Containment Shape::getContainment() const {
+    throw std::logic_error("Empty shape called.. This is probably a bug in your shape tree");
   }
 
 
@@ -118,22 +159,15 @@ namespace Gripper{
     return Shape::Ptr{result};
   }
 
-  bool Shape::haveIntersectionHeuristic(const Shape& s) const {
-    for(const auto& x: intersectionHeuristic()){
-      if(x==s.getID() || x=="Anything"){
-        return true;
-      }
+  Eigen::AlignedBox3d transformBounds(const Eigen::Affine3d& pose, const Eigen::AlignedBox3d& b){
+    Eigen::AlignedBox3d result;
+    if(b.isEmpty()){
+      return result;
     }
-    return false;
-  }
-  
-  bool Shape::haveNoIntersectionHeuristic(const Shape& s) const {
-    for(const auto& x: noIntersectionHeuristic()){
-      if(x==s.getID() || x=="Anything"){
-        return true;
-      }
+    for(int i=0; i<8; ++i){
+      result.extend(pose*b.corner(static_cast<Eigen::AlignedBox3d::CornerType>(i)));
     }
-    return false;
+    return result;
   }
 
   void Shape::writeTo(cv::FileStorage& fs) const{
@@ -0,0 +1,198 @@
+#include <algorithm>
+#include <cstdint>
+#include <mutex>
+#include <new>
+#include <opencv2/core/core.hpp>
+#include <Img/FrameArena.h>
+
+namespace Img{
+  struct FrameArena::Chunk{
+    explicit Chunk(size_t s)
+      :
+        raw(new char[s+ALIGNMENT]),
+        size(s),
+        used(0),
+        live(0)
+    {
+      base=raw.get()+(ALIGNMENT-reinterpret_cast<uintptr_t>(raw.get())%ALIGNMENT)%ALIGNMENT;
+    }
+
+    std::unique_ptr<char[]> raw;
+    char* base;
+    const size_t size;
+    /** Only changed by the thread owning the arena */
+    size_t used;
+    /** Blocks not released yet, which may be released by any thread */
+    std::atomic<size_t> live;
+  };
+
+  namespace{
+    /** Most frames fit into a few of them; bigger blocks get a chunk of their own size */
+    const size_t CHUNK_SIZE=16<<20;
+
+    std::atomic<size_t> nChunkAllocations(0);
+
+    thread_local FrameArena* currentArena=nullptr;
+
+    size_t aligned(size_t size){
+      return (size+FrameArena::ALIGNMENT-1)/FrameArena::ALIGNMENT*FrameArena::ALIGNMENT;
+    }
+
+    /** Matrices of the thread's arena, if any; everything else (user data, other threads, OpenCL usage) is left to OpenCV's allocator */
+    class ArenaMatAllocator : public cv::MatAllocator{
+      public:
+        cv::UMatData* allocate(int dims, const int* sizes, int type, void* data, size_t* step, int flags, cv::UMatUsageFlags usageFlags) const override {
+          FrameArena* arena=FrameArena::current();
+          if(!arena || data || usageFlags!=cv::USAGE_DEFAULT){
+            return cv::Mat::getStdAllocator()->allocate(dims, sizes, type, data, step, flags, usageFlags);
+          }
+          /** Same steps as OpenCV's allocator */
+          size_t total=CV_ELEM_SIZE(type);
+          for(int i=dims-1; i>=0; --i){
+            if(step){
+              step[i]=total;
+            }
+            total*=sizes[i];
+          }
+          /** The header goes into the same block, before the data */
+          const size_t header=aligned(sizeof(cv::UMatData));
+          FrameArena::Chunk* chunk;
+          char* block=static_cast<char*>(arena->allocate(header+total, chunk));
+          cv::UMatData* u=new (block) cv::UMatData(this);
+          u->data=u->origdata=reinterpret_cast<uchar*>(block+header);
+          u->size=total;
+          u->userdata=chunk;
+          return u;
+        }
+
+        bool allocate(cv::UMatData* u, int accessFlags, cv::UMatUsageFlags usageFlags) const override {
+          return u!=nullptr;
+        }
+
+        void deallocate(cv::UMatData* u) const override {
+          if(!u){
+            return;
+          }
+          CV_Assert(u->urefcount==0 && u->refcount==0);
+          FrameArena::Chunk* chunk=static_cast<FrameArena::Chunk*>(u->userdata);
+          u->~UMatData();
+          FrameArena::release(chunk);
+        }
+    };
+
+    /** Arenas not bound to any thread: neither the pool nor the arenas are ever destroyed, as matrices may be released at exit */
+    struct Pool{
+      std::mutex mutex;
+      std::vector<FrameArena*> idle;
+
+      static Pool& getInstance(){
+        static Pool* instance=new Pool;
+        return *instance;
+      }
+    };
+
+    bool installAllocator(){
+      static ArenaMatAllocator* allocator=new ArenaMatAllocator;
+#if CV_VERSION_MAJOR>3 || (CV_VERSION_MAJOR==3 && CV_VERSION_MINOR>=2)
+      cv::Mat::setDefaultAllocator(allocator);
+      return true;
+#else
+      /** The default allocator can't be replaced: matrices keep using the heap */
+      (void)allocator;
+      return false;
+#endif
+    }
+  }
+
+  FrameArena::FrameArena()
+    :
+      _current(0)
+  {
+  }
+
+  FrameArena::~FrameArena(){
+  }
+
+  FrameArena::Scope::Scope()
+    :
+      _arena(nullptr)
+  {
+    static const bool installed=installAllocator();
+    (void)installed;
+    if(currentArena){
+      return;
+    }
+    Pool& pool=Pool::getInstance();
+    {
+      std::lock_guard<std::mutex> lock(pool.mutex);
+      if(!pool.idle.empty()){
+        _arena=pool.idle.back();
+        pool.idle.pop_back();
+      }
+    }
+    if(!_arena){
+      _arena=new FrameArena;
+    }
+    currentArena=_arena;
+  }
+
+  FrameArena::Scope::~Scope(){
+    if(!_arena){
+      return;
+    }
+    currentArena=nullptr;
+    _arena->reset();
+    Pool& pool=Pool::getInstance();
+    std::lock_guard<std::mutex> lock(pool.mutex);
+    pool.idle.push_back(_arena);
+  }
+
+  FrameArena* FrameArena::current(){
+    return currentArena;
+  }
+
+  void* FrameArena::allocate(size_t size, Chunk*& chunk){
+    size=aligned(std::max<size_t>(size, 1));
+    for(; _current<_chunks.size(); ++_current){
+      Chunk& c=*_chunks[_current];
+      if(c.size-c.used>=size){
+        break;
+      }
+    }
+    if(_current==_chunks.size()){
+      _chunks.emplace_back(new Chunk(std::max(size, CHUNK_SIZE)));
+      ++nChunkAllocations;
+    }
+    chunk=_chunks[_current].get();
+    void* block=chunk->base+chunk->used;
+    chunk->used+=size;
+    chunk->live.fetch_add(1, std::memory_order_relaxed);
+    return block;
+  }
+
+  void FrameArena::release(Chunk* chunk){
+    /** Whatever was done with the block happens before it is reused by reset */
+    chunk->live.fetch_sub(1, std::memory_order_release);
+  }
+
+  void FrameArena::reset(){
+    for(auto& c : _chunks){
+      if(c->live.load(std::memory_order_acquire)==0){
+        c->used=0;
+      }
+    }
+    _current=0;
+  }
+
+  size_t FrameArena::capacity() const {
+    size_t result=0;
+    for(const auto& c : _chunks){
+      result+=c->size;
+    }
+    return result;
+  }
+
+  size_t FrameArena::chunkAllocations(){
+    return nChunkAllocations.load();
+  }
+}
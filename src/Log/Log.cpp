@@ -1,5 +1,442 @@
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
 #include <iostream>
+#include <map>
+#include <mutex>
+#include <stdexcept>
+#include <streambuf>
+#include <thread>
+#include <vector>
+#include <Log/Log.h>
+
 namespace Log{
-  std::ostream& out::out=std::cout;
-  std::operator<<(std
+  namespace{
+    /** Longer messages are moved to the heap */
+    constexpr size_t INLINE_TEXT=200;
+    /** Power of 2 */
+    constexpr size_t RING_SIZE=4096;
+
+    /** Everything the writer needs, as plain data: the time is just a count, it is only converted when written */
+    struct Record{
+      int64_t time;
+      const Module* module;
+      Level level;
+      unsigned thread;
+      size_t length;
+      char* longText;
+      char text[INLINE_TEXT];
+    };
+
+    /** Bounded queue of records, lock free for the producers (which never wait) and drained by a single writer */
+    class Ring{
+      public:
+        Ring()
+          :
+            _cells(RING_SIZE),
+            _head(0),
+            _tail(0)
+        {
+          for(size_t i=0; i<RING_SIZE; ++i){
+            _cells[i].sequence.store(i, std::memory_order_relaxed);
+          }
+        }
+
+        struct Cell{
+          std::atomic<size_t> sequence;
+          Record record;
+        };
+
+        /** Returns the cell to fill, or nullptr if the ring is full: its record is published by push */
+        Cell* reserve(){
+          size_t pos=_head.load(std::memory_order_relaxed);
+          while(true){
+            Cell& cell=_cells[pos&(RING_SIZE-1)];
+            size_t sequence=cell.sequence.load(std::memory_order_acquire);
+            if(sequence==pos){
+              if(_head.compare_exchange_weak(pos, pos+1, std::memory_order_relaxed)){
+                return &cell;
+              }
+            }
+            else if(sequence<pos){
+              return nullptr;
+            }
+            else{
+              pos=_head.load(std::memory_order_relaxed);
+            }
+          }
+        }
+
+        void push(Cell* cell){
+          cell->sequence.store(cell->sequence.load(std::memory_order_relaxed)+1, std::memory_order_release);
+        }
+
+        /** Oldest published record, or nullptr: it stays valid until pop */
+        const Record* front() const {
+          const Cell& cell=_cells[_tail&(RING_SIZE-1)];
+          if(cell.sequence.load(std::memory_order_acquire)!=_tail+1){
+            return nullptr;
+          }
+          return &cell.record;
+        }
+
+        void pop(){
+          Cell& cell=_cells[_tail&(RING_SIZE-1)];
+          cell.sequence.store(_tail+RING_SIZE, std::memory_order_release);
+          ++_tail;
+          _popped.store(_tail, std::memory_order_release);
+        }
+
+        /** Number of records reserved so far */
+        size_t reserved() const {
+          return _head.load(std::memory_order_acquire);
+        }
+
+        /** Number of records written so far */
+        size_t popped() const {
+          return _popped.load(std::memory_order_acquire);
+        }
+
+      private:
+        std::vector<Cell> _cells;
+        std::atomic<size_t> _head;
+        /** Producers and consumer on different cache lines */
+        char _padding[64];
+        size_t _tail;
+        std::atomic<size_t> _popped{0};
+    };
+
+    /** Owns the ring and the thread writing it out; it is never destroyed, so that threads still logging at exit are harmless */
+    class Writer{
+      public:
+        static Writer& getInstance(){
+          static Writer* instance=new Writer;
+          return *instance;
+        }
+
+        void send(const Module& module, Level level, const char* text, size_t length){
+          Ring::Cell* cell=_ring.reserve();
+          if(!cell){
+            ++_dropped;
+            return;
+          }
+          Record* r=&cell->record;
+          r->time=std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+          r->module=&module;
+          r->level=level;
+          r->thread=threadNumber();
+          r->length=length;
+          if(length<=INLINE_TEXT){
+            r->longText=nullptr;
+            memcpy(r->text, text, length);
+          }
+          else{
+            r->longText=new char[length];
+            memcpy(r->longText, text, length);
+          }
+          _ring.push(cell);
+          start();
+          /** Wakes the writer up early when a burst is filling the ring */
+          if(_ring.reserved()-_ring.popped()>=RING_SIZE/4){
+            _wake.notify_one();
+          }
+        }
+
+        void flush(){
+          const size_t target=_ring.reserved();
+          while(_running.load() && _ring.popped()<target){
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+          }
+        }
+
+        size_t dropped() const {
+          return _dropped.load();
+        }
+
+      private:
+        Writer()
+          :
+            _running(false),
+            _stop(false),
+            _dropped(0),
+            _reported(0)
+        {
+        }
+
+        void start(){
+          std::call_once(_started, [this] () {
+              _running=true;
+              _thread=std::thread(&Writer::run, this);
+              std::atexit(&Writer::stopAtExit);
+              });
+        }
+
+        static void stopAtExit(){
+          Writer& w=getInstance();
+          w._stop=true;
+          w._thread.join();
+          w._running=false;
+        }
+
+        static unsigned threadNumber(){
+          static std::atomic<unsigned> next(0);
+          thread_local unsigned number=next++;
+          return number;
+        }
+
+        void write(const Record& r){
+          const std::time_t seconds=r.time/1000000;
+          std::tm local;
+          localtime_r(&seconds, &local);
+          char header[128];
+          size_t n=strftime(header, sizeof(header), "%H:%M:%S", &local);
+          n+=snprintf(header+n, sizeof(header)-n, ".%06ld %-7s %s #%u: ", long(r.time%1000000), levelName(r.level), r.module->name(), r.thread);
+          _out.write(header, std::min(n, sizeof(header)-1));
+          const char* text=r.longText ? r.longText : r.text;
+          _out.write(text, r.length);
+          if(r.length==0 || text[r.length-1]!='\n'){
+            _out << '\n';
+          }
+          delete[] r.longText;
+        }
+
+        void run(){
+          while(true){
+            /** Everything logged before the stop request is written */
+            const bool stopping=_stop.load();
+            bool written=false;
+            while(const Record* r=_ring.front()){
+              write(*r);
+              _ring.pop();
+              written=true;
+            }
+            const size_t dropped=_dropped.load();
+            if(dropped!=_reported){
+              _out << "Log: " << dropped-_reported << " messages dropped\n";
+              _reported=dropped;
+              written=true;
+            }
+            if(written){
+              _out.flush();
+            }
+            if(stopping){
+              return;
+            }
+            std::unique_lock<std::mutex> lock(_sleeping);
+            _wake.wait_for(lock, std::chrono::milliseconds(2));
+          }
+        }
+
+        Ring _ring;
+        std::ostream& _out=std::clog;
+        std::once_flag _started;
+        std::thread _thread;
+        std::mutex _sleeping;
+        std::condition_variable _wake;
+        std::atomic<bool> _running;
+        std::atomic<bool> _stop;
+        std::atomic<size_t> _dropped;
+        size_t _reported;
+    };
+
+    /** Modules by name, and the levels asked for by configure, also for the modules not created yet */
+    struct Registry{
+      std::mutex mutex;
+      std::map<std::string, Module*> modules;
+      std::map<std::string, Level> levels;
+      Level defaultLevel=INFO;
+
+      static Registry& getInstance(){
+        static Registry* instance=new Registry;
+        return *instance;
+      }
+
+      Level levelOf(const std::string& name) const {
+        auto l=levels.find(name);
+        return l==levels.end() ? defaultLevel : l->second;
+      }
+    };
+
+    Level parseLevel(const std::string& name){
+      static const char* names[]={"trace", "debug", "info", "warning", "error"};
+      for(int l=TRACE; l<=ERROR; ++l){
+        if(name==names[l]){
+          return Level(l);
+        }
+      }
+      throw std::invalid_argument("Unknown log level: "+name);
+    }
+
+    void configureUnlocked(Registry& r, const std::string& levels){
+      size_t start=0;
+      while(start<=levels.size()){
+        size_t end=levels.find(',', start);
+        if(end==std::string::npos){
+          end=levels.size();
+        }
+        const std::string item=levels.substr(start, end-start);
+        start=end+1;
+        if(item.empty()){
+          continue;
+        }
+        size_t eq=item.find('=');
+        if(eq==std::string::npos){
+          r.defaultLevel=parseLevel(item);
+          r.levels.clear();
+          for(auto& m : r.modules){
+            m.second->setLevel(r.defaultLevel);
+          }
+        }
+        else{
+          const std::string name=item.substr(0, eq);
+          const Level level=parseLevel(item.substr(eq+1));
+          r.levels[name]=level;
+          auto m=r.modules.find(name);
+          if(m!=r.modules.end()){
+            m->second->setLevel(level);
+          }
+        }
+      }
+    }
+
+    void configureFromEnvironment(Registry& r){
+      static bool done=false;
+      if(done){
+        return;
+      }
+      done=true;
+      if(const char* levels=getenv("APC_LOG")){
+        try{
+          configureUnlocked(r, levels);
+        }
+        catch(const std::invalid_argument& e){
+          std::cerr << "APC_LOG ignored: " << e.what() << "\n";
+        }
+      }
+    }
+
+    /** Streams into a fixed buffer first, and only into a string past its end */
+    const size_t LINE_BUFFER=1024;
+  }
+
+  class Line::Buffer : public std::streambuf{
+    public:
+      Buffer()
+        :
+          stream(this),
+          busy(false)
+      {
+        reset();
+      }
+
+      void reset(){
+        setp(_fixed, _fixed+LINE_BUFFER);
+        _spill.clear();
+        stream.clear();
+        stream.flags(std::ios_base::dec | std::ios_base::skipws);
+        stream.precision(6);
+        stream.width(0);
+        stream.fill(' ');
+      }
+
+      /** The message, which is only valid until reset */
+      const char* data(size_t& length){
+        if(_spill.empty()){
+          length=pptr()-pbase();
+          return _fixed;
+        }
+        _spill.append(pbase(), pptr()-pbase());
+        setp(_fixed, _fixed+LINE_BUFFER);
+        length=_spill.size();
+        return _spill.data();
+      }
+
+      std::ostream stream;
+      bool busy;
+
+    protected:
+      int_type overflow(int_type c) override {
+        _spill.append(pbase(), pptr()-pbase());
+        setp(_fixed, _fixed+LINE_BUFFER);
+        if(!traits_type::eq_int_type(c, traits_type::eof())){
+          _spill.push_back(traits_type::to_char_type(c));
+        }
+        return traits_type::not_eof(c);
+      }
+
+    private:
+      char _fixed[LINE_BUFFER];
+      std::string _spill;
+  };
+
+  const char* levelName(Level level){
+    static const char* names[]={"TRACE", "DEBUG", "INFO", "WARNING", "ERROR"};
+    return names[level];
+  }
+
+  Module::Module(const std::string& name, Level level)
+    :
+      _name(name),
+      _level(level)
+  {
+  }
+
+  Module& module(const std::string& name){
+    Registry& r=Registry::getInstance();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    configureFromEnvironment(r);
+    auto m=r.modules.find(name);
+    if(m==r.modules.end()){
+      m=r.modules.insert(std::make_pair(name, new Module(name, r.levelOf(name)))).first;
+    }
+    return *m->second;
+  }
+
+  void configure(const std::string& levels){
+    Registry& r=Registry::getInstance();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    configureFromEnvironment(r);
+    configureUnlocked(r, levels);
+  }
+
+  void flush(){
+    Writer::getInstance().flush();
+  }
+
+  size_t dropped(){
+    return Writer::getInstance().dropped();
+  }
+
+  Line::Line(const Module& module, Level level)
+    :
+      _module(module),
+      _level(level)
+  {
+    thread_local Buffer threadBuffer;
+    if(threadBuffer.busy){
+      _nested.reset(new Buffer);
+      _buffer=_nested.get();
+    }
+    else{
+      _buffer=&threadBuffer;
+      _buffer->reset();
+    }
+    _buffer->busy=true;
+  }
+
+  Line::~Line(){
+    size_t length;
+    const char* text=_buffer->data(length);
+    Writer::getInstance().send(_module, _level, text, length);
+    _buffer->busy=false;
+  }
+
+  std::ostream& Line::stream(){
+    return _buffer->stream;
+  }
 }
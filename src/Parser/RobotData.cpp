@@ -10,13 +10,18 @@
 #include <C5G/Grasp.h>
 
 namespace InterProcessCommunication{
+  namespace{
+    bool samePose(const C5G::Pose& a, const C5G::Pose& b){
+      return a.x==b.x && a.y==b.y && a.z==b.z && a.alpha==b.alpha && a.beta==b.beta && a.gamma==b.gamma;
+    }
+  }
 
   std::ostream& operator<< (std::ostream& os, const InterProcessCommunication::RobotData& r){
-    for(int i=0; i<12; ++i){
+    for(int i=0; i<RobotData::ROW_N*RobotData::COL_N; ++i){
+      RobotData::BinSnapshot bin=std::atomic_load(&r._bins[i]);
       os << "Bin " << (char) (i+'A') << ": ";
       for(int item=0; item<RobotData::MAX_ITEM_N; ++item){
-        std::string s=r.shelf.bins[i].object[item];
-        os << r.shelf.bins[i].object[item];
+        os << bin->object[item];
         os << ",";
       }
       os << "\n";
@@ -24,11 +29,11 @@ namespace InterProcessCommunication{
     return os;
   }
 
-  int RobotData::getCurrentRow(){
+  int RobotData::getCurrentRow() const{
     return _row;
   }
 
-  int RobotData::getCurrentColumn(){
+  int RobotData::getCurrentColumn() const{
     return _column;
   }
 
@@ -45,19 +50,44 @@ namespace InterProcessCommunication{
     return instance;
   }
 
-  std::string RobotData::getBinItem(int row, int column, int item){
-    return this->shelf.bins[xyToBin(row,column)].object[item];
+  RobotData::BinSnapshot RobotData::getBin(int row, int column) const{
+    return std::atomic_load(&_bins[xyToBin(row, column)]);
+  }
+
+  void RobotData::updateBin(int row, int column, const std::function<void(Bin&)>& f){
+    const int b=xyToBin(row, column);
+    std::lock_guard<std::mutex> lock(_binWriters[b]);
+    const BinSnapshot current=std::atomic_load(&_bins[b]);
+    std::shared_ptr<Bin> updated=std::make_shared<Bin>(*current);
+    f(*updated);
+    updated->version=current->version;
+    for(int i=0; i<MAX_ITEM_N; ++i){
+      if(current->object[i]!=updated->object[i] || !samePose(current->objPose[i], updated->objPose[i])){
+        ++updated->version;
+        break;
+      }
+    }
+    std::atomic_store(&_bins[b], BinSnapshot(updated));
+  }
+
+  std::string RobotData::getBinItem(int row, int column, int item) const{
+    return getBin(row, column)->object[item];
   }
 
   void RobotData::setBinItem(int row,int column,int item,const std::string& val){
-    this->shelf.bins[xyToBin(row,column)].object[item] = val;
+    updateBin(row, column, [item, &val] (Bin& b) { b.object[item]=val; });
   }
+
   C5G::Pose RobotData::getObjPose(int row, int column, int item) const{
-    return this->shelf.bins[xyToBin(row,column)].objPose[item];
+    return getBin(row, column)->objPose[item];
   }
 
   void RobotData::setObjPose(int row,int column,int item,const C5G::Pose& val){
-    this->shelf.bins[xyToBin(row,column)].objPose[item] = val;
+    updateBin(row, column, [item, &val] (Bin& b) { b.objPose[item]=val; });
+  }
+
+  unsigned long RobotData::getBinVersion(int row, int column) const{
+    return getBin(row, column)->version;
   }
 
   int RobotData::xyToBin(int row, int column){
@@ -65,7 +95,7 @@ namespace InterProcessCommunication{
   }
 
   void RobotData::setDirty(int row, int column, bool value){
-    shelf.bins[xyToBin(row, column)].dirty=value;
+    updateBin(row, column, [value] (Bin& b) { b.dirty=value; });
   }
 
   std::string RobotData::xyToName(int row,int  column){
@@ -76,19 +106,23 @@ namespace InterProcessCommunication{
     return std::string("")+r;
   }
 
-  bool RobotData::isDirty(int row, int column){
-    return shelf.bins[xyToBin(row, column)].dirty;
+  bool RobotData::isDirty(int row, int column) const{
+    return getBin(row, column)->dirty;
   }
 
-  APC::OrderStatus RobotData::getWorkOrder(){
-    return this->workOrder;
+  APC::OrderStatus RobotData::getWorkOrder() const{
+    return *std::atomic_load(&_workOrder);
   }
+
   void RobotData::setWorkOrder(int row, int column,const std::string& itemName){
     std::cout << "Robotdata: received "+itemName+" into row" << row<<" column"<<column << "\n";
     APC::Order x(itemName);
     x.bin[0]=row;
     x.bin[1]=column;
-    this->workOrder.push(x);
+    std::lock_guard<std::mutex> lock(_workOrderWriter);
+    auto updated=std::make_shared<APC::OrderStatus>(*std::atomic_load(&_workOrder));
+    updated->push(x);
+    std::atomic_store(&_workOrder, std::shared_ptr<const APC::OrderStatus>(updated));
   }
   Camera::ImageViewer RobotData::demoViewer("APC");
 
@@ -97,21 +131,44 @@ namespace InterProcessCommunication{
   }
 
   RobotData::RobotData() 
+    :
+      _workOrder(std::make_shared<APC::OrderStatus>()),
+      _row(0),
+      _column(0)
   {
     std::cout << "Your mom is being constructed\n";
+    auto empty=std::make_shared<Bin>();
+    empty->dirty=false;
+    empty->version=0;
+    empty->photo=std::make_shared<Image>();
+    for(auto& b : _bins){
+      b=empty;
+    }
   };
 
   void RobotData::operator=(RobotData const&) {}; // Don't implement
   RobotData::RobotData(RobotData const&) {};              // Don't Implement
 
   void RobotData::setPhoto(int row, int column, const Img::Image& frame){
-    shelf.bins[xyToBin(row, column)].photo=frame;
-  }
-  Img::Image RobotData::getPhoto(int row, int column){
+    PhotoPtr photo=std::make_shared<const Image>(frame);
+    updateBin(row, column, [&photo] (Bin& b) {
+        b.photo=photo;
+        b.rightPhoto=nullptr;
+        });
+  }
+  void RobotData::setPhotos(int row, int column, const Img::Image& left, const Img::Image& right){
+    PhotoPtr leftPhoto=std::make_shared<const Image>(left);
+    PhotoPtr rightPhoto=std::make_shared<const Image>(right);
+    updateBin(row, column, [&leftPhoto, &rightPhoto] (Bin& b) {
+        b.photo=leftPhoto;
+        b.rightPhoto=rightPhoto;
+        });
+  }
+  RobotData::PhotoPtr RobotData::getPhoto(int row, int column) const{
     //ppporco
     return this->getFrame(row,column);
   }
-  Img::Image RobotData::getFrame(int row, int column){
-    return shelf.bins[xyToBin(row,column)].photo;
+  RobotData::PhotoPtr RobotData::getFrame(int row, int column) const{
+    return getBin(row, column)->photo;
   }
 }
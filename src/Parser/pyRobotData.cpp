@@ -1,12 +1,122 @@
+#include <memory>
 #include <Parser/RobotData.h>
 
 #include <boost/python.hpp>
 #include <boost/python/module.hpp>
 #include <boost/python/def.hpp>
 
+#define NPY_NO_DEPRECATED_API NPY_1_7_API_VERSION
+#include <numpy/arrayobject.h>
+
+/** Photos and poses are exposed as read-only NumPy arrays sharing memory with RobotData: each array keeps alive the
+ * snapshot (see RobotData::getBin) or the photo it looks into, so that they can be used as long as needed while the
+ * shelf goes on changing.
+ */
+namespace{
+  namespace python=boost::python;
+  using InterProcessCommunication::RobotData;
+
+  static_assert(sizeof(C5G::Pose)==6*sizeof(double), "Poses are viewed as arrays of 6 doubles");
+
+  template<typename T>
+  void release(PyObject* capsule){
+    delete static_cast<std::shared_ptr<T>*>(PyCapsule_GetPointer(capsule, nullptr));
+  }
+
+  /** Read-only array on data, which stays valid as long as owner does */
+  template<typename T>
+  python::object view(void* data, int nd, npy_intp* dims, npy_intp* strides, int type, const std::shared_ptr<T>& owner){
+    PyObject* array=PyArray_New(&PyArray_Type, nd, dims, type, strides, data, 0, NPY_ARRAY_ALIGNED, nullptr);
+    if(!array){
+      python::throw_error_already_set();
+    }
+    PyObject* capsule=PyCapsule_New(new std::shared_ptr<T>(owner), nullptr, &release<T>);
+    /** The array takes over the capsule, even on failure */
+    if(!capsule || PyArray_SetBaseObject(reinterpret_cast<PyArrayObject*>(array), capsule)!=0){
+      Py_DECREF(array);
+      python::throw_error_already_set();
+    }
+    return python::object(python::handle<>(array));
+  }
+
+  /** rows x columns (x channels) array, or None if there is no image */
+  python::object matrixView(const cv::Mat& m, int type, const RobotData::PhotoPtr& photo){
+    if(m.empty()){
+      return python::object();
+    }
+    npy_intp dims[3]={m.rows, m.cols, m.channels()};
+    npy_intp strides[3]={npy_intp(m.step[0]), npy_intp(m.elemSize()), npy_intp(m.elemSize1())};
+    return view(m.data, m.channels()==1 ? 2 : 3, dims, strides, type, photo);
+  }
+
+  /** BGR, as OpenCV */
+  python::object rgbView(const RobotData::PhotoPtr& photo){
+    return matrixView(photo->rgb, NPY_UINT8, photo);
+  }
+
+  /** In meters */
+  python::object depthView(const RobotData::PhotoPtr& photo){
+    return matrixView(photo->depth, NPY_FLOAT32, photo);
+  }
+
+  /** MAX_ITEM_N x (x, y, z, alpha, beta, gamma), relative to the camera; items which haven't been found have x=-10000 */
+  python::object posesView(const RobotData::BinSnapshot& bin){
+    npy_intp dims[2]={RobotData::MAX_ITEM_N, 6};
+    return view(const_cast<C5G::Pose*>(bin->objPose), 2, dims, nullptr, NPY_FLOAT64, bin);
+  }
+
+  python::dict binDict(const RobotData::BinSnapshot& bin){
+    python::dict result;
+    python::list items;
+    for(const auto& x : bin->object){
+      items.append(x);
+    }
+    result["items"]=items;
+    result["poses"]=posesView(bin);
+    result["rgb"]=rgbView(bin->photo);
+    result["depth"]=depthView(bin->photo);
+    result["dirty"]=bin->dirty;
+    result["version"]=bin->version;
+    return result;
+  }
+
+  python::object getPhotoRGB(RobotData& r, int row, int column){
+    return rgbView(r.getPhoto(row, column));
+  }
+
+  python::object getPhotoDepth(RobotData& r, int row, int column){
+    return depthView(r.getPhoto(row, column));
+  }
+
+  python::object getObjPoses(RobotData& r, int row, int column){
+    return posesView(r.getBin(row, column));
+  }
+
+  /** Items, poses, photo, dirty flag and version of the bin, all from the same snapshot */
+  python::dict getBin(RobotData& r, int row, int column){
+    return binDict(r.getBin(row, column));
+  }
+
+  /** getBin for all the bins, as a list of rows */
+  python::list getShelf(RobotData& r){
+    python::list rows;
+    for(int row=0; row<RobotData::ROW_N; ++row){
+      python::list columns;
+      for(int column=0; column<RobotData::COL_N; ++column){
+        columns.append(binDict(r.getBin(row, column)));
+      }
+      rows.append(columns);
+    }
+    return rows;
+  }
+}
+
 BOOST_PYTHON_MODULE(apcRobot)
 {
   namespace python = boost::python;
+  if(_import_array()<0){
+    python::throw_error_already_set();
+  }
   {
     python::class_<InterProcessCommunication::RobotData , boost::noncopyable>("RobotData", python::no_init)
       .def("getInstance",&InterProcessCommunication::RobotData::getInstance,python::return_value_policy<python::reference_existing_object>() )
@@ -15,6 +125,11 @@ BOOST_PYTHON_MODULE(apcRobot)
       .def("setBinItem",&InterProcessCommunication::RobotData::setBinItem)
       .def("getWorkOrder",&InterProcessCommunication::RobotData::getWorkOrder)
       .def("setWorkOrder",&InterProcessCommunication::RobotData::setWorkOrder)
+      .def("getPhotoRGB",&getPhotoRGB)
+      .def("getPhotoDepth",&getPhotoDepth)
+      .def("getObjPoses",&getObjPoses)
+      .def("getBin",&getBin)
+      .def("getShelf",&getShelf)
       ;
   }
 }
@@ -20,8 +20,7 @@ namespace Recognition{
     :
       _myId(id),
       _camModel(1,1,1,1,1,1,1,1,1,1,1,1,1),
-      _renderer(Renderer3d::globalRenderer()),
-      _detector(nullptr)
+      _renderer(Renderer3d::globalRenderer())
   {
     readFrom(id, trainDir);
   }
@@ -41,13 +40,14 @@ namespace Recognition{
       _myId(id),
       mesh_file_path(meshFile),
       _detectorType(detectorType),
-      _detector(detectorByString(detectorType)),
       _camModel(cam),
       renderer_near(0.1),
       renderer_far(4),
       _mesh(meshFile),
       _renderer(Renderer3d::globalRenderer())
   {
+    /** Fails early on unknown detectors */
+    detectorByString(detectorType);
     _mesh.LoadMesh(meshFile);
     _renderer.set_parameters(cam, renderer_near, renderer_far, std::string("Model")+mesh_file_path);
     initializeMyPCL();
@@ -101,13 +101,21 @@ namespace Recognition{
     inFile["mesh_file_path"] >> mesh_file_path;
     _mesh.LoadMesh(mesh_file_path);
     inFile["detector_type"] >> _detectorType;
-    _detector=detectorByString(_detectorType);
-    std::cout<<"\tNumber of templates:"<<_detector->numTemplates()<<"\n";
 
     /** Read the trained class ID for this object */
     cv::FileNode fn = inFile["object"];
     fn["class_id"] >> _myId;
-    _detector->readClass(fn);
+    {
+      /** The detector is only needed to parse the templates */
+      cv::Ptr<Detector> detector=detectorByString(_detectorType);
+      detector->readClass(fn);
+      _templates=PackedTemplates();
+      for(int tID=0; tID<detector->numTemplates(); ++tID){
+        _templates.add(detector->getTemplates(_myId, tID));
+      }
+    }
+    _templates.shrinkToFit();
+    std::cout<<"\tNumber of templates:"<<_templates.size()<<" ("<<_templates.memoryUsage()/1024<<" KiB)\n";
 
     /** Initialize the renderer with the same parameters used for learning */
     cv::FileNode fr = inFile["rendering"]["trainCamera"];
@@ -131,18 +139,19 @@ namespace Recognition{
   }
 
   const std::vector<cv::linemod::Template> Model::getTemplates(int templateID) const {
-    return _detector->getTemplates(_myId, templateID);
+    return _templates.get(templateID);
   }
 
   void Model::addAllTemplates(Detector& det) const {
-    for(int i=0; i<_detector->numTemplates(); ++i){
-      auto& t=getTemplates(i);
-      det.addSyntheticTemplate(t, _myId);
-    }
+    _templates.addTo(det, _myId);
   }
 
   int Model::numTemplates() const {
-    return _detector->numTemplates();
+    return _templates.size();
+  }
+
+  size_t Model::detectorMemoryUsage() const {
+    return _templates.unpackedMemoryUsage();
   }
   cv::Matx33d Model::getR(int templateID) const {
     return _myData.at(templateID).R;
@@ -272,12 +281,15 @@ namespace Recognition{
     trainMasks[1]=eroded_mask;
     assert(image.type()==CV_8UC3);
     assert(depth.type()==CV_16UC1);
-    int template_in = _detector->addTemplate(sources, _myId, mask);
-    if (template_in == -1)
+    /** A new detector just to extract the features, so that the templates aren't kept twice */
+    cv::Ptr<Detector> detector=detectorByString(_detectorType);
+    int extracted = detector->addTemplate(sources, _myId, mask);
+    if (extracted == -1)
     {
       std::cout << "Bad template detected (?)\n";
       return;
     }
+    int template_in = _templates.add(detector->getTemplates(_myId, extracted));
 
     /** hue histogram */
     /* Convert to HSV */
@@ -321,28 +333,24 @@ namespace Recognition{
     addTraining(rot.rotation().matrix(), distance, cam);
   }
 
-  void Model::saveToDirectory(const boost::filesystem::path& saveDir) const
+  /** The format read by readFrom */
+  static void writeTraining(const boost::filesystem::path& filename, const std::string& id, const std::string& meshFile, const std::string& detectorType, const cv::linemod::Detector& detector, const std::unordered_map<int, Model::TrainingData>& data, double near, double far, const Camera::CameraModel& cam)
   {
-    using boost::filesystem::path;
-    assert(is_directory(saveDir) && "no valid directory provided");
-    path filename=saveDir / path(_myId) / path(_myId+"_Linemod.yml");
-
     cv::FileStorage fs(filename.string(), cv::FileStorage::WRITE);
 
-    fs << "mesh_file_path" << mesh_file_path ;
+    fs << "mesh_file_path" << meshFile ;
 
-    fs << "detector_type" << _detectorType;
+    fs << "detector_type" << detectorType;
 
-    assert(_detector->classIds().size()==1 && "Multiple classes into the same model");
+    assert(detector.classIds().size()==1 && "Multiple classes into the same model");
     fs << "object" ;
     fs << "{";
-    _detector->writeClass(_myId, fs);
+    detector.writeClass(id, fs);
     fs << "}";
 
     //save : R, T, dist, and Ks for that class
-    int nData=_myData.size();
     fs << "trainData" << "[";
-    for (auto& item : _myData)
+    for (auto& item : data)
     {
       fs << "{";
       fs << "id" << item.first;
@@ -352,11 +360,79 @@ namespace Recognition{
     fs << "]";
 
     fs << "rendering"  << "{";
-    fs << "renderer_near" <<  renderer_near;
-    fs << "renderer_far" <<  renderer_far;
-    fs << "trainCamera" << _camModel;
+    fs << "renderer_near" <<  near;
+    fs << "renderer_far" <<  far;
+    fs << "trainCamera" << cam;
     fs << "}";
+  }
+
+  void Model::saveToDirectory(const boost::filesystem::path& saveDir) const
+  {
+    using boost::filesystem::path;
+    assert(is_directory(saveDir) && "no valid directory provided");
+    path filename=saveDir / path(_myId) / path(_myId+"_Linemod.yml");
+    cv::Ptr<Detector> detector=detectorByString(_detectorType);
+    addAllTemplates(*detector);
+    writeTraining(filename, _myId, mesh_file_path, _detectorType, *detector, _myData, renderer_near, renderer_far, _camModel);
+  }
+
+  int Model::mergeTrainings(const std::string& id, const std::vector<boost::filesystem::path>& trainDirs, const boost::filesystem::path& saveDir)
+  {
+    namespace fs=boost::filesystem;
+    std::string meshFile, detectorType;
+    double near=0, far=0;
+    Camera::CameraModel cam(1,1,1,1,1,1,1,1,1,1,1,1,1);
+    cv::Ptr<Detector> merged;
+    std::unordered_map<int, TrainingData> data;
+
+    for(const auto& dir : trainDirs){
+      const fs::path file=dir / fs::path(id) / fs::path(id+"_Linemod.yml");
+      if(!fs::exists(file)){
+        continue;
+      }
+      cv::FileStorage in(file.string(), cv::FileStorage::READ);
+      std::string partType;
+      in["detector_type"] >> partType;
+      if(!merged){
+        detectorType=partType;
+        merged=detectorByString(detectorType);
+        in["mesh_file_path"] >> meshFile;
+        in["rendering"]["renderer_near"] >> near;
+        in["rendering"]["renderer_far"] >> far;
+        cam=Camera::CameraModel::readFrom(in["rendering"]["trainCamera"]);
+      }
+      else if(partType!=detectorType){
+        throw std::runtime_error("Can't merge trainings made with different detectors");
+      }
+
+      cv::Ptr<Detector> part=detectorByString(partType);
+      part->readClass(in["object"], id);
+      std::unordered_map<int, TrainingData> partData;
+      for(const auto& it : in["trainData"]){
+        int tID;
+        it["id"] >> tID;
+        read(it["data"], partData[tID], {});
+      }
+      /** Same order as if the templates of all the parts had been added to the same model */
+      for(int tID=0; tID<part->numTemplates(id); ++tID){
+        int mergedID=merged->addSyntheticTemplate(part->getTemplates(id, tID), id);
+        auto d=partData.find(tID);
+        if(d==partData.end()){
+          throw std::runtime_error("Training of "+id+" into "+dir.string()+" has no data for template "+std::to_string(tID));
+        }
+        data.insert(std::make_pair(mergedID, d->second));
+      }
+    }
+    if(!merged){
+      throw std::runtime_error("No training of "+id+" to merge");
+    }
 
+    /** Parts can also be into saveDir */
+    const fs::path filename=saveDir / fs::path(id) / fs::path(id+"_Linemod.yml");
+    const fs::path partial=filename.string()+".part";
+    writeTraining(partial, id, meshFile, detectorType, *merged, data, near, far, cam);
+    fs::rename(partial, filename);
+    return merged->numTemplates(id);
   }
 
   void Model::render(const Eigen::Affine3f& pose, cv::Mat& rgb_out, cv::Mat& depth_out, cv::Mat& mask_out, cv::Rect& rect_out) const {
@@ -439,7 +515,8 @@ namespace cv{
     /* Read YAML Vector */
     cv::Mat R;
     cv::Vec3d T;
-    float dist,a,b,g;
+    /** As written: merged trainings must be the same as the ones made at once */
+    double dist,a,b,g;
     int centerX, centerY;
     double centerDepth;
     cv::Mat hueHist;
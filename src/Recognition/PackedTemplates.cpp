@@ -0,0 +1,106 @@
+#include <limits>
+#include <stdexcept>
+#include <Recognition/PackedTemplates.h>
+
+namespace Recognition{
+  PackedTemplates::PackedTemplates()
+    :
+      _perPyramid(0)
+  {
+  }
+
+  int PackedTemplates::add(const std::vector<cv::linemod::Template>& pyramid){
+    if(pyramid.empty()){
+      throw std::invalid_argument("Empty template pyramid");
+    }
+    if(_perPyramid==0){
+      _perPyramid=pyramid.size();
+    }
+    else if(pyramid.size()!=size_t(_perPyramid)){
+      throw std::invalid_argument("Template pyramids of different sizes can't be packed together");
+    }
+
+    constexpr int maxOffset=std::numeric_limits<uint16_t>::max();
+    /** Everything is checked before anything is added */
+    for(const auto& t : pyramid){
+      if(t.width<0 || t.width>maxOffset || t.height<0 || t.height>maxOffset || t.pyramid_level<0 || t.pyramid_level>std::numeric_limits<uint8_t>::max()){
+        throw std::out_of_range("Template too big to be packed");
+      }
+      for(const auto& f : t.features){
+        if(f.x<0 || f.x>maxOffset || f.y<0 || f.y>maxOffset || f.label<0 || f.label>7){
+          throw std::out_of_range("Template feature out of range");
+        }
+      }
+    }
+
+    const int templateID=size();
+    for(const auto& t : pyramid){
+      if(size_t(t.pyramid_level)>=_levels.size()){
+        _levels.resize(t.pyramid_level+1);
+      }
+      Level& level=_levels[t.pyramid_level];
+      _headers.push_back({uint16_t(t.width), uint16_t(t.height), uint8_t(t.pyramid_level), uint32_t(level.x.size()), uint32_t(t.features.size())});
+      for(const auto& f : t.features){
+        level.x.push_back(f.x);
+        level.y.push_back(f.y);
+        level.label.push_back(f.label);
+      }
+    }
+    return templateID;
+  }
+
+  int PackedTemplates::size() const {
+    return _perPyramid==0 ? 0 : _headers.size()/_perPyramid;
+  }
+
+  std::vector<cv::linemod::Template> PackedTemplates::get(int templateID) const {
+    if(templateID<0 || templateID>=size()){
+      throw std::out_of_range("No such template");
+    }
+    std::vector<cv::linemod::Template> result(_perPyramid);
+    for(int i=0; i<_perPyramid; ++i){
+      const Header& h=_headers[size_t(templateID)*_perPyramid+i];
+      const Level& level=_levels[h.level];
+      cv::linemod::Template& t=result[i];
+      t.width=h.width;
+      t.height=h.height;
+      t.pyramid_level=h.level;
+      t.features.reserve(h.size);
+      for(size_t j=h.first; j<h.first+h.size; ++j){
+        t.features.push_back(cv::linemod::Feature(level.x[j], level.y[j], level.label[j]));
+      }
+    }
+    return result;
+  }
+
+  void PackedTemplates::addTo(cv::linemod::Detector& detector, const std::string& classID) const {
+    for(int templateID=0; templateID<size(); ++templateID){
+      detector.addSyntheticTemplate(get(templateID), classID);
+    }
+  }
+
+  void PackedTemplates::shrinkToFit(){
+    _headers.shrink_to_fit();
+    for(auto& level : _levels){
+      level.x.shrink_to_fit();
+      level.y.shrink_to_fit();
+      level.label.shrink_to_fit();
+    }
+  }
+
+  size_t PackedTemplates::memoryUsage() const {
+    size_t result=_headers.capacity()*sizeof(Header);
+    for(const auto& level : _levels){
+      result+=level.x.capacity()*sizeof(uint16_t)+level.y.capacity()*sizeof(uint16_t)+level.label.capacity()*sizeof(uint8_t);
+    }
+    return result;
+  }
+
+  size_t PackedTemplates::unpackedMemoryUsage() const {
+    size_t nFeatures=0;
+    for(const auto& level : _levels){
+      nFeatures+=level.x.size();
+    }
+    return nFeatures*sizeof(cv::linemod::Feature)+_headers.size()*sizeof(cv::linemod::Template);
+  }
+}
@@ -1,5 +1,12 @@
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
 #include <fstream>
+#include <future>
+#include <map>
+#include <mutex>
 #include <stdexcept>
+#include <thread>
 #include <Parser/RobotData.h>
 #include <Recognition/Renderer3d.h>
 #include <Camera/ImageViewer.h>
@@ -8,10 +15,118 @@
 //#include <Eigen/Matrix>
 #include <opencv2/opencv.hpp>
 #include <Recognition/RecognitionData.h>
+#include <Recognition/RecognizeBalls.h>
+#include <Camera/CameraModel.h>
 
 namespace Recognition{
   C5G::Pose recognizeBalls(int row, int column);
 
+  namespace{
+    /** Recognizes the photos of both cameras together. RecognitionData renders, so it lives on a thread of its own
+     * owning its GL context: the recognition tasks of the bins queue their photos to it and wait for the result.
+     * Never destroyed, as the other singletons: the thread waits for requests until exit.
+     */
+    class StereoRecognizer{
+      public:
+        StereoRecognizer(const std::string& trainPath, const Camera::CameraModel& left, const Camera::CameraModel& right)
+          :
+            _left(left),
+            _right(right)
+        {
+          std::promise<void> ready;
+          auto loaded=ready.get_future();
+          _thread=std::thread(&StereoRecognizer::run, this, trainPath, std::move(ready));
+          try{
+            loaded.get();
+          }
+          catch(...){
+            _thread.join();
+            throw;
+          }
+        }
+
+        /** Poses of the objects found, relative to the left camera as the poses of the bins, the most reliable first */
+        std::map<std::string, std::vector<C5G::Pose>> recognize(const Img::Image& left, const Img::Image& right, const std::vector<std::string>& what){
+          std::packaged_task<RecognitionData::ObjectMatches(RecognitionData&)> request([&] (RecognitionData& data) {
+              std::vector<std::string> known;
+              for(const auto& x : what){
+                if(data.hasModel(x) && std::find(known.begin(), known.end(), x)==known.end()){
+                  known.push_back(x);
+                }
+              }
+              /** Match on the whole images */
+              Img::ImageWMask leftFrame(left, Img::Image::Matrix(left.rgb.size(), CV_8UC1, cv::Scalar{255}));
+              Img::ImageWMask rightFrame(right, Img::Image::Matrix(right.rgb.size(), CV_8UC1, cv::Scalar{255}));
+              /** The Kinects register the depth onto the RGB */
+              std::vector<RecognitionData::View> views{{leftFrame, leftFrame, _left, _left}, {rightFrame, rightFrame, _right, _right}};
+              return data.recognize(views, known);
+              });
+          auto matches=request.get_future();
+          {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _requests.push_back(std::move(request));
+          }
+          _changed.notify_one();
+
+          const Eigen::Affine3d worldToLeft=_left.getExtrinsic().cast<double>();
+          std::map<std::string, std::vector<C5G::Pose>> result;
+          for(const auto& x : matches.get()){
+            for(const auto& m : x.second){
+              result[x.first].push_back(C5G::Pose::transform2Pose(worldToLeft*m.pose));
+            }
+          }
+          return result;
+        }
+
+      private:
+        StereoRecognizer(const StereoRecognizer&)=delete;
+        void operator=(const StereoRecognizer&)=delete;
+
+        void run(const std::string& trainPath, std::promise<void> ready){
+          std::unique_ptr<RecognitionData> data;
+          try{
+            data.reset(new RecognitionData(trainPath, _left));
+            ready.set_value();
+          }
+          catch(...){
+            ready.set_exception(std::current_exception());
+            return;
+          }
+          std::unique_lock<std::mutex> lock(_mutex);
+          while(true){
+            _changed.wait(lock, [this] () { return !_requests.empty(); });
+            auto request=std::move(_requests.front());
+            _requests.pop_front();
+            lock.unlock();
+            request(*data);
+            lock.lock();
+          }
+        }
+
+        const Camera::CameraModel _left;
+        const Camera::CameraModel _right;
+        std::mutex _mutex;
+        std::condition_variable _changed;
+        std::deque<std::packaged_task<RecognitionData::ObjectMatches(RecognitionData&)>> _requests;
+        std::thread _thread;
+    };
+
+    /** Null unless setStereoRecognition has been called */
+    StereoRecognizer*& stereoRecognizer(){
+      static StereoRecognizer* instance=nullptr;
+      return instance;
+    }
+  }
+
+  void setStereoRecognition(const std::string& trainPath, const std::string& camerasFile){
+    cv::FileStorage cameras(camerasFile, cv::FileStorage::READ);
+    if(!cameras.isOpened()){
+      throw std::runtime_error("Couldn't open "+camerasFile);
+    }
+    Camera::CameraModel left=Camera::CameraModel::readFrom(cameras["left"]);
+    Camera::CameraModel right=Camera::CameraModel::readFrom(cameras["right"]);
+    stereoRecognizer()=new StereoRecognizer(trainPath, left, right);
+  }
 
 
   void updateGiorgio(int row, int column){
@@ -22,51 +137,90 @@ namespace Recognition{
     dovesono["kygen_squeakin_eggs_plush_puppies"]=C5G::Pose({1.20,0.30, 0.30,0,0,0});
     using InterProcessCommunication::RobotData;
     RobotData& r=RobotData::getInstance();
-    for(int i=0; i<RobotData::MAX_ITEM_N; ++i){
-      std::string name =r.getBinItem(row, column, i);
-      if(name==""){
-        continue;
-      }
-      //if(name=="kygen_squeakin_eggs_plush_puppies"){
-      //  std::cout << "Searching for a ball..\n";
-      //  auto thePose=recognizeBalls(row, column);
-      //  //SUGGESTION: draw object skeleton
-      //  r.setObjPose(row, column, i, thePose);
-      //  std::cout << "Done. Ball pose: " << r.getObjPose(row, column, i) << "\n";
-      //} 
-//      else if(name=="genuine_joe_plastic_stir_sticks" || name=="highland_6539_self_stick_notes" || name=="paper_mate_12_count_mirado_black_warrior"){
-//        auto thePose=RecognitionData::getInstance().recognize(r.getFrame(row, column), name);
-//      }
-      else {
-
-        try{
-          auto thePose=dovesono.at(name);
-          r.setObjPose(row,column,i,thePose);
-        }
-        catch(std::out_of_range sc){
-          /** Everything else shall be recognized by hand */
-          std::cout << "I'm sorry baby, you have to take it by urself\n";
-          r.setObjPose(row, column, i, {-10000, 0, 0, 0, 0, 0});
-        }
 
+    /** Poses found into the photos of both cameras, if the bin has them: the other objects are taken from the table */
+    std::map<std::string, std::vector<C5G::Pose>> found;
+    auto photographed=r.getBin(row, column);
+    if(stereoRecognizer() && photographed->rightPhoto){
+      std::vector<std::string> names;
+      for(const auto& name : photographed->object){
+        if(name!=""){
+          names.push_back(name);
+        }
+      }
+      try{
+        found=stereoRecognizer()->recognize(*photographed->photo, *photographed->rightPhoto, names);
+      }
+      catch(const std::exception& e){
+        std::cout << "Recognition of bin " << row << "," << column << " failed: " << e.what() << "\n";
       }
-      r.demoViewer.showImage(r.getPhoto(row,column));
-      r.demoViewer.setTitle("Pose is: _____");
     }
-    r.setDirty(row, column, false);
+    /** Items of the same object take its poses in order */
+    std::map<std::string, size_t> taken;
+
+    /** Readers see all the poses of the bin updated at once */
+    r.updateBin(row, column, [&dovesono, &found, &taken] (RobotData::Bin& bin) {
+        for(int i=0; i<RobotData::MAX_ITEM_N; ++i){
+          std::string name=bin.object[i];
+          if(name==""){
+            continue;
+          }
+          //if(name=="kygen_squeakin_eggs_plush_puppies"){
+          //  std::cout << "Searching for a ball..\n";
+          //  auto thePose=recognizeBalls(row, column);
+          //  //SUGGESTION: draw object skeleton
+          //  bin.objPose[i]=thePose;
+          //  std::cout << "Done. Ball pose: " << bin.objPose[i] << "\n";
+          //} 
+//          else if(name=="genuine_joe_plastic_stir_sticks" || name=="highland_6539_self_stick_notes" || name=="paper_mate_12_count_mirado_black_warrior"){
+//            auto thePose=RecognitionData::getInstance().recognize(*bin.photo, name);
+//          }
+          else {
+            auto poses=found.find(name);
+            if(poses!=found.end() && taken[name]<poses->second.size()){
+              bin.objPose[i]=poses->second[taken[name]++];
+              continue;
+            }
+
+            try{
+              bin.objPose[i]=dovesono.at(name);
+            }
+            catch(std::out_of_range sc){
+              /** Everything else shall be recognized by hand */
+              std::cout << "I'm sorry baby, you have to take it by urself\n";
+              bin.objPose[i]={-10000, 0, 0, 0, 0, 0};
+            }
+
+          }
+        }
+        bin.dirty=false;
+        });
+    r.demoViewer.showImage(*r.getPhoto(row,column));
+    r.demoViewer.setTitle("Pose is: _____");
   }
 
 
   C5G::Pose recognizeBalls(int row, int column){
     using InterProcessCommunication::RobotData;
+    static const Camera::CameraModel cam=[] () {
+      cv::FileStorage cameraFile("./camera_data.yml", cv::FileStorage::READ);
+      if(!cameraFile.isOpened()){
+        throw std::runtime_error("Couldn't open ./camera_data.yml");
+      }
+      return Camera::CameraModel::readFrom(cameraFile["camera_model"]);
+    }();
+
     RobotData& r=RobotData::getInstance();
-    Img::Image p=r.getFrame(row, column);
-    cv::imwrite("/tmp/myballs.png", p.rgb);
-    system("python ./hopersolepalle.py");
-    double x, y, z, a, b, g;
-    std::ifstream resultFile("/tmp/grasp.pose");
-    resultFile >> x >> y >> z >> a >> b >> g;
-    return C5G::Pose({x,y,z,a,b,g});
+    auto balls=Balls::find(*r.getFrame(row, column), cam);
+    if(balls.empty()){
+      std::cout << "No balls found into bin " << row << "," << column << "\n";
+      return C5G::Pose({-10000, 0, 0, 0, 0, 0});
+    }
+
+    /** The topmost ball is the easiest one to grip */
+    auto best=std::min_element(balls.begin(), balls.end(), [] (const Balls::Ball& a, const Balls::Ball& b) { return a.pixel.y < b.pixel.y; });
+    std::cout << "Found " << balls.size() << " balls, taking the " << best->color << " one at\n" << best->center << "\n";
+    return C5G::Pose({best->center[0], best->center[1], best->center[2], 0, 0, 0});
     /***TODO maybe we shall remove the balls from the image, but for now its'a okay
      *
      */
@@ -1,7 +1,13 @@
+#include <algorithm>
+#include <future>
+#include <set>
 #include <unordered_set>
 #include <stdexcept>
 #include <cmath>
 #include <Recognition/RecognitionData.h>
+#include <Camera/ImageViewer.h>
+#include <Img/FrameArena.h>
+#include <Log/Log.h>
 #include <Eigen/Core>
 #include <Eigen/Geometry>
 #include <opencv2/opencv.hpp>
@@ -30,6 +36,9 @@
 #include <Recognition/ColorGradientPyramidFull.h>
 
 namespace Recognition{
+  namespace{
+    Log::Module& recognitionLog=Log::module("recognition");
+  }
 
   static void turnBlackWhiteToBlueYellow(const cv::Mat& hsv_in, cv::Mat& hsv_out, double ts, double tv){
     using cv::Mat;
@@ -120,99 +129,143 @@ namespace Recognition{
   }
 
   std::vector<RecognitionData::FirstPassFoundItems> RecognitionData::makeAFirstPassRecognition(const cv::Mat& const_rgb, const cv::Mat& depth_m, const cv::Mat& filter_mask, const std::vector<std::string>& whatToSee) const {
+    return makeAFirstPassRecognition(std::vector<FirstPassInput>{{const_rgb, depth_m, filter_mask}}, whatToSee)[0];
+  }
 
-    using cv::Mat;
-    using cv::Rect;
-
-    /** Some checks because you'll never know */
-    assert(filter_mask.depth() == CV_8UC1 && "Filtering mask should be CV_8UC1" );
-    assert(depth_m.type() == CV_32FC1 && "Depth should be CV_32FC1 (in meters)");
-    assert(const_rgb.size()==depth_m.size() && "Inconsistent RGB and depth image provided");
-    assert(const_rgb.size()==filter_mask.size() && "Inconsisten RGB/depth and mask provided");
+  const size_t RecognitionData::MAX_DETECTORS_BYTES=64<<20;
+
+  RecognitionData::DetectorPtr RecognitionData::detectorFor(const std::vector<std::string>& whatToSee) const {
+    const std::set<std::string> objects(whatToSee.begin(), whatToSee.end());
+    std::lock_guard<std::mutex> lock(_detectorsMutex);
+    auto cached=std::find_if(_detectors.begin(), _detectors.end(), [&objects] (const CachedDetector& x) {
+        return x.objects==objects;
+        });
+    if(cached!=_detectors.end()){
+      _detectors.splice(_detectors.begin(), _detectors, cached);
+      return cached->detector;
+    }
 
-    /** The depth_ matrix is given in m, but we want to use it in mm now */
-    Mat depth_mm;
-    depth_m.convertTo(depth_mm, CV_16UC1, 1000.0);
+    std::shared_ptr<Model::Detector> detector(new Model::Detector(*cv::linemod::getFullObjectLINEMOD()));
+    size_t bytes=0;
+    for(const auto& object_id_ : objects){
+      const Model& model=_objectModels.at(object_id_);
+      model.addAllTemplates(*detector);
+      bytes+=model.detectorMemoryUsage();
+    }
+    if(bytes>MAX_DETECTORS_BYTES){
+      return detector;
+    }
+    _detectors.push_front(CachedDetector{objects, detector, bytes});
+    _detectorsBytes+=bytes;
+    while(_detectorsBytes>MAX_DETECTORS_BYTES){
+      _detectorsBytes-=_detectors.back().bytes;
+      _detectors.pop_back();
+    }
+    return detector;
+  }
 
-    /** Build inputs for Line-MOD */
-    Mat rgb=const_rgb.clone();
-    std::vector<Mat> sources;
-    sources.push_back(rgb);
-    sources.push_back(depth_mm);
+  std::vector<std::vector<RecognitionData::FirstPassFoundItems>> RecognitionData::makeAFirstPassRecognition(const std::vector<FirstPassInput>& views, const std::vector<std::string>& whatToSee) const {
 
-    std::vector<Mat> theMasks;
-    theMasks.push_back(filter_mask);
-    theMasks.push_back(filter_mask);
+    using cv::Mat;
+    using cv::Rect;
 
+    const size_t nViews=views.size();
+    std::vector<std::vector<Mat>> sources(nViews), theMasks(nViews);
+    for(size_t v=0; v<nViews; ++v){
+      const Mat& const_rgb=views[v].rgb;
+      const Mat& depth_m=views[v].depth;
+      const Mat& filter_mask=views[v].mask;
+
+      /** Some checks because you'll never know */
+      assert(filter_mask.depth() == CV_8UC1 && "Filtering mask should be CV_8UC1" );
+      assert(depth_m.type() == CV_32FC1 && "Depth should be CV_32FC1 (in meters)");
+      assert(const_rgb.size()==depth_m.size() && "Inconsistent RGB and depth image provided");
+      assert(const_rgb.size()==filter_mask.size() && "Inconsisten RGB/depth and mask provided");
+
+      /** The depth_ matrix is given in m, but we want to use it in mm now */
+      Mat depth_mm;
+      depth_m.convertTo(depth_mm, CV_16UC1, 1000.0);
+
+      /** Build inputs for Line-MOD */
+      sources[v].push_back(const_rgb.clone());
+      sources[v].push_back(depth_mm);
+
+      theMasks[v].push_back(filter_mask);
+      theMasks[v].push_back(filter_mask);
+    }
 
-    /** Here we will save all matching parts */
-    std::vector<FirstPassFoundItems> found;
+    /** Here we will save all matching parts, view by view */
+    std::vector<std::vector<FirstPassFoundItems>> found(nViews);
     /** To avoid re-evaluating the same match in different steps */
-    std::unordered_set<cv::linemod::Match> foundMatches;
-    /** Here we flag each object into the list to see what we encountered so far */
+    std::vector<std::unordered_set<cv::linemod::Match>> foundMatches(nViews);
 
-    /** Create LINE-MOD detector with templates built from the object */
+    /** LINE-MOD detector with every object which has to be found: it doesn't change with the threshold */
+    const DetectorPtr detector=detectorFor(whatToSee);
 
     double currentThreshold=_threshold;
     while(1){
-      /** Fill an object list with every object which has not been found (or is not valid) so far */
-      std::map<std::string, bool> iHaveFound;
-      for(const auto& x : whatToSee){
-        iHaveFound[x]=false;
-      }
-      for(const auto& x : found){
-        iHaveFound.at(x.match.class_id)=true;
-      }
-      std::vector<std::string> whatsMissing;
-      for(const auto& x:whatToSee){
-        if(!iHaveFound.at(x)){
-          whatsMissing.push_back(x);
+      /** Fill a list with every view where some object has not been found (or is not valid) so far */
+      std::vector<size_t> searching;
+      for(size_t v=0; v<nViews; ++v){
+        std::set<std::string> iHaveFound;
+        for(const auto& x : found[v]){
+          iHaveFound.insert(x.match.class_id);
+        }
+        for(const auto& x : whatToSee){
+          if(!iHaveFound.count(x)){
+            searching.push_back(v);
+            break;
+          }
         }
       }
-      if(whatsMissing.empty()){
+      if(searching.empty()){
         /** Everything was fine :) */
         break;
       }
 
-      /** Create detector with every object which has to be found */
-      /*** TODO TODO TODO TODO TODO Change this */
-      std::unique_ptr<Model::Detector> detector (new Model::Detector(*cv::linemod::getFullObjectLINEMOD()));
-      for(auto& object_id_ : whatToSee){
-        _objectModels.at(object_id_).addAllTemplates(*detector);
+      /** Search for every object now: matching needs no GL, so the views are matched in parallel */
+      const auto policy=searching.size()>1 ? std::launch::async : std::launch::deferred;
+      std::vector<std::future<std::vector<cv::linemod::Match>>> matching;
+      for(size_t v : searching){
+        matching.push_back(std::async(policy, [&, v] () {
+              Img::FrameArena::Scope frameMemory;
+              std::vector<cv::linemod::Match> matches;
+              detector->match(sources[v], currentThreshold, matches, whatToSee, cv::noArray(), theMasks[v]);
+              return matches;
+              }));
       }
 
-      /** Search for every object now */
-      size_t nDone=0;
-      std::vector<cv::linemod::Match> matches;
-      detector->match(sources, currentThreshold, matches,whatToSee, cv::noArray(), theMasks);
+      /** Now, filter until something good is found for every object: this renders, so it stays on this thread */
+      for(size_t k=0; k<searching.size(); ++k){
+        const size_t v=searching[k];
+        const Mat& const_rgb=views[v].rgb;
+        for(const auto& match : matching[k].get()) {
 
-      /** Now, filter until something good is found for every object */
-      for(const auto& match : matches) {
+          using Eigen::Affine3d;
 
-        using Eigen::Affine3d;
-
-        /** Skip already evaluated matches */
-        if(foundMatches.find(match)!=foundMatches.end()){
-          continue;
-        }
-        foundMatches.insert(match);
-
-        const auto& obj=_objectModels.at(match.class_id);
-
-        /** Renders the match to check for hue correctness (drops some false positives) */
-        Mat rgb, d, m;
-        Rect section;
-        auto mPose=obj.matchToObjectPose(match);
-        obj.render(mPose, rgb, d, m, section);
-        assert(!rgb.empty());
-        const Mat matchingPart=const_rgb(section);
-        assert(matchingPart.size()==rgb.size() && "Non coherent rgb and mask output from render");
-        size_t matchingArea;
-        double percentage=matchingHuePercentage(rgb, matchingPart, m, section.size(), 0.1,30,1, matchingArea);
-        if(percentage < 0.6) {
-          continue;
+          /** Skip already evaluated matches */
+          if(foundMatches[v].find(match)!=foundMatches[v].end()){
+            continue;
+          }
+          foundMatches[v].insert(match);
+
+          const auto& obj=_objectModels.at(match.class_id);
+
+          /** Renders the match to check for hue correctness (drops some false positives) */
+          Mat rgb, d, m;
+          Rect section;
+          auto mPose=obj.matchToObjectPose(match);
+          obj.render(mPose, rgb, d, m, section);
+          assert(!rgb.empty());
+          const Mat matchingPart=const_rgb(section);
+          assert(matchingPart.size()==rgb.size() && "Non coherent rgb and mask output from render");
+          size_t matchingArea;
+          double percentage=matchingHuePercentage(rgb, matchingPart, m, section.size(), 0.1,30,1, matchingArea);
+          if(percentage < 0.6) {
+            continue;
+          }
+          found[v].push_back({match, mPose, rgb, d, m, section, percentage});
         }
-        found.push_back({match, mPose, rgb, d, m, section, percentage});
       }
       currentThreshold *= 0.9;
       if(currentThreshold < 0.8){
@@ -223,108 +276,202 @@ namespace Recognition{
   }
 
   bool RecognitionData::updateGiorgio(const Img::ImageWMask& sceneImg, const Img::ImageWMask& precisionImg, const Camera::CameraModel& depthCam,                                ObjectMatches& result, const std::vector<std::string>& vect_objs_to_pick) const
+  {
+    /** TODO remove me when multiple objects are considered */
+    assert(vect_objs_to_pick.size()==1);
+
+    result=recognizeViews({{&sceneImg, &precisionImg, nullptr, &depthCam}}, vect_objs_to_pick)[0];
+    return true;
+  }
+
+  std::vector<RecognitionData::ObjectMatches> RecognitionData::recognizeViews(const std::vector<ViewInput>& views, const std::vector<std::string>& vect_objs_to_pick) const
   {
 
     using cv::Rect;
     using cv::Mat;
-
-    /** TODO remove me when multiple objects are considered */
-    assert(vect_objs_to_pick.size()==1);
+    typedef pcl::PointXYZRGB PointType;
+    typedef pcl::PointCloud<PointType> Cloud;
 
     /** First of all, we match with decreasing thresholds until at least 1 not-so-badly-matching templates has been found for each object */
-    auto found=makeAFirstPassRecognition(sceneImg.rgb, sceneImg.depth, sceneImg.mask, vect_objs_to_pick);
-
-    /** Now we will construct, for each match, the corresponding point cloud. We then apply ICP in order to refine the pose estimation and drop other false positives */
-    result=ObjectMatches{};
-    /** Scan each item and align it */
-    for(const auto& x:found){
-      /** Obtain the match's original image */
-      const auto& obj=_objectModels.at(x.match.class_id);
-      /** First, build the PC of the whole scene on which the template must be aligned */
-      typedef pcl::PointXYZRGB PointType;
-      typedef pcl::PointCloud<PointType> Cloud;
-      /** This Pointcloud is built in global coordinates using the informations from the depth camera */
-      Cloud::Ptr scenePC(new Cloud);
-      {
-        auto scenePCNotRegular=depthCam.sceneToCameraPointCloud(precisionImg.rgb, precisionImg.depth, precisionImg.mask);
-        scenePCNotRegular->is_dense=true;
-        std::vector<int> dumbIgnoredValue;
-        pcl::removeNaNFromPointCloud(*scenePCNotRegular, *scenePCNotRegular, dumbIgnoredValue);
-        pcl::VoxelGrid<PointType> sceneVox;
-        sceneVox.setInputCloud (scenePCNotRegular);
-        sceneVox.setLeafSize (0.005f, 0.005f, 0.005f);
-        sceneVox.filter (*scenePC);
-      }
+    std::vector<FirstPassInput> sceneImgs;
+    for(const auto& v : views){
+      sceneImgs.push_back({v.frame->rgb, v.frame->depth, v.frame->mask});
+    }
+    auto found=makeAFirstPassRecognition(sceneImgs, vect_objs_to_pick);
 
-      
-      /** Render the match as it would be if seen by the depth camera */
-      Mat rgb, d,  m;
-      Rect section;
-      auto objGlobalPose=obj.matchToObjectPose(x.match);
+    /** A match rendered as the depth camera would see it, to be aligned */
+    struct Candidate{
+      std::string objectID;
+      Img::ImageWMask matchImage;
       Eigen::Affine3d templateGlobalPose;
-      {
-        std::cout << "Object pose in first camera frame: \n" << objGlobalPose.matrix() << "\n";
-        objGlobalPose=obj.getCam().getExtrinsic().inverse().cast<double>()*objGlobalPose;
-        templateGlobalPose=objGlobalPose.cast<double>();
-        std::cout << "Object pose in global frame: \n" << templateGlobalPose.matrix() << "\n";
-        objGlobalPose=depthCam.getExtrinsic().cast<double>()*objGlobalPose;
-
-        std::cout << "Object pose in camera frame: \n" << objGlobalPose.matrix() << "\n";
-        /*** TODO REMOVE ME when everything is merged correctly */
+    };
+
+    /** Rendering needs the thread owning the GL context: every match of every view is rendered here, before aligning */
+    std::vector<std::vector<Candidate>> candidates(views.size());
+    for(size_t v=0; v<views.size(); ++v){
+      const CameraModel& depthCam=*views[v].depthCamera;
+      for(const auto& x:found[v]){
+        /** Obtain the match's original image */
+        const auto& obj=_objectModels.at(x.match.class_id);
+        /** Views without their own camera were taken by the one the object was trained with */
+        const CameraModel& camera=views[v].camera ? *views[v].camera : obj.getCam();
+
+        /** Render the match as it would be if seen by the depth camera */
+        Mat rgb, d,  m;
+        Rect section;
+        auto objGlobalPose=obj.matchToObjectPose(x.match);
+        Eigen::Affine3d templateGlobalPose;
         {
-          objGlobalPose=Eigen::AngleAxisd(-M_PI, Eigen::Vector3d::UnitX())*objGlobalPose;
+          LOG(recognitionLog, DEBUG) << "Object pose in first camera frame: \n" << objGlobalPose.matrix();
+          objGlobalPose=camera.getExtrinsic().inverse().cast<double>()*objGlobalPose;
+          templateGlobalPose=objGlobalPose.cast<double>();
+          LOG(recognitionLog, DEBUG) << "Object pose in global frame: \n" << templateGlobalPose.matrix();
+          objGlobalPose=depthCam.getExtrinsic().cast<double>()*objGlobalPose;
+
+          LOG(recognitionLog, DEBUG) << "Object pose in camera frame: \n" << objGlobalPose.matrix();
+          /*** TODO REMOVE ME when everything is merged correctly */
+          {
+            objGlobalPose=Eigen::AngleAxisd(-M_PI, Eigen::Vector3d::UnitX())*objGlobalPose;
+          }
+          LOG(recognitionLog, DEBUG) << "Object pose in OpenGL frame: \n" << objGlobalPose.matrix();
+          auto& renderer=Renderer3d::globalRenderer();
+          renderer.set_parameters(depthCam, 0.1, 2.5, "Renderrrringdepth");
+          renderer.setObjectPose(objGlobalPose);
+          renderer.renderDepthOnly(obj.getMesh(), d, m, section);
+          renderer.renderImageOnly(obj.getMesh(), rgb, section);
         }
-        std::cout << "Object pose in OpenGL frame: \n" << objGlobalPose.matrix() << "\n";
-        auto& renderer=Renderer3d::globalRenderer();
-        renderer.set_parameters(depthCam, 0.1, 2.5, "Renderrrringdepth");
-        renderer.setObjectPose(objGlobalPose);
-        renderer.renderDepthOnly(obj.getMesh(), d, m, section);
-        renderer.renderImageOnly(obj.getMesh(), rgb, section);
+        auto matchImage=imageFromRender(rgb,d,m,section,depthCam);
+        static Camera::ImageViewer renderingViewer("Depth theoretical rendering");
+        renderingViewer.showImage(matchImage);
+        candidates[v].push_back({x.match.class_id, matchImage, templateGlobalPose});
       }
-      auto matchImage=imageFromRender(rgb,d,m,section,depthCam);
-      cv::imshow("Depth theoretical rendering", rgb);
-      while((cv::waitKey(100) & 0xFF)!='q');
-      /** Obtain the PCs relative to the parts to be aligned */
-      Cloud::Ptr templatePC(new Cloud);
-      {
-        auto templatePCNotRegular=depthCam.sceneToCameraPointCloud(matchImage.rgb, matchImage.depth, matchImage.mask);
-        templatePCNotRegular->is_dense=true;
-        std::vector<int> dumbIgnoredValue;
-        pcl::removeNaNFromPointCloud(*templatePCNotRegular, *templatePCNotRegular, dumbIgnoredValue);
-
-        Cloud templatePCGlobal;
-        pcl::transformPointCloud(*templatePCNotRegular, templatePCGlobal, depthCam.getExtrinsic().inverse());
-        /* Create the filtering object: downsample the dataset using a leaf size of 1cm */
-        pcl::VoxelGrid<PointType> templateVox;
-        templateVox.setInputCloud (templatePCNotRegular);
-        templateVox.setLeafSize (0.005f, 0.005f, 0.005f);
-        templateVox.filter (*templatePC);
+    }
+
+    /** Now we will construct, for each match, the corresponding point cloud. We then apply ICP in order to refine the pose estimation and drop other false positives: no GL is needed anymore, so the views are aligned in parallel */
+    const auto policy=views.size()>1 ? std::launch::async : std::launch::deferred;
+    std::vector<std::future<ObjectMatches>> aligning;
+    for(size_t v=0; v<views.size(); ++v){
+      aligning.push_back(std::async(policy, [&, v] () {
+            Img::FrameArena::Scope frameMemory;
+            const CameraModel& depthCam=*views[v].depthCamera;
+            const Img::ImageWMask& precisionImg=*views[v].depthFrame;
+            ObjectMatches result;
+
+            /** First, build the PC of the whole scene on which the templates must be aligned */
+            /** This Pointcloud is built in global coordinates using the informations from the depth camera */
+            Cloud::Ptr scenePC(new Cloud);
+            {
+              auto scenePCNotRegular=depthCam.sceneToCameraPointCloud(precisionImg.rgb, precisionImg.depth, precisionImg.mask);
+              scenePCNotRegular->is_dense=true;
+              std::vector<int> dumbIgnoredValue;
+              pcl::removeNaNFromPointCloud(*scenePCNotRegular, *scenePCNotRegular, dumbIgnoredValue);
+              pcl::VoxelGrid<PointType> sceneVox;
+              sceneVox.setInputCloud (scenePCNotRegular);
+              sceneVox.setLeafSize (0.005f, 0.005f, 0.005f);
+              sceneVox.filter (*scenePC);
+            }
+
+            /** Scan each item and align it */
+            for(const auto& c : candidates[v]){
+              const auto& matchImage=c.matchImage;
+              /** Obtain the PCs relative to the parts to be aligned */
+              Cloud::Ptr templatePC(new Cloud);
+              {
+                auto templatePCNotRegular=depthCam.sceneToCameraPointCloud(matchImage.rgb, matchImage.depth, matchImage.mask);
+                templatePCNotRegular->is_dense=true;
+                std::vector<int> dumbIgnoredValue;
+                pcl::removeNaNFromPointCloud(*templatePCNotRegular, *templatePCNotRegular, dumbIgnoredValue);
+
+                Cloud templatePCGlobal;
+                pcl::transformPointCloud(*templatePCNotRegular, templatePCGlobal, depthCam.getExtrinsic().inverse());
+                /* Create the filtering object: downsample the dataset using a leaf size of 1cm */
+                pcl::VoxelGrid<PointType> templateVox;
+                templateVox.setInputCloud (templatePCNotRegular);
+                templateVox.setLeafSize (0.005f, 0.005f, 0.005f);
+                templateVox.filter (*templatePC);
+              }
+              /** Use ICP to refine the pose estimation of the object */
+              pcl::IterativeClosestPoint<PointType, PointType> icp;
+              icp.setMaximumIterations (100);
+              icp.setInputSource (templatePC);//Model
+              icp.setInputTarget (scenePC);//Ref scene
+              Cloud::Ptr finalModelCloudPtr(new Cloud);
+              icp.align (*finalModelCloudPtr);
+              if(!icp.hasConverged()){
+                continue;
+              }
+              if(icp.getFitnessScore()>0.001){
+                continue;
+              }
+              Eigen::Affine3d finalTransformationMatrix{icp.getFinalTransformation().cast<double>()};
+              /** The correction is between clouds in the frame of the depth camera: it is brought into the world frame,
+               * as the pose, so that views from cameras placed elsewhere agree
+               */
+              const Eigen::Affine3d toCamera=depthCam.getExtrinsic().cast<double>();
+              auto finalPose = toCamera.inverse()*finalTransformationMatrix*toCamera*c.templateGlobalPose;
+              result[c.objectID].push_back({icp.getFitnessScore(), finalPose});
+            }
+
+            for(auto& x : vect_objs_to_pick){
+              std::sort(result[x].begin(), result[x].end(),
+                        [](const Match& a, const Match& b) -> bool{
+                          return (a.matchScore < b.matchScore);
+                        });
+            }
+            return result;
+            }));
+    }
+
+    std::vector<ObjectMatches> results;
+    for(auto& a : aligning){
+      results.push_back(a.get());
+    }
+    return results;
+  }
+
+  RecognitionData::ObjectMatches RecognitionData::fuse(const std::vector<ObjectMatches>& views) const {
+    /** An item, represented by its best fit, and the views it was found into */
+    struct Item{
+      Match best;
+      std::set<size_t> views;
+    };
+
+    ObjectMatches result;
+    std::map<std::string, std::vector<std::pair<Match, size_t>>> hypotheses;
+    for(size_t v=0; v<views.size(); ++v){
+      for(const auto& object : views[v]){
+        for(const auto& m : object.second){
+          hypotheses[object.first].push_back(std::make_pair(m, v));
+        }
       }
-      /** Use ICP to refine the pose estimation of the object */
-      pcl::IterativeClosestPoint<PointType, PointType> icp;
-      icp.setMaximumIterations (100);
-      icp.setInputSource (templatePC);//Model
-      icp.setInputTarget (scenePC);//Ref scene
-      Cloud::Ptr finalModelCloudPtr(new Cloud);
-      icp.align (*finalModelCloudPtr);
-      if(!icp.hasConverged()){
-        continue;
+    }
+    for(auto& h : hypotheses){
+      /** Best fits first, so that each item gets the best pose of any view */
+      std::stable_sort(h.second.begin(), h.second.end(), [] (const std::pair<Match, size_t>& a, const std::pair<Match, size_t>& b) {
+          return a.first.matchScore < b.first.matchScore;
+          });
+      std::vector<Item> items;
+      for(const auto& x : h.second){
+        auto same=std::find_if(items.begin(), items.end(), [&] (const Item& i) {
+            return (i.best.pose.translation()-x.first.pose.translation()).norm() < th_obj_dist_;
+            });
+        if(same==items.end()){
+          items.push_back(Item{x.first, {x.second}});
+        }
+        else{
+          same->views.insert(x.second);
+        }
       }
-      if(icp.getFitnessScore()>0.001){
-        continue;
+      /** Items confirmed by more views first, by fitness otherwise */
+      std::stable_sort(items.begin(), items.end(), [] (const Item& a, const Item& b) {
+          return a.views.size() > b.views.size();
+          });
+      auto& fused=result[h.first];
+      for(const auto& i : items){
+        fused.push_back(i.best);
       }
-      Eigen::Affine3d finalTransformationMatrix{icp.getFinalTransformation().cast<double>()};
-      auto finalPose = finalTransformationMatrix*templateGlobalPose;
-      result[x.match.class_id].push_back({icp.getFitnessScore(), finalPose});
     }
-
-    for(auto& x : vect_objs_to_pick){
-      std::sort(result[x].begin(), result[x].end(),
-                [](const Match& a, const Match& b) -> bool{
-                  return (a.matchScore < b.matchScore);
-                });
-    }
-    return true;
+    return result;
   }
 
   RecognitionData::RecognitionData(const std::string& trainPath, const CameraModel& m)
@@ -333,7 +480,8 @@ namespace Recognition{
     objsfolder_path(trainPath),
     px_match_min_(0.05),
     th_obj_dist_(0.04f), //"th_obj_dist", "Threshold on minimal distance between detected objects.", 0.04f);
-    _threshold(91.0f)
+    _threshold(91.0f),
+    _detectorsBytes(0)
   {
 
     cv::Mat depth_meters, depth_gray, rgb_img;
@@ -389,6 +537,8 @@ namespace Recognition{
   }
 
   RecognitionData::ObjectMatches RecognitionData::recognize(const Img::ImageWMask& frame, const Img::ImageWMask& depthFrame, const Camera::CameraModel& depthCam, const std::vector<std::string>& what){
+    /** All the matrices made while recognizing this frame come from the same arena, reused by the next frame */
+    Img::FrameArena::Scope frameMemory;
 
     ObjectMatches result;
     if(!updateGiorgio(frame, depthFrame, depthCam, result, what)){
@@ -397,6 +547,22 @@ namespace Recognition{
     return result;
   }
 
+  RecognitionData::ObjectMatches RecognitionData::recognize(const std::vector<View>& views, const std::vector<std::string>& what){
+    /** All the matrices made while recognizing these frames come from the same arena, reused by the next ones */
+    Img::FrameArena::Scope frameMemory;
+
+    std::vector<ViewInput> inputs;
+    for(const auto& v : views){
+      inputs.push_back({&v.frame, &v.depthFrame, &v.camera, &v.depthCamera});
+    }
+    ObjectMatches result=fuse(recognizeViews(inputs, what));
+    /** Objects found nowhere are there too, with no match */
+    for(const auto& x : what){
+      result.insert(std::make_pair(x, std::vector<Match>{}));
+    }
+    return result;
+  }
+
   RecognitionData::PCloud::ConstPtr RecognitionData::objectPointCloud(const std::string& objectID, const Eigen::Affine3d& pose) const {
     const Model& m = _objectModels.at(objectID);
     return m.getPointCloud(pose);
@@ -411,4 +577,8 @@ namespace Recognition{
   const Model& RecognitionData::getModel(const std::string& name) const {
     return _objectModels.at(name);
   }
+
+  bool RecognitionData::hasModel(const std::string& name) const {
+    return _objectModels.count(name)>0;
+  }
 }
@@ -0,0 +1,138 @@
+#include <algorithm>
+#include <cmath>
+#include <Eigen/Dense>
+#include <opencv2/imgproc/imgproc.hpp>
+#include <Recognition/RecognizeBalls.h>
+
+namespace Recognition{
+  namespace Balls{
+    namespace{
+      /** Least squares fit of |p-c|^2=r^2, linear in (c, r^2-|c|^2) */
+      bool fitSphere(const std::vector<Eigen::Vector3d>& pts, Eigen::Vector3d& center, double& radius){
+        Eigen::MatrixXd A(pts.size(), 4);
+        Eigen::VectorXd b(pts.size());
+        for(size_t i=0; i<pts.size(); ++i){
+          A.row(i) << 2*pts[i].transpose(), 1;
+          b[i]=pts[i].squaredNorm();
+        }
+        Eigen::Vector4d x=A.colPivHouseholderQr().solve(b);
+        center=x.head<3>();
+        double r2=x[3]+center.squaredNorm();
+        if(!std::isfinite(r2) || r2<=0){
+          return false;
+        }
+        radius=std::sqrt(r2);
+        return true;
+      }
+
+      /** Center of a sphere of known radius: the visible points are (roughly) on the cap facing the camera,
+       * so the center is behind their centroid, along the viewing ray, by the radius minus the depth of the cap.
+       */
+      Eigen::Vector3d centerFromRadius(const std::vector<Eigen::Vector3d>& pts, double radius){
+        Eigen::Vector3d mean=Eigen::Vector3d::Zero();
+        for(const auto& p : pts){
+          mean+=p;
+        }
+        mean/=pts.size();
+        /** Mean depth of a spherical cap seen from far away is r/3 from the apex */
+        return mean+mean.normalized()*(radius*2.0/3.0);
+      }
+    }
+
+    Params::Params()
+      :
+        minArea(100),
+        maxCircleError(0.05),
+        radius(0),
+        minPoints(20)
+    {
+    }
+
+    const std::vector<Color>& defaultColors(){
+      static const std::vector<Color> colors{
+        {"blue", cv::Scalar(95, 15, 15), cv::Scalar(105, 255, 255)},
+        {"yellow", cv::Scalar(15, 100, 50), cv::Scalar(25, 255, 255)},
+        {"orange", cv::Scalar(9, 104, 192), cv::Scalar(15, 190, 255)}
+      };
+      return colors;
+    }
+
+    std::vector<Ball> find(const Img::Image& frame, const Camera::CameraModel& cam, const std::vector<Color>& colors, const Params& params){
+      cv::Mat blurred, hsv;
+      cv::blur(frame.rgb, blurred, cv::Size(5, 5));
+      cv::cvtColor(blurred, hsv, CV_BGR2HSV);
+
+      const Eigen::Affine3d extrinsic=cam.getExtrinsic().cast<double>();
+      const cv::Mat kernel=cv::getStructuringElement(cv::MORPH_ELLIPSE, cv::Size(3, 3));
+
+      std::vector<Ball> result;
+      cv::Mat mask, blobMask;
+      for(const auto& color : colors){
+        cv::inRange(hsv, color.hsvMin, color.hsvMax, mask);
+        cv::morphologyEx(mask, mask, cv::MORPH_OPEN, kernel);
+
+        /** findContours modifies its input */
+        std::vector<std::vector<cv::Point> > contours;
+        cv::findContours(mask.clone(), contours, CV_RETR_EXTERNAL, CV_CHAIN_APPROX_NONE);
+
+        for(size_t c=0; c<contours.size(); ++c){
+          const auto& contour=contours[c];
+          if(cv::contourArea(contour)<params.minArea){
+            continue;
+          }
+
+          /** Discs only */
+          cv::Point2f pixel;
+          float pixelRadius;
+          cv::minEnclosingCircle(contour, pixel, pixelRadius);
+          double error=0;
+          for(const auto& q : contour){
+            double d=pixelRadius-std::hypot(q.x-pixel.x, q.y-pixel.y);
+            error+=d*d;
+          }
+          if(error/contour.size() > params.maxCircleError*pixelRadius*pixelRadius){
+            continue;
+          }
+
+          /** Depth points of the blob, in the camera's frame */
+          blobMask=cv::Mat::zeros(mask.size(), CV_8UC1);
+          cv::drawContours(blobMask, contours, c, cv::Scalar(255), CV_FILLED);
+          cv::Rect box=cv::boundingRect(contour);
+          std::vector<Eigen::Vector3d> pts;
+          for(int v=box.y; v<box.y+box.height; ++v){
+            const uchar* m=blobMask.ptr<uchar>(v);
+            const uchar* colorMask=mask.ptr<uchar>(v);
+            const float* z=frame.depth.ptr<float>(v);
+            for(int u=box.x; u<box.x+box.width; ++u){
+              if(m[u] && colorMask[u] && z[u]>0 && std::isfinite(z[u])){
+                pts.push_back(cam.uvzToCameraFrame(u, v, z[u]));
+              }
+            }
+          }
+          if(pts.size()<params.minPoints){
+            continue;
+          }
+
+          Ball ball;
+          ball.color=color.name;
+          ball.pixel=pixel;
+          ball.pixelRadius=pixelRadius;
+          bool fitted=false;
+          if(params.radius<=0){
+            fitted=fitSphere(pts, ball.center, ball.radius);
+          }
+          if(!fitted){
+            if(params.radius<=0){
+              continue;
+            }
+            ball.radius=params.radius;
+            ball.center=centerFromRadius(pts, params.radius);
+          }
+          ball.center=extrinsic*ball.center;
+          result.push_back(ball);
+        }
+      }
+      return result;
+    }
+  }
+}
@@ -3,8 +3,13 @@
 #include <vector>
 #include <cmath>
 #include <Recognition/SphereSplitter.h>
+#include <Log/Log.h>
 
 namespace Recognition{
+  namespace{
+    Log::Module& splitterLog=Log::module("sphere_splitter");
+  }
+
   SphereSplitter::SphereSplitter(unsigned int minimumNPoints){
         std::unordered_set<Vertex> polarV;
 
@@ -27,14 +32,12 @@ namespace Recognition{
 
         std::vector<Face> faces;
 
-        std::cout << "{\n";
         for(auto i: icoV){
-          std::cout << i << "\n";
+          LOG(splitterLog, TRACE) << "Icosahedron vertex: " << i.transpose();
         }
-        std::cout << "}\n";
         auto addV=[&faces, &icoV](int a, int b, int c){
           faces.push_back({icoV[a], icoV[b], icoV[c]});
-          std::cout << "Adding face:\n" << faces.back()[0] << "\n;\n" << faces.back()[1] << "\n;\n" << faces.back()[2] << "\n\n";
+          LOG(splitterLog, TRACE) << "Adding face: " << faces.back()[0].transpose() << "; " << faces.back()[1].transpose() << "; " << faces.back()[2].transpose();
         };
 
         // 5 faces around point 0
@@ -90,26 +93,27 @@ namespace Recognition{
             newFaces.push_back({m02, m12, tri[2]});
             newFaces.push_back({m01, m02, m12});
           }
-          std::cout << "Old: " << faces.size() << "new: " << newFaces.size() << "\n";
+          LOG(splitterLog, DEBUG) << "Old: " << faces.size() << " new: " << newFaces.size();
           assert(newFaces.size()>faces.size());
           faces=newFaces;
 
           /** Next suddivision increased by a factor of 4 # of vertices (except for top and bottom)*/
           nVertex=(nVertex-2)*4+2;
         }
-        std::cout << "NFaces: " << faces.size() << "\n";
+        LOG(splitterLog, DEBUG) << "NFaces: " << faces.size();
 
         /* Done, now add vertex to our set 
          * Notice that, coming from the SAME calculations, we CAN use == operator between floats for our set :) */
-        int i=0, j=0;
+        int i=0;
         for (auto& tri:faces) {
-          std::cout << "inserting " << i << "\n";
+          for(const auto& v : tri){
+            /** Not into the message: it is compiled out along with it */
+            const bool inserted=polarV.insert(v).second;
+            LOG(splitterLog, TRACE) << "Face " << i << (inserted ? ": new vertex " : ": known vertex ") << v.transpose();
+          }
           i++;
-          std::cout << (polarV.insert(tri[0]).second? "Success" : "Nope") << tri[0]<<"\n";
-          std::cout << (polarV.insert(tri[1]).second? "Success" : "Nope") << tri[1]<<"\n";
-          std::cout << (polarV.insert(tri[2]).second? "Success" : "Nope") << tri[2]<<"\n";
         }
-        std::cout << "v: " << polarV.size() << "\n";
+        LOG(splitterLog, DEBUG) << "v: " << polarV.size();
         assert(polarV.size()>=minimumNPoints);
 
         for(auto& v: polarV){
@@ -117,7 +121,7 @@ namespace Recognition{
           myPoints.emplace(cos(lat)*cos(lon), cos(lat)*sin(lon), sin(lat));
           //myPoints.emplace(lat, lon, 0);
         }
-        std::cout << "My points #elements: " << myPoints.size() << "\n";
+        LOG(splitterLog, DEBUG) << "My points #elements: " << myPoints.size();
   }
   const SphereSplitter::UvPoints& SphereSplitter::points() const{
     return myPoints;
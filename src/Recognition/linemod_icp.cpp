@@ -17,6 +17,11 @@
 
 #include <Recognition/linemod_icp.h>
 #include <iostream>
+#include <Log/Log.h>
+
+namespace{
+  Log::Module& icpLog=Log::module("icp");
+}
 
 /** get 3D points out of the image */
 float matToVec(const cv::Mat_<cv::Vec3f> &src_ref, const cv::Mat_<cv::Vec3f> &src_mod, std::vector<cv::Vec3f>& pts_ref, std::vector<cv::Vec3f>& pts_mod)
@@ -115,8 +120,7 @@ float getL2distClouds(const std::vector<cv::Vec3f> &model, const std::vector<cv:
     
   }
 
-   std::cout<<"@L2 dist_mean: "<<dist_mean<<"\n";
-   std::cout<<"@L2 float(nbr_inliers): "<<float(nbr_inliers)<<"\n";
+  LOG(icpLog, TRACE) << "@L2 dist_mean: " << dist_mean << " nbr_inliers: " << nbr_inliers;
   if (counter > 0 )//&& nbr_inliers > 0)
   {
     dist_mean /= float(nbr_inliers);
@@ -210,7 +214,7 @@ float icpCloudToCloud(const std::vector<cv::Vec3f> &pts_ref, std::vector<cv::Vec
     cv::add(T, T_optimal, T);
     //update the rotation matrix
     R = R_optimal * R;
-    std::cout << " @ICP it " << iter << "/" << icp_it_th << " : " << std::fixed << dist_mean << " " << dist_diff << " " << px_inliers_ratio << " " << pts_model.size() << std::endl;
+    LOG(icpLog, DEBUG) << "@ICP it " << iter << "/" << icp_it_th << " : " << std::fixed << dist_mean << " " << dist_diff << " " << px_inliers_ratio << " " << pts_model.size();
   }
 
     //std::cout << " icp " << mode << " " << dist_min << " " << iter << "/" << icp_it_th  << " " << px_inliers_ratio << " " << d_diff << " " << std::endl;
@@ -0,0 +1,85 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <Sim/Clock.h>
+#include <Sim/Timeline.h>
+
+namespace Sim{
+  namespace{
+    typedef std::chrono::steady_clock RealClock;
+    const RealClock::time_point EPOCH=RealClock::now();
+    std::atomic<bool> virtualTime(false);
+
+    double realNow(){
+      return std::chrono::duration<double>(RealClock::now()-EPOCH).count();
+    }
+
+    /** The virtual time of the thread was base when its real time was ref */
+    struct ThreadTime{
+      bool started;
+      double base;
+      double ref;
+    };
+    thread_local ThreadTime self={false, 0, 0};
+
+    ThreadTime& threadTime(){
+      if(!self.started){
+        /** Threads start from the real time, as if the clock had always been virtual */
+        self.started=true;
+        self.base=self.ref=realNow();
+      }
+      return self;
+    }
+  }
+
+  void Clock::setVirtual(bool isVirtual){
+    virtualTime=isVirtual;
+  }
+
+  bool Clock::isVirtual(){
+    return virtualTime;
+  }
+
+  double Clock::now(){
+    if(!virtualTime){
+      return realNow();
+    }
+    const ThreadTime& t=threadTime();
+    return t.base+(realNow()-t.ref);
+  }
+
+  void Clock::waitUntil(double t, const char* what){
+    if(!virtualTime){
+      return;
+    }
+    const double current=now();
+    if(t>current){
+      startAt(t);
+      Timeline::getInstance().charge(what, t-current);
+    }
+  }
+
+  void Clock::startAt(double t){
+    if(!virtualTime){
+      return;
+    }
+    ThreadTime& self=threadTime();
+    self.base=t;
+    self.ref=realNow();
+  }
+
+  Clock::Excluded::Excluded()
+    :
+      _start(realNow())
+  {
+  }
+
+  Clock::Excluded::~Excluded(){
+    if(!virtualTime){
+      return;
+    }
+    ThreadTime& self=threadTime();
+    /** If the thread jumped meanwhile, the real time before the jump has already been dropped */
+    self.ref+=realNow()-std::max(_start, self.ref);
+  }
+}
@@ -0,0 +1,26 @@
+#include <algorithm>
+#include <cmath>
+#include <Sim/Motion.h>
+
+namespace Sim{
+  double trapezoidTime(double distance, double maxSpeed, double maxAcceleration, double entrySpeed, double& exitSpeed){
+    const double d=distance, v=maxSpeed, a=maxAcceleration, v0=entrySpeed;
+    /** Not even accelerating for the whole segment the exit speed is reached */
+    double reachable=std::sqrt(v0*v0+2*a*d);
+    if(reachable<=exitSpeed){
+      exitSpeed=reachable;
+      return (exitSpeed-v0)/a;
+    }
+    double accelDistance=(v*v-v0*v0)/(2*a);
+    double decelDistance=(v*v-exitSpeed*exitSpeed)/(2*a);
+    if(accelDistance+decelDistance<=d){
+      return (v-v0)/a+(v-exitSpeed)/a+(d-accelDistance-decelDistance)/v;
+    }
+    /** No cruise: accelerate up to peak, then decelerate (the robot would have slowed down earlier if entering too fast) */
+    double peak=std::sqrt((2*a*d+v0*v0+exitSpeed*exitSpeed)/2);
+    if(peak<std::max(v0, exitSpeed)){
+      return d>0 ? 2*d/(v0+exitSpeed) : 0;
+    }
+    return (peak-v0)/a+(peak-exitSpeed)/a;
+  }
+}
@@ -0,0 +1,73 @@
+#include <iostream>
+#include <stdexcept>
+#include <opencv2/core/core.hpp>
+#include <Sim/Params.h>
+
+namespace Sim{
+  const std::string Params::FILE="simulation.yml";
+
+  namespace{
+    template<typename T>
+    void readOptional(const cv::FileNode& node, const std::string& name, T& x){
+      if(!node[name].empty()){
+        node[name] >> x;
+      }
+    }
+
+    Eigen::Affine3d readPose(const cv::FileNode& node){
+      std::vector<double> v;
+      node >> v;
+      if(v.size()!=6){
+        throw std::runtime_error("Poses of the simulated scene are x, y, z, alpha, beta, gamma");
+      }
+      /** Same convention as C5G::Pose */
+      return Eigen::Translation3d(v[0], v[1], v[2])*Eigen::AngleAxisd(v[3], Eigen::Vector3d::UnitX())*Eigen::AngleAxisd(v[4], Eigen::Vector3d::UnitY())*Eigen::AngleAxisd(v[5], Eigen::Vector3d::UnitZ());
+    }
+  }
+
+  Params::Params()
+    :
+      maxSpeed(0.5),
+      maxAcceleration(1.0),
+      maxAngularSpeed(1.0),
+      maxAngularAcceleration(2.0),
+      gripperTime(0.5),
+      photoTime(0.1),
+      fx(525),
+      fy(525),
+      cx(319.5),
+      cy(239.5),
+      subsampling(4)
+  {
+    cv::FileStorage fs(FILE, cv::FileStorage::READ);
+    if(!fs.isOpened()){
+      std::cout << "No " << FILE << ", simulating with the default parameters\n";
+      return;
+    }
+    cv::FileNode sim=fs["simulation"];
+    cv::FileNode robot=sim["robot"];
+    readOptional(robot, "maxSpeed", maxSpeed);
+    readOptional(robot, "maxAcceleration", maxAcceleration);
+    readOptional(robot, "maxAngularSpeed", maxAngularSpeed);
+    readOptional(robot, "maxAngularAcceleration", maxAngularAcceleration);
+    readOptional(robot, "gripperTime", gripperTime);
+    cv::FileNode camera=sim["camera"];
+    readOptional(camera, "photoTime", photoTime);
+    readOptional(camera, "fx", fx);
+    readOptional(camera, "fy", fy);
+    readOptional(camera, "cx", cx);
+    readOptional(camera, "cy", cy);
+    readOptional(camera, "subsampling", subsampling);
+    for(const auto& x : sim["scene"]){
+      Item item;
+      x["name"] >> item.name;
+      item.pose=readPose(x["pose"]);
+      scene.push_back(item);
+    }
+  }
+
+  const Params& Params::get(){
+    static const Params instance;
+    return instance;
+  }
+}
@@ -0,0 +1,182 @@
+#include <algorithm>
+#include <functional>
+#include <iostream>
+#include <limits>
+#include <stdexcept>
+#include <opencv2/imgproc/imgproc.hpp>
+#include <APC/Shelf.h>
+#include <Gripper/Cuboid.h>
+#include <Gripper/Object.h>
+#include <Sim/Clock.h>
+#include <Sim/Params.h>
+#include <Sim/SimulatedProvider.h>
+#include <Sim/Timeline.h>
+#include <Sim/World.h>
+#include <Utils/CvStorage.h>
+
+namespace Sim{
+  namespace{
+    const char* const CAMERA="camera";
+
+    /** Farthest thing the camera sees [m], and how close to a surface a ray stops */
+    const double MAX_RANGE=4.0;
+    const double HIT_DISTANCE=0.001;
+    const int MAX_STEPS=128;
+
+    const cv::Vec3b SHELF_COLOR(40, 90, 160);
+
+    Eigen::Affine3d mount(){
+      Eigen::Matrix3d axes;
+      /** Columns are the axes of the camera in the tool frame */
+      axes << 0,  0, 1,
+             -1,  0, 0,
+              0, -1, 0;
+      Eigen::Affine3d result=Eigen::Affine3d::Identity();
+      result.linear()=axes;
+      return result;
+    }
+
+    Gripper::Shape::Ptr box(const Eigen::Vector3d& min, const Eigen::Vector3d& max){
+      Eigen::Vector3d size=max-min;
+      return Gripper::Shape::Ptr(new Gripper::Cuboid(Eigen::Affine3d(Eigen::Translation3d(min)), size[0], size[1], size[2]));
+    }
+
+    /** Part [near, far] of the ray inside the box, if any */
+    bool clipRay(const Eigen::AlignedBox3d& box, const Eigen::Vector3d& origin, const Eigen::Vector3d& direction, double& near, double& far){
+      near=0;
+      far=MAX_RANGE;
+      for(int i=0; i<3; ++i){
+        if(std::abs(direction[i])<1e-12){
+          if(origin[i]<box.min()[i] || origin[i]>box.max()[i]){
+            return false;
+          }
+          continue;
+        }
+        double t1=(box.min()[i]-origin[i])/direction[i], t2=(box.max()[i]-origin[i])/direction[i];
+        near=std::max(near, std::min(t1, t2));
+        far=std::min(far, std::max(t1, t2));
+      }
+      return near<=far;
+    }
+
+    /** Stable color for each object */
+    cv::Vec3b colorOf(const std::string& name){
+      size_t h=std::hash<std::string>()(name);
+      return cv::Vec3b(64+h%192, 64+(h/192)%192, 64+(h/(192*192))%192);
+    }
+  }
+
+  const Eigen::Affine3d SimulatedProvider::MOUNT=mount();
+
+  SimulatedProvider::SimulatedProvider(const std::string& objectsFile, const std::string& ID)
+    :
+      ImageProvider(ID)
+  {
+    cv::FileStorage objectsStorage(objectsFile, cv::FileStorage::READ);
+    if(!objectsStorage.isOpened()){
+      throw std::runtime_error("Couldn't open the objects' database "+objectsFile);
+    }
+    objectsStorage["objects"] >> _objects;
+
+    /** Walls of each bin, as in APC::BinFields (the ones between two bins are there twice, which doesn't matter) */
+    const double t=APC::Shelf::WALL_THICKNESS;
+    for(unsigned int row=0; row<APC::Shelf::HEIGHT; ++row){
+      for(unsigned int column=0; column<APC::Shelf::WIDTH; ++column){
+        const Eigen::AlignedBox3d bin=APC::Shelf::getBinBounds(row, column);
+        const Eigen::Vector3d& lo=bin.min();
+        const Eigen::Vector3d& hi=bin.max();
+        for(const auto& wall : {
+            box({lo[0], lo[1]-t, lo[2]-t}, {hi[0]+t, hi[1]+t, lo[2]}),
+            box({lo[0], lo[1]-t, hi[2]}, {hi[0]+t, hi[1]+t, hi[2]+t}),
+            box({lo[0], lo[1]-t, lo[2]}, {hi[0]+t, lo[1], hi[2]}),
+            box({lo[0], hi[1], lo[2]}, {hi[0]+t, hi[1]+t, hi[2]}),
+            box({hi[0], lo[1], lo[2]}, {hi[0]+t, hi[1], hi[2]})}){
+          _shelf.push_back(Solid{wall, wall->getBounds(), SHELF_COLOR});
+        }
+      }
+    }
+  }
+
+  void SimulatedProvider::castRay(const Eigen::Vector3d& origin, const Eigen::Vector3d& direction, double zScale, const std::vector<Solid>& solids, float& depth, cv::Vec3b& color) const {
+    depth=0;
+    color=cv::Vec3b(0, 0, 0);
+
+    /** Only the solids whose bounds are crossed by the ray are traced */
+    std::vector<const Solid*> crossed;
+    double start=MAX_RANGE, end=0;
+    for(const auto& s : solids){
+      double near, far;
+      if(clipRay(s.bounds, origin, direction, near, far)){
+        crossed.push_back(&s);
+        start=std::min(start, near);
+        end=std::max(end, far);
+      }
+    }
+
+    double t=start;
+    for(int step=0; step<MAX_STEPS && t<=end+HIT_DISTANCE && !crossed.empty(); ++step){
+      const Eigen::Vector3d p=origin+t*direction;
+      double nearest=std::numeric_limits<double>::infinity();
+      const Solid* hit=nullptr;
+      for(const Solid* s : crossed){
+        double d=s->shape->getSignedDistance(p);
+        if(d<nearest){
+          nearest=d;
+          hit=s;
+        }
+      }
+      if(nearest<HIT_DISTANCE){
+        depth=t*zScale;
+        /** Farther surfaces are darker */
+        color=hit->color*(1.0-0.5*t/MAX_RANGE);
+        return;
+      }
+      t+=nearest;
+    }
+  }
+
+  Img::Image SimulatedProvider::getFrame() const {
+    std::cout << "I'm taking a (simulated) photo\n";
+    const Params& params=Params::get();
+    const double end=Timeline::getInstance().reserve(CAMERA, Clock::now(), params.photoTime);
+
+    Image::Matrix depth(Image::ALLOWED_HEIGHT, Image::ALLOWED_WIDTH, CV_32F), rgb(Image::ALLOWED_HEIGHT, Image::ALLOWED_WIDTH, CV_8UC3);
+    {
+      /** Rendering is only needed by the simulation */
+      Clock::Excluded rendering;
+
+      std::vector<Solid> solids=_shelf;
+      for(const auto& x : World::getInstance().getItems()){
+        auto o=_objects.find(x.name);
+        if(o==_objects.end()){
+          std::cerr << "No model for " << x.name << ", it won't be rendered\n";
+          continue;
+        }
+        Gripper::Shape::Ptr shape=x.pose*o->second.myShape;
+        solids.push_back(Solid{shape, shape->getBounds(), colorOf(x.name)});
+      }
+
+      const Eigen::Affine3d camera=World::getInstance().getArmPose()*MOUNT;
+      const int step=std::max(1, params.subsampling);
+      const int rows=(Image::ALLOWED_HEIGHT+step-1)/step, cols=(Image::ALLOWED_WIDTH+step-1)/step;
+      cv::Mat_<float> smallDepth(rows, cols);
+      cv::Mat_<cv::Vec3b> smallRgb(rows, cols);
+      for(int r=0; r<rows; ++r){
+        for(int c=0; c<cols; ++c){
+          /** Ray through the center of the block, in the camera frame with z=1 */
+          Eigen::Vector3d ray(((c+0.5)*step-0.5-params.cx)/params.fx, ((r+0.5)*step-0.5-params.cy)/params.fy, 1);
+          double norm=ray.norm();
+          castRay(camera.translation(), camera.linear()*ray/norm, 1.0/norm, solids, smallDepth(r, c), smallRgb(r, c));
+        }
+      }
+      cv::Mat depthFull, rgbFull;
+      cv::resize(smallDepth, depthFull, cv::Size(cols*step, rows*step), 0, 0, cv::INTER_NEAREST);
+      cv::resize(smallRgb, rgbFull, cv::Size(cols*step, rows*step), 0, 0, cv::INTER_NEAREST);
+      depthFull(cv::Rect(0, 0, Image::ALLOWED_WIDTH, Image::ALLOWED_HEIGHT)).copyTo(depth);
+      rgbFull(cv::Rect(0, 0, Image::ALLOWED_WIDTH, Image::ALLOWED_HEIGHT)).copyTo(rgb);
+    }
+
+    Clock::waitUntil(end, CAMERA);
+    return Image(depth, rgb);
+  }
+}
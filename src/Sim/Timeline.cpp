@@ -0,0 +1,89 @@
+#include <algorithm>
+#include <iomanip>
+#include <Sim/Clock.h>
+#include <Sim/Timeline.h>
+
+namespace Sim{
+  Timeline::Timeline()
+  {
+  }
+
+  Timeline& Timeline::getInstance(){
+    static Timeline instance;
+    return instance;
+  }
+
+  double Timeline::reserve(const std::string& resource, double earliest, double duration){
+    std::lock_guard<std::mutex> lock(_mutex);
+    double& free=_free[resource];
+    const double start=std::max(earliest, free);
+    free=start+duration;
+    if(Clock::isVirtual()){
+      _busy[resource].push_back(std::make_pair(start, free));
+    }
+    return free;
+  }
+
+  double Timeline::busyUntil(const std::string& resource) const {
+    std::lock_guard<std::mutex> lock(_mutex);
+    auto x=_free.find(resource);
+    return x==_free.end() ? 0 : x->second;
+  }
+
+  void Timeline::record(const std::string& resource, double start, double end){
+    if(!Clock::isVirtual()){
+      return;
+    }
+    std::lock_guard<std::mutex> lock(_mutex);
+    _busy[resource].push_back(std::make_pair(start, end));
+  }
+
+  void Timeline::charge(const std::string& what, double time){
+    if(!Clock::isVirtual()){
+      return;
+    }
+    std::lock_guard<std::mutex> lock(_mutex);
+    _waits[std::this_thread::get_id()][what]+=time;
+  }
+
+  double Timeline::busyTime(Intervals intervals, double end){
+    std::sort(intervals.begin(), intervals.end());
+    double total=0, covered=0;
+    for(const auto& x : intervals){
+      double from=std::max(x.first, covered), to=std::min(x.second, end);
+      if(to>from){
+        total+=to-from;
+        covered=to;
+      }
+    }
+    return total;
+  }
+
+  void Timeline::report(std::ostream& os, int picks) const {
+    const double end=Clock::now();
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    const std::ios::fmtflags flags=os.flags();
+    const std::streamsize precision=os.precision();
+    os << std::fixed << std::setprecision(1);
+    os << "Simulated run: " << end << " s, " << picks << " picks, " << picks*3600/end << " picks/hour\n";
+    os << "Resource usage (busy / idle):\n";
+    for(const auto& x : _busy){
+      double busy=busyTime(x.second, end);
+      os << "  " << std::setw(12) << std::left << x.first << std::right << " " << busy << " s / " << end-busy << " s (" << 100*busy/end << "% busy)\n";
+    }
+
+    os << "Critical path:\n";
+    double waiting=0;
+    auto waits=_waits.find(std::this_thread::get_id());
+    if(waits!=_waits.end()){
+      for(const auto& x : waits->second){
+        os << "  waiting for " << std::setw(12) << std::left << x.first << std::right << " " << x.second << " s (" << 100*x.second/end << "%)\n";
+        waiting+=x.second;
+      }
+    }
+    os << "  computing    " << std::setw(12) << "" << " " << end-waiting << " s (" << 100*(end-waiting)/end << "%)\n";
+    os.flags(flags);
+    os.precision(precision);
+  }
+}
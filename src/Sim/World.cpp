@@ -0,0 +1,49 @@
+#include <Sim/World.h>
+
+namespace Sim{
+  World::World()
+    :
+      _arm(Eigen::Affine3d::Identity()),
+      _items(Params::get().scene)
+  {
+  }
+
+  World& World::getInstance(){
+    static World instance;
+    return instance;
+  }
+
+  void World::setArmPose(const Eigen::Affine3d& pose){
+    std::lock_guard<std::mutex> lock(_mutex);
+    _arm=pose;
+  }
+
+  Eigen::Affine3d World::getArmPose() const {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _arm;
+  }
+
+  std::vector<Item> World::getItems() const {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _items;
+  }
+
+  std::string World::grab(double reach){
+    std::lock_guard<std::mutex> lock(_mutex);
+    auto nearest=_items.end();
+    double best=reach;
+    for(auto x=_items.begin(); x!=_items.end(); ++x){
+      double d=(x->pose.translation()-_arm.translation()).norm();
+      if(d<=best){
+        best=d;
+        nearest=x;
+      }
+    }
+    if(nearest==_items.end()){
+      return "";
+    }
+    std::string name=nearest->name;
+    _items.erase(nearest);
+    return name;
+  }
+}